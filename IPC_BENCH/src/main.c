@@ -0,0 +1,451 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/ring_buffer.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/timing/timing.h>
+#include <string.h>
+//IPC-mittaus: LIIKENNEVALOT-firmwaren viestipolut eri kernel-primitiiveillä
+//  west build -b native_sim IPC_BENCH   /   west build -b qemu_cortex_m3 IPC_BENCH
+//  west build -b qemu_x86_64 IPC_BENCH  (2 CPU:ta: lisäksi ydinsijoittelu, boards/qemu_x86_64.conf)
+
+//Mittausparametrit
+#define N_MSGS      1000
+#define DEPTH       16          // jonon syvyys, 2^n (SPSC-rengas)
+#define STACKSIZE   1024
+
+//Viesti = meas_item + lähetysaika (seq_item on tämän osajoukko)
+struct bench_msg {
+    void *fifo_reserved;
+    char value;        /* 'R','Y','G' */
+    uint64_t usec;
+    timing_t t_put;
+};
+
+static const char colors[3] = { 'R', 'Y', 'G' };
+
+//Tulokset: latenssit kirjoittaa vain kuluttaja, alloc_fails vain tuottaja;
+//main lukee molemmat vasta joinin jälkeen
+static uint64_t lat_min, lat_max, lat_sum;
+static uint32_t lat_n;
+static uint32_t alloc_fails;
+
+static void lat_reset(void) {
+    lat_min = UINT64_MAX; lat_max = 0; lat_sum = 0; lat_n = 0;
+    alloc_fails = 0;
+}
+
+static inline void lat_record(timing_t t_put) {
+    timing_t now = timing_counter_get();
+    uint64_t c = timing_cycles_get(&t_put, &now);
+    if (c < lat_min) lat_min = c;
+    if (c > lat_max) lat_max = c;
+    lat_sum += c;
+    lat_n++;
+}
+
+static inline void msg_fill(struct bench_msg *m, int i) {
+    m->value = colors[i % 3];
+    m->usec  = (uint64_t)i;
+    m->t_put = timing_counter_get();
+}
+
+//Rajoittamattomille jonoille yhteinen tilasemafori -> sama syvyys kaikille
+K_SEM_DEFINE(space_sem, DEPTH, DEPTH);
+K_SEM_DEFINE(data_sem, 0, DEPTH);
+
+// 1) k_fifo + k_malloc (nykyinen seq_fifo/meas_fifo)
+K_FIFO_DEFINE(bm_fifo);
+
+static void fifo_malloc_prod(int n) {
+    for (int i = 0; i < n; ++i) {
+        k_sem_take(&space_sem, K_FOREVER);
+        struct bench_msg *m = k_malloc(sizeof(*m));
+        while (!m) {                 // firmwaressa tämä olisi pudotus
+            alloc_fails++;
+            k_sleep(K_TICKS(1));
+            m = k_malloc(sizeof(*m));
+        }
+        msg_fill(m, i);
+        k_fifo_put(&bm_fifo, m);
+    }
+}
+static void fifo_malloc_cons(int n) {
+    for (int i = 0; i < n; ++i) {
+        struct bench_msg *m = k_fifo_get(&bm_fifo, K_FOREVER);
+        lat_record(m->t_put);
+        k_free(m);
+        k_sem_give(&space_sem);
+    }
+}
+
+// 2) k_fifo + mem slab
+K_MEM_SLAB_DEFINE(bm_slab, sizeof(struct bench_msg), DEPTH, 8);
+
+static void fifo_slab_prod(int n) {
+    for (int i = 0; i < n; ++i) {
+        struct bench_msg *m;
+        k_mem_slab_alloc(&bm_slab, (void **)&m, K_FOREVER);   // slab rajoittaa syvyyden
+        msg_fill(m, i);
+        k_fifo_put(&bm_fifo, m);
+    }
+}
+static void fifo_slab_cons(int n) {
+    for (int i = 0; i < n; ++i) {
+        struct bench_msg *m = k_fifo_get(&bm_fifo, K_FOREVER);
+        lat_record(m->t_put);
+        k_mem_slab_free(&bm_slab, m);
+    }
+}
+
+// 3) k_msgq (kopio, ei allokointia)
+K_MSGQ_DEFINE(bm_msgq, sizeof(struct bench_msg), DEPTH, 8);
+
+static void msgq_prod(int n) {
+    struct bench_msg m;
+    for (int i = 0; i < n; ++i) {
+        msg_fill(&m, i);
+        k_msgq_put(&bm_msgq, &m, K_FOREVER);
+    }
+}
+static void msgq_cons(int n) {
+    struct bench_msg m;
+    for (int i = 0; i < n; ++i) {
+        k_msgq_get(&bm_msgq, &m, K_FOREVER);
+        lat_record(m.t_put);
+    }
+}
+
+// 4) ring_buf + spinlock, herätys semaforilla
+RING_BUF_DECLARE(bm_ring, DEPTH * sizeof(struct bench_msg));
+static struct k_spinlock ring_lock;
+
+static void ring_prod(int n) {
+    struct bench_msg m;
+    for (int i = 0; i < n; ++i) {
+        k_sem_take(&space_sem, K_FOREVER);
+        msg_fill(&m, i);
+        k_spinlock_key_t key = k_spin_lock(&ring_lock);
+        ring_buf_put(&bm_ring, (uint8_t *)&m, sizeof(m));
+        k_spin_unlock(&ring_lock, key);
+        k_sem_give(&data_sem);
+    }
+}
+static void ring_cons(int n) {
+    struct bench_msg m;
+    for (int i = 0; i < n; ++i) {
+        k_sem_take(&data_sem, K_FOREVER);
+        k_spinlock_key_t key = k_spin_lock(&ring_lock);
+        ring_buf_get(&bm_ring, (uint8_t *)&m, sizeof(m));
+        k_spin_unlock(&ring_lock, key);
+        lat_record(m.t_put);
+        k_sem_give(&space_sem);
+    }
+}
+
+// 5) k_event: väri bittinä, syvyys 1 (bitit yhdistyisivät)
+K_EVENT_DEFINE(bm_event);
+K_SEM_DEFINE(ev_credit, 1, 1);
+static timing_t ev_stamp;
+
+static void event_prod(int n) {
+    for (int i = 0; i < n; ++i) {
+        k_sem_take(&ev_credit, K_FOREVER);
+        ev_stamp = timing_counter_get();
+        k_event_post(&bm_event, BIT(i % 3));
+    }
+}
+static void event_cons(int n) {
+    for (int i = 0; i < n; ++i) {
+        uint32_t got = k_event_wait(&bm_event, BIT(0) | BIT(1) | BIT(2), false, K_FOREVER);
+        lat_record(ev_stamp);
+        k_event_clear(&bm_event, got);
+        k_sem_give(&ev_credit);
+    }
+}
+
+// 6) k_poll k_fifo:lle (slab-solmut), kuten monijonoinen dispatcher
+static void poll_cons(int n) {
+    struct k_poll_event ev = K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_FIFO_DATA_AVAILABLE,
+                                                      K_POLL_MODE_NOTIFY_ONLY, &bm_fifo);
+    for (int i = 0; i < n; ++i) {
+        struct bench_msg *m;
+        while ((m = k_fifo_get(&bm_fifo, K_NO_WAIT)) == NULL) {
+            ev.state = K_POLL_STATE_NOT_READY;
+            k_poll(&ev, 1, K_FOREVER);
+        }
+        lat_record(m->t_put);
+        k_mem_slab_free(&bm_slab, m);
+    }
+}
+
+// 7) SPSC-rengas, odotus ja herätys semaforeilla (data ohi kernelin, tila ei)
+static struct bench_msg spsc_buf[DEPTH];
+static atomic_t spsc_head;   // kirjoittaa vain tuottaja
+static atomic_t spsc_tail;   // kirjoittaa vain kuluttaja
+
+BUILD_ASSERT((DEPTH & (DEPTH - 1)) == 0, "DEPTH must be a power of two");
+
+static void spsc_prod(int n) {
+    for (int i = 0; i < n; ++i) {
+        k_sem_take(&space_sem, K_FOREVER);
+        atomic_val_t h = atomic_get(&spsc_head);
+        msg_fill(&spsc_buf[h & (DEPTH - 1)], i);
+        atomic_set(&spsc_head, h + 1);
+        k_sem_give(&data_sem);
+    }
+}
+static void spsc_cons(int n) {
+    for (int i = 0; i < n; ++i) {
+        k_sem_take(&data_sem, K_FOREVER);
+        atomic_val_t t = atomic_get(&spsc_tail);
+        lat_record(spsc_buf[t & (DEPTH - 1)].t_put);
+        atomic_set(&spsc_tail, t + 1);
+        k_sem_give(&space_sem);
+    }
+}
+
+// 8) nykyinen dispatcher -> LED kättely: mutex + condvar + release_sem
+K_MUTEX_DEFINE(cv_mutex);
+K_CONDVAR_DEFINE(cv_cv);
+K_SEM_DEFINE(cv_release, 0, 1);
+static bool cv_trig;            // vain cv_mutexin alla
+static timing_t cv_stamp;
+
+static void condvar_prod(int n) {
+    for (int i = 0; i < n; ++i) {
+        k_mutex_lock(&cv_mutex, K_FOREVER);
+        cv_stamp = timing_counter_get();
+        cv_trig = true;
+        k_condvar_signal(&cv_cv);
+        k_mutex_unlock(&cv_mutex);
+        k_sem_take(&cv_release, K_FOREVER);
+    }
+}
+static void condvar_cons(int n) {
+    for (int i = 0; i < n; ++i) {
+        k_mutex_lock(&cv_mutex, K_FOREVER);
+        while (!cv_trig) {
+            k_condvar_wait(&cv_cv, &cv_mutex, K_FOREVER);
+        }
+        cv_trig = false;
+        k_mutex_unlock(&cv_mutex);
+        lat_record(cv_stamp);
+        k_sem_give(&cv_release);
+    }
+}
+
+// 9) lukoton SPSC-rengas: indeksit pollataan, ei kernel-objekteja.
+// k_yield antaa vuoron vain saman tai korkeamman prioriteetin säikeelle, joten
+// SPSC_SPINS tyhjän kierroksen jälkeen nukutaan tikki (P4/C5: muuten tuottaja
+// pyörisi yhdellä CPU:lla eikä kuluttaja pääsisi ajoon).
+#define SPSC_SPINS 8
+
+static inline void spsc_backoff(int *spins) {
+    if (++*spins < SPSC_SPINS) {
+        k_yield();
+    } else {
+        *spins = 0;
+        k_sleep(K_TICKS(1));
+    }
+}
+
+static void spsc_poll_prod(int n) {
+    for (int i = 0; i < n; ++i) {
+        atomic_val_t h = atomic_get(&spsc_head);
+        int spins = 0;
+        while (h - atomic_get(&spsc_tail) >= DEPTH) spsc_backoff(&spins);
+        msg_fill(&spsc_buf[h & (DEPTH - 1)], i);
+        atomic_set(&spsc_head, h + 1);     // julkaisu: viesti kirjoitettu ensin
+    }
+}
+static void spsc_poll_cons(int n) {
+    for (int i = 0; i < n; ++i) {
+        atomic_val_t t = atomic_get(&spsc_tail);
+        int spins = 0;
+        while (atomic_get(&spsc_head) == t) spsc_backoff(&spins);
+        lat_record(spsc_buf[t & (DEPTH - 1)].t_put);
+        atomic_set(&spsc_tail, t + 1);     // paikka vapaaksi vasta luvun jälkeen
+    }
+}
+
+struct method {
+    const char *name;
+    void (*prod)(int n);
+    void (*cons)(int n);
+};
+
+static const struct method methods[] = {
+    { "fifo+malloc", fifo_malloc_prod, fifo_malloc_cons },
+    { "fifo+slab",   fifo_slab_prod,   fifo_slab_cons   },
+    { "msgq",        msgq_prod,        msgq_cons        },
+    { "ring_buf",    ring_prod,        ring_cons        },
+    { "event",       event_prod,       event_cons       },
+    { "poll+fifo",   fifo_slab_prod,   poll_cons        },
+    { "spsc+sem",    spsc_prod,        spsc_cons        },
+    { "condvar",     condvar_prod,     condvar_cons     },
+    { "spsc+yield",  spsc_poll_prod,   spsc_poll_cons   },
+};
+
+//Tuottaja/kuluttaja-prioriteetit (pienempi = korkeampi)
+static const struct { int prod; int cons; } prios[] = {
+    { 5, 5 },   // kuten firmwaressa nyt
+    { 4, 5 },   // tuottaja korkeampi
+    { 5, 4 },   // kuluttaja korkeampi
+};
+
+K_THREAD_STACK_DEFINE(prod_stack, STACKSIZE);
+K_THREAD_STACK_DEFINE(cons_stack, STACKSIZE);
+static struct k_thread prod_thread;
+static struct k_thread cons_thread;
+
+#if defined(CONFIG_SMP) && defined(CONFIG_SCHED_CPU_MASK) && CONFIG_MP_MAX_NUM_CPUS > 1
+#define BENCH_SMP 1
+#endif
+
+#if BENCH_SMP
+// Ydinsijoittelu: tuottaja = syöte (uart_task / workqueue), kuluttaja = valot
+// (dispatcher / LED-taski). Firmwaren LV_SMP_PIN vastaa riviä 0/1.
+struct placement {
+    const char *name;
+    int prod_cpu;
+    int cons_cpu;
+};
+static const struct placement placements[] = {
+    { "0/0", 0, 0 },    // yksi ydin, kuten ennen
+    { "0/1", 0, 1 },    // syöte ja valot eri ytimillä
+};
+static const struct method *const smp_methods[] = {
+    &methods[1], &methods[5], &methods[6], &methods[7], &methods[8],
+    // fifo+slab, poll+fifo, spsc+sem, condvar, spsc+yield
+};
+
+// Syötekuorma: UART-purskeen jäsennys, samalla prioriteetilla syöteytimellä
+#define LOAD_SPIN_US 200
+K_THREAD_STACK_DEFINE(load_stack, STACKSIZE);
+static struct k_thread load_thread;
+static atomic_t load_stop;
+
+static void load_entry(void *a, void *b, void *c) {
+    ARG_UNUSED(a); ARG_UNUSED(b); ARG_UNUSED(c);
+    while (!atomic_get(&load_stop)) {
+        k_busy_wait(LOAD_SPIN_US);
+        k_yield();
+    }
+}
+#endif
+
+static void prod_entry(void *a, void *b, void *c) {
+    ARG_UNUSED(b); ARG_UNUSED(c);
+    ((const struct method *)a)->prod(N_MSGS);
+}
+static void cons_entry(void *a, void *b, void *c) {
+    ARG_UNUSED(b); ARG_UNUSED(c);
+    ((const struct method *)a)->cons(N_MSGS);
+}
+
+static void bench_reset(void) {
+    k_sem_reset(&space_sem);
+    for (int i = 0; i < DEPTH; ++i) k_sem_give(&space_sem);
+    k_sem_reset(&data_sem);
+    k_sem_reset(&ev_credit);
+    k_sem_give(&ev_credit);
+    k_sem_reset(&cv_release);
+    k_event_clear(&bm_event, 0xFFFFFFFF);
+    k_msgq_purge(&bm_msgq);
+    ring_buf_reset(&bm_ring);
+    atomic_set(&spsc_head, 0);
+    atomic_set(&spsc_tail, 0);
+    cv_trig = false;
+    lat_reset();
+}
+
+// pl: ydinsijoittelu (NULL = skeduleri valitsee), load: syötekuorma tuottajan ytimelle
+static void run(const struct method *m, int prod_prio, int cons_prio, const void *pl, bool load) {
+    bench_reset();
+
+    k_tid_t ct = k_thread_create(&cons_thread, cons_stack, K_THREAD_STACK_SIZEOF(cons_stack),
+                                 cons_entry, (void *)m, NULL, NULL, cons_prio, 0, K_FOREVER);
+    k_tid_t pt = k_thread_create(&prod_thread, prod_stack, K_THREAD_STACK_SIZEOF(prod_stack),
+                                 prod_entry, (void *)m, NULL, NULL, prod_prio, 0, K_FOREVER);
+#if BENCH_SMP
+    const struct placement *p = pl;
+    if (p) {
+        k_thread_cpu_pin(ct, p->cons_cpu);
+        k_thread_cpu_pin(pt, p->prod_cpu);
+    }
+    if (load) {
+        atomic_set(&load_stop, 0);
+        k_tid_t lt = k_thread_create(&load_thread, load_stack, K_THREAD_STACK_SIZEOF(load_stack),
+                                     load_entry, NULL, NULL, NULL, cons_prio, 0, K_FOREVER);
+        k_thread_cpu_pin(lt, p ? p->prod_cpu : 0);
+        k_thread_start(lt);
+    }
+#else
+    ARG_UNUSED(pl);
+    ARG_UNUSED(load);
+#endif
+    k_thread_start(ct);
+    k_thread_start(pt);
+
+    // main on korkeammalla prioriteetilla: säikeet alkavat vasta joinissa
+    timing_t t0 = timing_counter_get();
+    k_thread_join(&prod_thread, K_FOREVER);
+    k_thread_join(&cons_thread, K_FOREVER);
+    timing_t t1 = timing_counter_get();
+#if BENCH_SMP
+    if (load) {
+        atomic_set(&load_stop, 1);
+        k_thread_join(&load_thread, K_FOREVER);
+    }
+    const char *cpu = p ? p->name : "-";
+#else
+    const char *cpu = "-";
+#endif
+
+    uint64_t total = timing_cycles_get(&t0, &t1);
+    uint64_t avg   = lat_n ? lat_sum / lat_n : 0;
+
+    printk("%-12s P%d/C%d %-3s %-4s %8llu %8llu %8llu %8llu %8llu %5u\n",
+           m->name, prod_prio, cons_prio, cpu, load ? "load" : "-",
+           (unsigned long long)(total / N_MSGS),
+           (unsigned long long)lat_min,
+           (unsigned long long)avg,
+           (unsigned long long)lat_max,
+           (unsigned long long)timing_cycles_to_ns(avg),
+           alloc_fails);
+}
+
+int main(void)
+{
+    timing_init();
+    timing_start();
+
+    k_sleep(K_MSEC(100));
+    printk("IPC bench: %d msgs, depth %d, %u cycles/s\n",
+           N_MSGS, DEPTH, (unsigned)timing_freq_get());
+    printk("%-12s %-5s %-3s %-4s %8s %8s %8s %8s %8s %5s\n",
+           "method", "prio", "cpu", "load", "cyc/msg", "lat_min", "lat_avg", "lat_max", "avg_ns", "fails");
+
+    for (size_t p = 0; p < ARRAY_SIZE(prios); ++p) {
+        for (size_t i = 0; i < ARRAY_SIZE(methods); ++i) {
+            run(&methods[i], prios[p].prod, prios[p].cons, NULL, false);
+        }
+    }
+
+#if BENCH_SMP
+    // Ristiinydin: sama vs. eri ydin, syötekuorman kanssa ja ilman.
+    // Latenssin ero load-riveillä = mitä LV_SMP_PIN voittaa valojen ajoitukselle.
+    printk("SMP: %u CPUs, load %d us spin + yield on producer CPU\n", arch_num_cpus(), LOAD_SPIN_US);
+    for (int load = 0; load < 2; ++load) {
+        for (size_t c = 0; c < ARRAY_SIZE(placements); ++c) {
+            for (size_t i = 0; i < ARRAY_SIZE(smp_methods); ++i) {
+                run(smp_methods[i], 5, 5, &placements[c], load);
+            }
+        }
+    }
+#endif
+
+    timing_stop();
+    printk("IPC bench done\n");
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+#include "bootprof.h"
+#include "trace.h"
+
+static uint32_t boot_cyc[BOOT_STAGE_COUNT];
+static int16_t  boot_err[BOOT_STAGE_COUNT];
+static atomic_t boot_seen;
+
+static const char *const boot_names[BOOT_STAGE_COUNT] = {
+    [BOOT_MAIN]        = "main",
+    [BOOT_TIMING]      = "timing",
+    [BOOT_LED]         = "led",
+    [BOOT_LED_THREADS] = "led_threads",
+    [BOOT_RESTORE]     = "restore",
+    [BOOT_UART]        = "uart",
+    [BOOT_UART_THREAD] = "uart_thread",
+    [BOOT_BUTTONS]     = "buttons",
+    [BOOT_READY]       = "ready",
+    [BOOT_FIRST_LIGHT] = "first_light",
+};
+
+void boot_mark(enum boot_stage st, int err) {
+    uint32_t now = k_cycle_get_32();
+    if (atomic_test_and_set_bit(&boot_seen, st)) return;
+    boot_cyc[st] = now;
+    boot_err[st] = (int16_t)err;
+    TRACE_EV("boot", st, k_cyc_to_us_floor32(now));
+}
+
+uint32_t boot_us(enum boot_stage st) {
+    return atomic_test_bit(&boot_seen, st) ? k_cyc_to_us_floor32(boot_cyc[st]) : 0;
+}
+
+void boot_report(void) {
+    printk("--- Boot (us since kernel start) ---\n");
+    // Kirjatut aikaleiman mukaan (tasapeli: enum-järjestys), jotta delta on
+    // aina edellisestä todellisesta vaiheesta
+    uint8_t ord[BOOT_STAGE_COUNT];
+    int n = 0;
+    for (int i = 0; i < BOOT_STAGE_COUNT; ++i) {
+        if (i == BOOT_FIRST_LIGHT || !atomic_test_bit(&boot_seen, i)) continue;
+        int k = n++;
+        while (k > 0 && (int32_t)(boot_cyc[ord[k - 1]] - boot_cyc[i]) > 0) {
+            ord[k] = ord[k - 1];
+            k--;
+        }
+        ord[k] = (uint8_t)i;
+    }
+    uint32_t prev = 0;
+    for (int j = 0; j < n; ++j) {
+        int i = ord[j];
+        uint32_t us = k_cyc_to_us_floor32(boot_cyc[i]);
+        if (boot_err[i]) printk("%-12s %8u  +%u  FAILED (%d)\n", boot_names[i], us, us - prev, boot_err[i]);
+        else             printk("%-12s %8u  +%u\n", boot_names[i], us, us - prev);
+        prev = us;
+    }
+    for (int i = 0; i < BOOT_FIRST_LIGHT; ++i) {
+        if (!atomic_test_bit(&boot_seen, i)) printk("%-12s        -\n", boot_names[i]);
+    }
+    // first_light voi tulla milloin vain: ei delta-saraketta
+    if (atomic_test_bit(&boot_seen, BOOT_FIRST_LIGHT)) {
+        printk("%-12s %8u\n", boot_names[BOOT_FIRST_LIGHT], k_cyc_to_us_floor32(boot_cyc[BOOT_FIRST_LIGHT]));
+    } else {
+        printk("%-12s        -\n", boot_names[BOOT_FIRST_LIGHT]);
+    }
+}
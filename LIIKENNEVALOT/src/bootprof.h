@@ -0,0 +1,31 @@
+#ifndef BOOTPROF_H
+#define BOOTPROF_H
+
+#include <stdint.h>
+
+// Käynnistyksen vaiheiden aikaleimat (µs ytimen käynnistyksestä, syklilaskuri).
+// Enum suoritusjärjestyksessä; raportti kuitenkin aikaleiman mukaan, koska
+// säikeiden vaiheet voivat lomittua mainin kanssa. Jokainen vaihe kirjataan
+// vain ensimmäisellä kerralla. Ennen ydintä
+// kulunut aika (bootloader, PRE_KERNEL) ei näy.
+
+enum boot_stage {
+    BOOT_MAIN,          // main() alkoi
+    BOOT_TIMING,        // ajastimet, timing, moduulien init
+    BOOT_LED,           // init_led
+    BOOT_LED_THREADS,   // LED-taskit + dispatcher käynnissä
+    BOOT_RESTORE,       // retain / flash-suunnitelma
+    BOOT_UART,          // init_uart
+    BOOT_UART_THREAD,
+    BOOT_BUTTONS,       // inputs_start
+    BOOT_READY,         // uart_task palvelee komentoja (voi ohittaa BUTTONSin)
+    BOOT_FIRST_LIGHT,   // ensimmäinen ohjattu valo päälle
+    BOOT_STAGE_COUNT
+};
+
+// err != 0: vaihe epäonnistui (näkyy raportissa)
+void boot_mark(enum boot_stage st, int err);
+uint32_t boot_us(enum boot_stage st);     // 0 = ei vielä
+void boot_report(void);
+
+#endif
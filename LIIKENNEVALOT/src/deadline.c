@@ -0,0 +1,122 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#include "deadline.h"
+
+#define DL_WORST_N 4
+
+#if defined(CONFIG_LV_DEADLINE_ALERT)
+K_EVENT_DEFINE(deadline_evt);
+#endif
+
+struct dl_worst {
+    uint32_t us;
+    uint32_t at_ms;     // uptime ohitushetkellä
+    char col;
+};
+
+struct dl_stats {
+    uint32_t min_us, max_us;     // budjetti
+    uint32_t n, misses;
+    uint32_t peak_us;
+    uint64_t sum_us;
+    struct dl_worst worst[DL_WORST_N];   // laskevassa järjestyksessä
+};
+
+static struct dl_stats dl[DL_STAGE_COUNT];
+static struct k_spinlock dl_lock;
+
+static const char *const dl_names[DL_STAGE_COUNT] = {
+    "input->dispatch", "dispatch->on", "phase",
+};
+
+void deadline_init(uint32_t phase_ms) {
+    dl[DL_INPUT_DISPATCH].max_us = DL_INPUT_DISPATCH_MAX_US;
+    dl[DL_DISPATCH_ON].max_us    = DL_DISPATCH_ON_MAX_US;
+    dl[DL_PHASE].min_us = phase_ms * 1000U - DL_PHASE_TOL_US;
+    dl[DL_PHASE].max_us = phase_ms * 1000U + DL_PHASE_TOL_US;
+}
+
+static void deadline_record(enum dl_stage st, uint32_t us, uint32_t min_us, uint32_t max_us, char col) {
+    struct dl_stats *s = &dl[st];
+    bool miss = (us > max_us) || (us < min_us);
+
+    k_spinlock_key_t key = k_spin_lock(&dl_lock);
+    s->n++;
+    s->sum_us += us;
+    if (us > s->peak_us) s->peak_us = us;
+    if (miss) {
+        s->misses++;
+        // pahimmat: lisäyslajittelu pieneen taulukkoon
+        int i = DL_WORST_N - 1;
+        if (us > s->worst[i].us) {
+            while (i > 0 && s->worst[i - 1].us < us) {
+                s->worst[i] = s->worst[i - 1];
+                i--;
+            }
+            s->worst[i].us    = us;
+            s->worst[i].at_ms = k_uptime_get_32();
+            s->worst[i].col   = col;
+        }
+    }
+    k_spin_unlock(&dl_lock, key);
+
+#if defined(CONFIG_LV_DEADLINE_ALERT)
+    if (miss) k_event_post(&deadline_evt, BIT(st));
+#endif
+}
+
+// µs, kyllästyy 32 bittiin (yli tunnin viive on joka tapauksessa ohitus)
+static uint32_t since_us(uint64_t start) {
+    return (uint32_t)MIN(dl_to_us(dl_stamp() - start), (uint64_t)UINT32_MAX);
+}
+
+void deadline_check(enum dl_stage st, uint64_t start, char col) {
+    uint32_t us = since_us(start);
+    deadline_record(st, us, dl[st].min_us, dl[st].max_us, col);
+}
+
+void deadline_check_len(enum dl_stage st, uint64_t start, uint32_t expect_ms, char col) {
+    uint32_t us = since_us(start);
+    uint32_t exp_us = expect_ms * 1000U;
+    uint32_t lo = exp_us > DL_PHASE_TOL_US ? exp_us - DL_PHASE_TOL_US : 0;
+    deadline_record(st, us, lo, exp_us + DL_PHASE_TOL_US, col);
+}
+
+void deadline_dump(void) {
+    struct dl_stats snap[DL_STAGE_COUNT];
+
+    k_spinlock_key_t key = k_spin_lock(&dl_lock);
+    memcpy(snap, dl, sizeof(snap));
+    k_spin_unlock(&dl_lock, key);
+
+    printk("%-16s %8s %8s %6s %8s %10s\n", "stage", "budget", "avg", "n", "miss", "peak");
+    for (int st = 0; st < DL_STAGE_COUNT; ++st) {
+        struct dl_stats *s = &snap[st];
+        printk("%-16s %8u %8u %6u %8u %10u\n", dl_names[st], s->max_us,
+               s->n ? (uint32_t)(s->sum_us / s->n) : 0U, s->n, s->misses, s->peak_us);
+        for (int i = 0; i < DL_WORST_N && s->worst[i].us; ++i) {
+            printk("  #%d %c %u us @ %u ms\n", i + 1,
+                   s->worst[i].col ? s->worst[i].col : '-', s->worst[i].us, s->worst[i].at_ms);
+        }
+    }
+}
+
+#if defined(CONFIG_LV_DEADLINE_ALERT)
+// Ohitukset konsoliin: kerää saman välin ohitukset yhdeksi riviksi
+static void deadline_alert_task(void *a, void *b, void *c) {
+    ARG_UNUSED(a); ARG_UNUSED(b); ARG_UNUSED(c);
+    while (1) {
+        uint32_t ev = k_event_wait(&deadline_evt, BIT_MASK(DL_STAGE_COUNT), false, K_FOREVER);
+        k_event_clear(&deadline_evt, ev);
+        printk("DEADLINE miss");
+        for (int st = 0; st < DL_STAGE_COUNT; ++st) {
+            if (ev & BIT(st)) printk(" %s", dl_names[st]);
+        }
+        printk("\n");
+    }
+}
+
+K_THREAD_DEFINE(deadline_alert, 768, deadline_alert_task, NULL, NULL, NULL,
+                K_LOWEST_APPLICATION_THREAD_PRIO, 0, 0);
+#endif
@@ -0,0 +1,38 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <zephyr/kernel.h>
+
+// Vaiheiden aikabudjetit, tarkistetaan jokaisesta tapahtumasta (dl_stamp)
+enum dl_stage {
+    DL_INPUT_DISPATCH,  // syöte (ISR/UART/ajastin) -> dispatcher otti jonosta
+    DL_DISPATCH_ON,     // dispatcher herätti LEDin -> GPIO päällä
+    DL_PHASE,           // GPIO päällä -> pois (LIGHT_MS)
+    DL_STAGE_COUNT
+};
+
+// Budjetit mikrosekunteina (min, max)
+#define DL_INPUT_DISPATCH_MAX_US   1100000U   // yksi vaihe jonossa + marginaali
+#define DL_DISPATCH_ON_MAX_US      2000U
+#define DL_PHASE_TOL_US            5000U      // sallittu heitto LIGHT_MS:sta
+
+// CONFIG_LV_DEADLINE_ALERT: ohitus tulostetaan "DEADLINE miss <vaihe>"
+// matalan prioriteetin säikeessä, ei mittaavassa säikeessä
+
+// Aikaleima säikeiden välillä: 64-bit, ei kierrä. Syklilaskuri jos kortilla
+// on 64-bittinen, muuten tickit (tarkkuus 1/CONFIG_SYS_CLOCK_TICKS_PER_SEC).
+#if defined(CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER)
+static inline uint64_t dl_stamp(void) { return k_cycle_get_64(); }
+static inline uint64_t dl_to_us(uint64_t d) { return k_cyc_to_us_floor64(d); }
+#else
+static inline uint64_t dl_stamp(void) { return (uint64_t)k_uptime_ticks(); }
+static inline uint64_t dl_to_us(uint64_t d) { return k_ticks_to_us_floor64(d); }
+#endif
+
+void deadline_init(uint32_t phase_ms);
+void deadline_check(enum dl_stage st, uint64_t start, char col);
+// Vaiheille joiden pituus vaihtelee: budjetti expect_ms +- DL_PHASE_TOL_US
+void deadline_check_len(enum dl_stage st, uint64_t start, uint32_t expect_ms, char col);
+void deadline_dump(void);
+
+#endif
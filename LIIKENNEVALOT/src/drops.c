@@ -0,0 +1,60 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+#include "drops.h"
+#include "trace.h"
+
+static atomic_t drop_cnt[DROP_CAUSE_COUNT];
+static atomic_t fifo_depth[FQ_COUNT];
+static atomic_t fifo_hwm[FQ_COUNT];
+
+static const char *const drop_names[DROP_CAUSE_COUNT] = {
+    [DROP_RX_OVERRUN]    = "rx_overrun",
+    [DROP_UNKNOWN_CHAR]  = "unknown_char",
+    [DROP_BAD_TIME]      = "bad_time",
+    [DROP_BAD_FRAME]     = "bad_frame",
+    [DROP_BTN_BUSY]      = "btn_busy",
+    [DROP_NOMEM_UART]    = "nomem_uart",
+    [DROP_NOMEM_BTN]     = "nomem_btn",
+    [DROP_NOMEM_TIMER]   = "nomem_timer",
+    [DROP_RATE_LIMIT]    = "rate_limit",
+    [DROP_BUS_LAG]       = "bus_lag",
+};
+
+static const char *const fifo_names[FQ_COUNT] = {
+    [FQ_SEQ]     = "seq_fifo",
+    [FQ_PRIO]    = "prio_fifo",
+};
+
+void drop_add(enum drop_cause c, uint32_t n) {
+    atomic_val_t total = atomic_add(&drop_cnt[c], (atomic_val_t)n) + (atomic_val_t)n;
+    TRACE_EV("drop", c, total);
+}
+
+void fifo_enq(enum fifo_id q, uint32_t n) {
+    atomic_val_t d = atomic_add(&fifo_depth[q], (atomic_val_t)n) + (atomic_val_t)n;
+    atomic_val_t h = atomic_get(&fifo_hwm[q]);
+    while (d > h) {
+        if (atomic_cas(&fifo_hwm[q], h, d)) {
+            TRACE_EV("fifo_hwm", q, d);
+            break;
+        }
+        h = atomic_get(&fifo_hwm[q]);
+    }
+}
+
+void fifo_deq(enum fifo_id q, uint32_t n) {
+    atomic_sub(&fifo_depth[q], (atomic_val_t)n);
+}
+
+void drops_dump(void) {
+    printk("--- Drops ---\n");
+    for (int i = 0; i < DROP_CAUSE_COUNT; ++i) {
+        printk("%-14s %ld\n", drop_names[i], (long)atomic_get(&drop_cnt[i]));
+    }
+    printk("FIFO           depth  hwm\n");
+    for (int i = 0; i < FQ_COUNT; ++i) {
+        printk("%-14s %5ld %4ld\n", fifo_names[i],
+               (long)atomic_get(&fifo_depth[i]), (long)atomic_get(&fifo_hwm[i]));
+    }
+}
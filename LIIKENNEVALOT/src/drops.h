@@ -0,0 +1,38 @@
+#ifndef DROPS_H
+#define DROPS_H
+
+#include <zephyr/kernel.h>
+
+// Hukatut tapahtumat syittäin + FIFOjen syvyys ja huippu (E-komento).
+// Laskurit ovat atomisia: kutsuttavissa ISR:stä, workista ja taskeista.
+
+enum drop_cause {
+    DROP_RX_OVERRUN,     // RX-rengas täynnä, tavu hukattu (ISR)
+    DROP_UNKNOWN_CHAR,   // tuntematon komentomerkki
+    DROP_BAD_TIME,       // A/C+HHMMSS virheellinen tai kelloa ei asetettu
+    DROP_BAD_FRAME,      // kehys NAK (pituus, komento, CRC, aikakatkaisu)
+    DROP_BTN_BUSY,       // syöte jo odottamassa (inputs.c), painallus yhdistyi edelliseen
+    DROP_NOMEM_UART,     // k_malloc epäonnistui: UART / kehys
+    DROP_NOMEM_BTN,      //   nappi
+    DROP_NOMEM_TIMER,    //   ajastin
+    DROP_RATE_LIMIT,     // lähteen token bucket tyhjä (ingress.h)
+    DROP_BUS_LAG,        // valoväylän tilaaja jäi renkaan yli jälkeen (lightbus.h)
+    DROP_CAUSE_COUNT
+};
+
+enum fifo_id {
+    FQ_SEQ,
+    FQ_PRIO,
+    FQ_COUNT
+};
+
+void drop_add(enum drop_cause c, uint32_t n);
+static inline void drop_count(enum drop_cause c) { drop_add(c, 1); }
+
+// Kutsutaan ennen k_fifo_put:ia / k_fifo_get:n jälkeen
+void fifo_enq(enum fifo_id q, uint32_t n);
+void fifo_deq(enum fifo_id q, uint32_t n);
+
+void drops_dump(void);
+
+#endif
@@ -0,0 +1,99 @@
+#include <zephyr/sys/crc.h>
+#include "frame.h"
+
+enum { FR_IDLE = 0, FR_LEN, FR_SEQ, FR_PAYLOAD, FR_CRC_HI, FR_CRC_LO };
+
+void frame_reset(struct frame_rx *rx) {
+    rx->state = FR_IDLE;
+}
+
+void frame_start(struct frame_rx *rx) {
+    rx->state     = FR_LEN;
+    rx->pos       = 0;
+    rx->crc       = 0xFFFF;
+    rx->arg_n     = 0;
+    rx->prio_next = false;
+    rx->bad       = false;
+    rx->ncmd      = 0;
+}
+
+bool frame_active(const struct frame_rx *rx) {
+    return rx->state != FR_IDLE;
+}
+
+static void frame_cmd_byte(struct frame_rx *rx, uint8_t b) {
+    if (rx->bad) return;
+
+    if (rx->arg_n) {
+        rx->arg[3 - rx->arg_n] = b;
+        if (--rx->arg_n == 0) {
+            if (rx->arg[0] > 23 || rx->arg[1] > 59 || rx->arg[2] > 59) { rx->bad = true; return; }
+            struct frame_cmd *c = &rx->cmd[rx->ncmd++];
+            c->op   = 'A';
+            c->prio = false;
+            c->secs = rx->arg[0] * 3600 + rx->arg[1] * 60 + rx->arg[2];
+        }
+        return;
+    }
+    switch (b) {
+    case 'R': case 'Y': case 'G':
+        rx->cmd[rx->ncmd].op   = (char)b;
+        rx->cmd[rx->ncmd].prio = rx->prio_next;
+        rx->cmd[rx->ncmd].secs = 0;
+        rx->ncmd++;
+        rx->prio_next = false;
+        return;
+    case 'X':
+        if (rx->prio_next) break;
+        rx->cmd[rx->ncmd].op   = 'R';
+        rx->cmd[rx->ncmd].prio = true;
+        rx->cmd[rx->ncmd].secs = 0;
+        rx->ncmd++;
+        return;
+    case '!':
+        if (rx->prio_next) break;
+        rx->prio_next = true;
+        return;
+    case 'A':
+        if (rx->prio_next) break;
+        rx->arg_n = 3;
+        return;
+    default:
+        break;
+    }
+    rx->bad = true;
+}
+
+enum frame_result frame_feed(struct frame_rx *rx, uint8_t b) {
+    switch (rx->state) {
+    case FR_LEN:
+        if (b == 0 || b > FRAME_MAX_LEN) { rx->state = FR_IDLE; return FRAME_BAD_LEN; }
+        rx->len = b;
+        rx->crc = crc16_itu_t(rx->crc, &b, 1);
+        rx->state = FR_SEQ;
+        return FRAME_MORE;
+    case FR_SEQ:
+        rx->seq = b;
+        rx->crc = crc16_itu_t(rx->crc, &b, 1);
+        rx->state = FR_PAYLOAD;
+        return FRAME_MORE;
+    case FR_PAYLOAD:
+        rx->crc = crc16_itu_t(rx->crc, &b, 1);
+        frame_cmd_byte(rx, b);
+        if (++rx->pos == rx->len) rx->state = FR_CRC_HI;
+        return FRAME_MORE;
+    case FR_CRC_HI:
+        rx->rx_crc = (uint16_t)b << 8;
+        rx->state = FR_CRC_LO;
+        return FRAME_MORE;
+    case FR_CRC_LO:
+        rx->rx_crc |= b;
+        rx->state = FR_IDLE;
+        if (rx->rx_crc != rx->crc) return FRAME_BAD_CRC;
+        // kesken jäänyt '!' tai 'A' on myös virhe
+        if (rx->bad || rx->arg_n || rx->prio_next) return FRAME_BAD_CMD;
+        return FRAME_OK;
+    default:
+        return FRAME_MORE;
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Binäärikehys ASCII-komentojen rinnalla (SYNC ei ole ASCII-merkki):
+//   [SYNC 0xA5][LEN][SEQ][LEN tavua komentoja][CRC16 hi][CRC16 lo]
+// CRC16-CCITT-FALSE (poly 0x1021, alku 0xFFFF) kentistä LEN..komennot.
+// Komennot:
+//   'R' 'Y' 'G'     väri seq-jonoon
+//   '!' + väri      väri prioriteettikaistaan, 'X' = hätä-punainen
+//   'A' hh mm ss    ajastin (binääriarvot)
+// Sama SEQ peräkkäin = uudelleenlähetys ("ACK seq n dup"). ASCII 'N' aloittaa
+// uuden istunnon: edellinen SEQ unohdetaan, vastaus "SESSION".
+#define FRAME_SYNC        0xA5
+#define FRAME_MAX_LEN     64
+#define FRAME_MAX_CMDS    FRAME_MAX_LEN
+#define FRAME_TIMEOUT_MS  100   // kesken jäänyt kehys hylätään
+
+struct frame_cmd {
+    char op;        // 'R','Y','G' tai 'A'
+    bool prio;
+    int32_t secs;   // 'A'
+};
+
+enum frame_result {
+    FRAME_MORE = 0,     // kehys kesken
+    FRAME_OK,
+    FRAME_BAD_LEN,
+    FRAME_BAD_CMD,
+    FRAME_BAD_CRC,
+};
+
+struct frame_rx {
+    uint8_t  state;
+    uint8_t  len;
+    uint8_t  seq;
+    uint8_t  pos;
+    uint16_t crc;
+    uint16_t rx_crc;
+    uint8_t  arg_n;       // 'A':n argumentteja jäljellä
+    uint8_t  arg[3];
+    bool     prio_next;
+    bool     bad;
+    uint8_t  ncmd;
+    struct frame_cmd cmd[FRAME_MAX_CMDS];
+};
+
+// Kutsutaan kun SYNC-tavu on vastaanotettu
+void frame_start(struct frame_rx *rx);
+void frame_reset(struct frame_rx *rx);
+bool frame_active(const struct frame_rx *rx);
+// Yksi tavu suoraan RX-renkaasta; valmis kehys palauttaa != FRAME_MORE
+enum frame_result frame_feed(struct frame_rx *rx, uint8_t b);
+
+#endif
@@ -0,0 +1,196 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+#include "ingress.h"
+#include "drops.h"
+
+#define TOKEN  1000000U     // 1 token mikroyksikköinä (rate_mhz * ms)
+
+struct ing_item {
+    char     col;
+    uint64_t t_in;
+};
+
+struct ing_bucket {
+    struct ing_config cfg;
+    uint32_t tokens;        // mikrotokeneita
+    uint32_t last_ms;
+    uint8_t  head, len;     // pidetyt
+    struct ing_item hold[INGRESS_HOLD];
+    uint32_t passed, held, rejected;
+};
+
+// Oletukset: yhteensä 950 mHz < INGRESS_SERVICE_MHZ, joten jono ei kasva
+// pysyvästi vaikka kaikki lähteet ajavat täysillä; lyhyt purske sallitaan
+#define ING_UART_MHZ    300
+#define ING_FRAME_MHZ   250
+#define ING_BUTTON_MHZ  200
+#define ING_TIMER_MHZ   100
+#define ING_PLAN_MHZ    100
+BUILD_ASSERT(ING_UART_MHZ + ING_FRAME_MHZ + ING_BUTTON_MHZ + ING_TIMER_MHZ + ING_PLAN_MHZ
+             < INGRESS_SERVICE_MHZ, "ingress defaults exceed the dispatcher service rate");
+
+static struct ing_bucket buckets[ING_SOURCE_COUNT] = {
+    [ING_UART]   = { .cfg = { ING_UART_MHZ,   4, ING_DROP_OLDEST } },
+    [ING_FRAME]  = { .cfg = { ING_FRAME_MHZ,  8, ING_DROP_NEWEST } },
+    [ING_BUTTON] = { .cfg = { ING_BUTTON_MHZ, 3, ING_COALESCE } },
+    [ING_TIMER]  = { .cfg = { ING_TIMER_MHZ,  2, ING_DROP_OLDEST } },
+    [ING_PLAN]   = { .cfg = { ING_PLAN_MHZ,   4, ING_DROP_OLDEST } },
+};
+
+static const char *const src_names[ING_SOURCE_COUNT] = {
+    [ING_UART] = "uart", [ING_FRAME] = "frame", [ING_BUTTON] = "button",
+    [ING_TIMER] = "timer", [ING_PLAN] = "plan",
+};
+static const char *const pol_names[] = { "newest", "oldest", "coalesce" };
+
+static struct k_spinlock ing_lock;
+static void (*ing_emit)(enum ing_source src, char col, uint64_t t_in);
+
+static void ingress_work_fn(struct k_work *work);
+K_WORK_DELAYABLE_DEFINE(ingress_work, ingress_work_fn);
+
+static void refill(struct ing_bucket *b, uint32_t now) {
+    uint32_t cap = (uint32_t)b->cfg.burst * TOKEN;
+    uint32_t dt  = now - b->last_ms;
+    b->last_ms = now;
+    if (b->tokens >= cap) { b->tokens = cap; return; }
+    uint64_t t = (uint64_t)b->tokens + (uint64_t)dt * b->cfg.rate_mhz;
+    b->tokens = (uint32_t)MIN(t, (uint64_t)cap);
+}
+
+// ms seuraavaan tokeniin (lukko pidossa)
+static uint32_t ms_to_token(const struct ing_bucket *b) {
+    if (b->tokens >= TOKEN || b->cfg.rate_mhz == 0) return 0;
+    return DIV_ROUND_UP(TOKEN - b->tokens, b->cfg.rate_mhz);
+}
+
+static void reject(enum ing_source src) {
+    buckets[src].rejected++;
+    drop_count(DROP_RATE_LIMIT);
+}
+
+bool ingress_submit(enum ing_source src, char col, uint64_t t_in) {
+    struct ing_bucket *b = &buckets[src];
+    bool pass = false, ok = true, kick = false;
+
+    k_spinlock_key_t key = k_spin_lock(&ing_lock);
+    refill(b, k_uptime_get_32());
+    // pidetyt ensin: uusi ei saa ohittaa niitä
+    if (b->len == 0 && b->tokens >= TOKEN) {
+        b->tokens -= TOKEN;
+        b->passed++;
+        pass = true;
+    } else if (b->cfg.policy == ING_DROP_NEWEST || b->cfg.rate_mhz == 0) {
+        ok = false;
+    } else {
+        uint8_t depth = b->cfg.policy == ING_COALESCE ? 1 : INGRESS_HOLD;
+        if (b->len >= depth) {              // vanhin pidetty pois
+            b->head = (b->head + 1) % INGRESS_HOLD;
+            b->len--;
+            ok = false;                     // hylätty on vanhin, uusi jää
+        }
+        b->hold[(b->head + b->len) % INGRESS_HOLD] = (struct ing_item){ col, t_in };
+        b->len++;
+        b->held++;
+        kick = true;
+    }
+    uint32_t wait = ms_to_token(b);
+    k_spin_unlock(&ing_lock, key);
+
+    if (!ok) reject(src);
+    if (pass) ing_emit(src, col, t_in);
+    if (kick) k_work_schedule(&ingress_work, K_MSEC(MAX(wait, 1U)));
+    return pass || kick;
+}
+
+int ingress_take(enum ing_source src, int n) {
+    struct ing_bucket *b = &buckets[src];
+    k_spinlock_key_t key = k_spin_lock(&ing_lock);
+    refill(b, k_uptime_get_32());
+    int k = MIN(n, (int)(b->tokens / TOKEN));
+    b->tokens -= (uint32_t)k * TOKEN;
+    b->passed += (uint32_t)k;
+    k_spin_unlock(&ing_lock, key);
+    for (int i = k; i < n; ++i) reject(src);
+    return k;
+}
+
+// Vapauttaa pidetyt kun tokeneita on kertynyt
+static void ingress_work_fn(struct k_work *work) {
+    ARG_UNUSED(work);
+    uint32_t next = UINT32_MAX;
+
+    for (int s = 0; s < ING_SOURCE_COUNT; ++s) {
+        struct ing_bucket *b = &buckets[s];
+        while (1) {
+            struct ing_item it;
+            bool got = false;
+            k_spinlock_key_t key = k_spin_lock(&ing_lock);
+            refill(b, k_uptime_get_32());
+            if (b->len && b->tokens >= TOKEN) {
+                it = b->hold[b->head];
+                b->head = (b->head + 1) % INGRESS_HOLD;
+                b->len--;
+                b->tokens -= TOKEN;
+                b->passed++;
+                got = true;
+            } else if (b->len) {
+                next = MIN(next, ms_to_token(b));
+            }
+            k_spin_unlock(&ing_lock, key);
+            if (!got) break;
+            ing_emit((enum ing_source)s, it.col, it.t_in);
+        }
+    }
+    if (next != UINT32_MAX) k_work_schedule(&ingress_work, K_MSEC(MAX(next, 1U)));
+}
+
+void ingress_init(void (*emit)(enum ing_source src, char col, uint64_t t_in)) {
+    ing_emit = emit;
+    ingress_reset();
+}
+
+void ingress_reset(void) {
+    k_work_cancel_delayable(&ingress_work);
+    k_spinlock_key_t key = k_spin_lock(&ing_lock);
+    uint32_t now = k_uptime_get_32();
+    for (int s = 0; s < ING_SOURCE_COUNT; ++s) {
+        buckets[s].tokens  = (uint32_t)buckets[s].cfg.burst * TOKEN;
+        buckets[s].last_ms = now;
+        buckets[s].head = buckets[s].len = 0;
+    }
+    k_spin_unlock(&ing_lock, key);
+}
+
+void ingress_set(enum ing_source src, const struct ing_config *cfg) {
+    uint32_t sum = 0;
+    k_spinlock_key_t key = k_spin_lock(&ing_lock);
+    refill(&buckets[src], k_uptime_get_32());   // vanhalla ratella tähän asti
+    buckets[src].cfg = *cfg;
+    buckets[src].cfg.burst = MIN(cfg->burst, INGRESS_BURST_MAX);
+    if (cfg->policy == ING_DROP_NEWEST) buckets[src].len = 0;
+    refill(&buckets[src], k_uptime_get_32());
+    for (int s = 0; s < ING_SOURCE_COUNT; ++s) sum += buckets[s].cfg.rate_mhz;
+    k_spin_unlock(&ing_lock, key);
+    if (sum >= INGRESS_SERVICE_MHZ) {
+        printk("Ingress: total rate %u mHz >= service %u mHz, sources not isolated\n",
+               sum, INGRESS_SERVICE_MHZ);
+    }
+}
+
+void ingress_dump(void) {
+    printk("--- Ingress ---\n");
+    printk("source  rate/s burst policy   tokens held passed  held  rejected\n");
+    for (int s = 0; s < ING_SOURCE_COUNT; ++s) {
+        struct ing_bucket b;
+        k_spinlock_key_t key = k_spin_lock(&ing_lock);
+        refill(&buckets[s], k_uptime_get_32());
+        b = buckets[s];
+        k_spin_unlock(&ing_lock, key);
+        printk("%-7s %3u.%03u %5u %-8s %6u %4u %6u %5u %9u\n", src_names[s],
+               b.cfg.rate_mhz / 1000, b.cfg.rate_mhz % 1000, b.cfg.burst,
+               pol_names[b.cfg.policy], b.tokens / TOKEN, b.len,
+               b.passed, b.held, b.rejected);
+    }
+}
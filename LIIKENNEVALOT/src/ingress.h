@@ -0,0 +1,62 @@
+#ifndef INGRESS_H
+#define INGRESS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Sisääntulon rajoitus lähteittäin (token bucket) ennen seq_fifoa.
+// Jokainen hyväksytty komento varaa valon LIGHT_MS:n ajaksi, joten yksi
+// räpättävä lähde ei saa täyttää jonoa muiden ohi. Prioriteettikaista
+// ohittaa rajoituksen.
+//
+// Ylivuotopolitiikka kun tokenia ei ole:
+//   ING_DROP_NEWEST  uusi hylätään
+//   ING_DROP_OLDEST  pidetään INGRESS_HOLD uusinta, vanhin pidetty hylätään
+//   ING_COALESCE     pidetään vain viimeisin (esim. nappi: viimeisin väri voittaa)
+// Pidetyt vapautuvat jonoon sitä mukaa kuin tokeneita kertyy.
+//
+// Lähteet jakavat saman seq_fifon, jota palvellaan yksi komento per
+// LIGHT_MS (INGRESS_SERVICE_MHZ). Eristys pitää vain, jos kaikkien
+// lähteiden yhteenlaskettu rate on sen alle: muuten yksi täysillä ajava
+// lähde kasvattaa jonoa ja muiden odotus pitenee rajatta. Oletukset
+// jakavat palvelun (yht. 0.95/s); ingress_set varoittaa ylityksestä.
+
+enum ing_source {
+    ING_UART,       // ASCII R/Y/G
+    ING_FRAME,      // binäärikehys (koko erä kerralla, aina drop newest)
+    ING_BUTTON,
+    ING_TIMER,      // A+HHMMSS
+    ING_PLAN,       // schedule.c
+    ING_SOURCE_COUNT
+};
+
+enum ing_policy {
+    ING_DROP_NEWEST,
+    ING_DROP_OLDEST,
+    ING_COALESCE,
+};
+
+#define INGRESS_HOLD 4
+#define INGRESS_SERVICE_MHZ 1000    // 1000 / LIGHT_MS (ms)
+#define INGRESS_BURST_MAX   4000    // burst * 10^6 mahtuu 32 bittiin
+
+// rate_mhz: tokeneita / 1000 s (1000 = 1/s), burst: ämpärin koko
+// (rajataan INGRESS_BURST_MAX:iin)
+struct ing_config {
+    uint32_t rate_mhz;
+    uint16_t burst;
+    uint8_t  policy;
+};
+
+// emit: hyväksytty komento jonoon (kutsutaan ilman lukkoa)
+void ingress_init(void (*emit)(enum ing_source src, char col, uint64_t t_in));
+// false = hylätty (true myös kun pidetään myöhempää vapautusta varten)
+bool ingress_submit(enum ing_source src, char col, uint64_t t_in);
+// Erä: palauttaa montako n:stä mahtuu (ING_FRAME), loput hylätään
+int  ingress_take(enum ing_source src, int n);
+// Ämpärit täyteen, pidetyt pois (init, WCET-mittauksen toistot)
+void ingress_reset(void);
+void ingress_set(enum ing_source src, const struct ing_config *cfg);
+void ingress_dump(void);
+
+#endif
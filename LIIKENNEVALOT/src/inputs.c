@@ -0,0 +1,159 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/gpio.h>
+#include <errno.h>
+#include <string.h>
+#include "inputs.h"
+#include "deadline.h"
+#include "drops.h"
+
+struct in_def {
+    struct gpio_dt_spec gpio;
+    uint8_t ev;             // indeksi in_ev:hen (bindingin event-enum)
+};
+
+// Bindingin event-enumin järjestyksessä
+static const char in_ev[] = { 'R', 'Y', 'G' };
+
+#define LV_INPUTS DT_COMPAT_GET_ANY_STATUS_OKAY(lv_inputs)
+
+#if DT_HAS_COMPAT_STATUS_OKAY(lv_inputs)
+#define IN_DEF(n) { GPIO_DT_SPEC_GET(n, gpios), DT_ENUM_IDX(n, event) },
+static const struct in_def in_defs[] = {
+    DT_FOREACH_CHILD_STATUS_OKAY(LV_INPUTS, IN_DEF)
+};
+#else
+// Vanha kytkentä: napit aliaksilla
+static const struct in_def in_defs[] = {
+    { GPIO_DT_SPEC_GET(DT_ALIAS(sw1), gpios), 0 },
+    { GPIO_DT_SPEC_GET(DT_ALIAS(sw2), gpios), 1 },
+    { GPIO_DT_SPEC_GET(DT_ALIAS(sw3), gpios), 2 },
+};
+#endif
+
+#define IN_COUNT    ARRAY_SIZE(in_defs)
+#define IN_NONE     0xFF
+
+// Portti: yksi callback, pinni -> syöte
+struct in_port {
+    const struct device *dev;
+    struct gpio_callback cb;
+    gpio_port_pins_t mask;
+    uint8_t pin_in[32];
+};
+
+static struct in_port in_ports[IN_COUNT];   // pahimmillaan jokainen eri portissa
+static uint8_t in_nports;
+
+static ATOMIC_DEFINE(in_pending, IN_COUNT);
+static uint64_t in_t[IN_COUNT];             // ISR-aikaleimat deadline-mittaukseen
+static struct k_spinlock in_lock;           // in_t: 64-bit ei ole atominen
+
+static void (*in_emit)(char col, uint64_t t_in);
+
+static void in_work_fn(struct k_work *work);
+K_WORK_DEFINE(in_work, in_work_fn);
+
+static void in_isr(const struct device *dev, struct gpio_callback *cb, gpio_port_pins_t pins) {
+    ARG_UNUSED(dev);
+    struct in_port *p = CONTAINER_OF(cb, struct in_port, cb);
+    uint64_t t = dl_stamp();
+
+    pins &= p->mask;
+    while (pins) {
+        unsigned pin = __builtin_ctz(pins);
+        pins &= pins - 1;
+        uint8_t i = p->pin_in[pin];
+        k_spinlock_key_t key = k_spin_lock(&in_lock);
+        in_t[i] = t;
+        k_spin_unlock(&in_lock, key);
+        if (atomic_test_and_set_bit(in_pending, i)) drop_count(DROP_BTN_BUSY);   // edellinen vielä odottaa
+    }
+    k_work_submit(&in_work);
+}
+
+// Järjestelmän workqueue: kaikki odottavat yhdellä kierroksella
+static void in_work_fn(struct k_work *work) {
+    ARG_UNUSED(work);
+    for (size_t w = 0; w < ARRAY_SIZE(in_pending); ++w) {
+        // etumerkitön: ylin bitti (ATOMIC_BITS syötettä) ei saa vuotaa yli
+        unsigned long m = (unsigned long)atomic_clear(&in_pending[w]);
+        while (m) {
+            unsigned i = w * ATOMIC_BITS + __builtin_ctzl(m);
+            m &= m - 1;
+            k_spinlock_key_t key = k_spin_lock(&in_lock);
+            uint64_t t = in_t[i];
+            k_spin_unlock(&in_lock, key);
+            in_emit(in_ev[in_defs[i].ev], t);
+        }
+    }
+}
+
+void inputs_init(void (*emit)(char col, uint64_t t_in)) {
+    in_emit = emit;
+    in_nports = 0;
+    for (uint8_t i = 0; i < IN_COUNT; ++i) {
+        const struct gpio_dt_spec *g = &in_defs[i].gpio;
+        struct in_port *p = NULL;
+        for (uint8_t k = 0; k < in_nports; ++k) {
+            if (in_ports[k].dev == g->port) { p = &in_ports[k]; break; }
+        }
+        if (!p) {
+            p = &in_ports[in_nports++];
+            p->dev  = g->port;
+            p->mask = 0;
+            memset(p->pin_in, IN_NONE, sizeof(p->pin_in));
+        }
+        p->mask |= BIT(g->pin);
+        p->pin_in[g->pin] = i;
+    }
+    for (uint8_t k = 0; k < in_nports; ++k) {
+        gpio_init_callback(&in_ports[k].cb, in_isr, in_ports[k].mask);
+    }
+}
+
+int inputs_start(void) {
+    int ret;
+    for (uint8_t i = 0; i < IN_COUNT; ++i) {
+        const struct gpio_dt_spec *g = &in_defs[i].gpio;
+        if (!gpio_is_ready_dt(g)) return -ENODEV;
+        ret = gpio_pin_configure_dt(g, GPIO_INPUT);                         if (ret) return ret;
+        ret = gpio_pin_interrupt_configure_dt(g, GPIO_INT_EDGE_TO_ACTIVE);  if (ret) return ret;
+    }
+    for (uint8_t k = 0; k < in_nports; ++k) {
+        ret = gpio_add_callback(in_ports[k].dev, &in_ports[k].cb);
+        if (ret) return ret;
+    }
+    printk("Inputs configured (%u on %u ports)\n", (unsigned)IN_COUNT, in_nports);
+    return 0;
+}
+
+#if defined(CONFIG_LV_WCET)
+void inputs_wcet_isr(uint32_t pins) {
+    in_isr(in_ports[0].dev, &in_ports[0].cb, pins);
+}
+
+void inputs_wcet_pend_all(void) {
+    uint64_t t = dl_stamp();
+    for (uint8_t i = 0; i < IN_COUNT; ++i) {
+        in_t[i] = t;
+        atomic_set_bit(in_pending, i);
+    }
+}
+
+void inputs_wcet_drain(void) {
+    in_work_fn(&in_work);
+}
+
+void inputs_wcet_cancel(void) {
+    k_work_cancel(&in_work);
+    for (size_t w = 0; w < ARRAY_SIZE(in_pending); ++w) atomic_clear(&in_pending[w]);
+}
+
+uint32_t inputs_wcet_port_mask(void) {
+    return in_ports[0].mask;
+}
+#endif
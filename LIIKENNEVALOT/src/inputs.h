@@ -0,0 +1,35 @@
+#ifndef INPUTS_H
+#define INPUTS_H
+
+#include <stdint.h>
+
+// Digitaalisyötteet (napit, ilmaisinsilmukat, jalankulkijanapit).
+//
+// Syötteet luetaan devicetreestä: "lv,inputs"-solmun lapset, jokaisella
+// gpios ja event (dts/bindings/lv,inputs.yaml). Ilman solmua vanhat
+// aliakset sw1-sw3 = R/Y/G.
+//
+// Yksi gpio_callback per GPIO-portti: ISR käy pins-maskin bitit läpi,
+// hakee pinnin syötteen taulusta, leimaa ajan ja asettaa syötteen bitin
+// atomiseen odotusmaskiin. Yksi work-alkio tyhjentää maskin sanoittain ja
+// kutsuu emitin jokaiselle syötteelle taulun järjestyksessä. Sama syöte
+// uudestaan ennen tyhjennystä yhdistyy (DROP_BTN_BUSY).
+
+// Taulu ja callbackit, ei laitteistoa (ennen WCET-ajoa).
+// emit: syötteen tapahtuma, järjestelmän workqueue, t_in = ISR-aikaleima
+void inputs_init(void (*emit)(char col, uint64_t t_in));
+// Pinnit ja keskeytykset päälle, callbackit portteihin
+int  inputs_start(void);
+
+#if defined(CONFIG_LV_WCET)
+// Ensimmäisen portin callback kuten ajurista, pins = portin pinnit
+void inputs_wcet_isr(uint32_t pins);
+// Kaikki syötteet odottamaan ilman work-alkiota / tyhjennys suoraan
+void inputs_wcet_pend_all(void);
+void inputs_wcet_drain(void);
+void inputs_wcet_cancel(void);
+// Ensimmäisen portin kaikki syötepinnit
+uint32_t inputs_wcet_port_mask(void);
+#endif
+
+#endif
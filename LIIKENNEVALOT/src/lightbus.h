@@ -0,0 +1,58 @@
+#ifndef LIGHTBUS_H
+#define LIGHTBUS_H
+
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Valon tilamuutosten julkaisu/tilaus. LED-taski kirjoittaa yhden tietueen
+// staattiseen renkaaseen (ei k_mallocia, ei jonoa per kuluttaja) ja herättää
+// tilaajat. Tilaaja lukee omalla indeksillään; jos se jää yli LB_RING
+// tietuetta jälkeen, vanhimmat ohitetaan ja lasketaan (lost, DROP_BUS_LAG).
+//
+// Tilaajatyypit:
+//   lb_sub_thread  oma säie odottaa lb_read(..., K_FOREVER)
+//   lb_sub_work    julkaisu submittaa k_workin, handler tyhjentää K_NO_WAIT
+//   lb_sub_listen  kutsutaan suoraan julkaisijan kontekstissa (vain halpa
+//                  työ, esim. tracing jonka aikaleima on oltava GPIO:n kohdalla)
+
+#define LB_RING      32
+#define LB_MAX_SUBS  8
+
+enum lb_event {
+    LB_START,   // LED-taski käynnistyi
+    LB_ON,      // GPIO päällä
+    LB_OFF,     // GPIO pois, usec = vaiheen kesto
+    LB_DEBUG,   // D-komento, col '1' / '0'
+};
+
+struct light_rec {
+    uint32_t seq;
+    uint64_t t;         // dl_stamp() julkaisuhetkellä
+    uint32_t id;        // phase_id (komennon t_in)
+    uint32_t usec;
+    char     col;
+    uint8_t  ev;        // enum lb_event
+    uint8_t  aborted;
+};
+
+struct lb_sub {
+    const char *name;
+    void (*listen)(const struct light_rec *r);
+    struct k_work *work;
+    struct k_sem sem;
+    uint32_t rd;
+    uint32_t lost;
+};
+
+// Rekisteröinti ennen kuin LED-taskit käynnistyvät (main)
+int lb_sub_thread(struct lb_sub *s, const char *name);
+int lb_sub_work(struct lb_sub *s, const char *name, struct k_work *work);
+int lb_sub_listen(struct lb_sub *s, const char *name, void (*fn)(const struct light_rec *r));
+
+void lb_publish(enum lb_event ev, char col, uint32_t id, uint32_t usec, bool aborted);
+// 0 = tietue kopioitu outiin, -EAGAIN = aikakatkaisu
+int  lb_read(struct lb_sub *s, struct light_rec *out, k_timeout_t timeout);
+void lb_dump(void);
+
+#endif
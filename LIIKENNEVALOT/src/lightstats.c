@@ -0,0 +1,54 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include "lightstats.h"
+#include "lightbus.h"
+
+struct col_stats {
+    uint32_t n, aborted;
+    uint32_t min_us, max_us;
+    uint64_t sum_us;
+};
+
+static struct col_stats st[3];      // R, Y, G
+static struct lb_sub stats_sub;
+
+static int col_idx(char c) {
+    switch (c) {
+    case 'R': return 0;
+    case 'Y': return 1;
+    case 'G': return 2;
+    }
+    return -1;
+}
+
+static void stats_work_fn(struct k_work *work) {
+    ARG_UNUSED(work);
+    struct light_rec r;
+    while (lb_read(&stats_sub, &r, K_NO_WAIT) == 0) {
+        int i = col_idx(r.col);
+        if (r.ev != LB_OFF || i < 0) continue;
+        struct col_stats *s = &st[i];
+        if (r.aborted) { s->aborted++; continue; }
+        if (s->n == 0 || r.usec < s->min_us) s->min_us = r.usec;
+        if (r.usec > s->max_us) s->max_us = r.usec;
+        s->sum_us += r.usec;
+        s->n++;
+    }
+}
+K_WORK_DEFINE(stats_work, stats_work_fn);
+
+int lightstats_init(void) {
+    return lb_sub_work(&stats_sub, "stats", &stats_work);
+}
+
+void lightstats_dump(void) {
+    static const char cols[] = "RYG";
+    printk("--- Light phases ---\n");
+    printk("col     n  abort   min_us   avg_us   max_us\n");
+    for (int i = 0; i < 3; ++i) {
+        const struct col_stats *s = &st[i];
+        uint32_t avg = s->n ? (uint32_t)(s->sum_us / s->n) : 0;
+        printk("%c   %5u  %5u %8u %8u %8u\n", cols[i], s->n, s->aborted,
+               s->min_us, avg, s->max_us);
+    }
+}
@@ -0,0 +1,10 @@
+#ifndef LIGHTSTATS_H
+#define LIGHTSTATS_H
+
+// Vaihetilastot väreittäin valoväylän tilaajana (lightbus.h), järjestelmän
+// workqueuessa. T-komento: lukumäärä, keskeytetyt, kesto min/avg/max.
+
+int  lightstats_init(void);
+void lightstats_dump(void);
+
+#endif
@@ -4,10 +4,35 @@
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/sys/util.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/ring_buffer.h>
 #include <zephyr/timing/timing.h>
+#if !defined(CONFIG_ARCH_POSIX)
+#include <zephyr/sys/reboot.h>
+#endif
 #include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
+#include "thread_stats.h"
+#include "deadline.h"
+#include "frame.h"
+#include "program.h"
+#include "profiler.h"
+#include "trace.h"
+#include "drops.h"
+#include "schedule.h"
+#include "retain.h"
+#include "planstore.h"
+#include "bootprof.h"
+#include "ingress.h"
+#include "lightbus.h"
+#include "lightstats.h"
+#include "wallclock.h"
+#include "inputs.h"
+#if defined(CONFIG_LV_WCET)
+#include <zephyr/sys/crc.h>
+#include "wcet.h"
+#endif
 //Vk 5 Liikennevalojen yksikkötestaus
 
 
@@ -38,34 +63,66 @@ static int time_parse(char *time) {
 
     return hour*3600 + minute*60 + second;
 }
-//Debugit
-static volatile bool dbg_on = true;
-#define PRINTK(...) do { if (dbg_on) printk(__VA_ARGS__); } while (0)
-//Mittaus Fifo
-struct meas_item {
-    void *fifo_reserved;
-    char value;        /* 'R','Y','G' */
-    uint64_t usec;     /* kesto mikrosekunteina */
-};
-K_FIFO_DEFINE(meas_fifo);
+//Debugit (uart_task kirjoittaa, kaikki ytimet lukevat)
+static atomic_t dbg_on = ATOMIC_INIT(1);
+#define PRINTK(...) do { if (atomic_get(&dbg_on)) printk(__VA_ARGS__); } while (0)
 //Ledit
 static const struct gpio_dt_spec red   = GPIO_DT_SPEC_GET(DT_ALIAS(led0), gpios);
 static const struct gpio_dt_spec green = GPIO_DT_SPEC_GET(DT_ALIAS(led1), gpios);
 //Uart
 #define UART_DEVICE_NODE DT_CHOSEN(zephyr_shell_uart)
 static const struct device *const uart_dev = DEVICE_DT_GET(UART_DEVICE_NODE);
+//RX-rengas: ISR (tai pollaus) kirjoittaa, uart_task purkaa suoraan renkaasta
+#define RX_RING_SIZE 256
+RING_BUF_DECLARE(rx_ring, RX_RING_SIZE);
+K_SEM_DEFINE(rx_sem, 0, 1);
+static atomic_t rx_irq = ATOMIC_INIT(0);   // 0 -> uart_task pollaa renkaaseen
 //Dispatcher FIFO
 struct seq_item {
     void *fifo_reserved;
     char value;        /* 'R' / 'Y' / 'G' */
+    uint64_t t_in;     /* syötteen aikaleima (dl_stamp) */
+    uint32_t ms;       /* vaiheen kesto, 0 = LIGHT_MS */
 };
 K_FIFO_DEFINE(seq_fifo);
+//Prioriteettikaista: ohittaa seq_fifon ja katkaisee käynnissä olevan vaiheen
+K_FIFO_DEFINE(prio_fifo);
+
+// Kaikki värikomennot jonoon tätä kautta: varaus, jäljitys, jonosyvyys
+// ja seq_fifon peili retain-tilaan
+static bool seq_enqueue_ms(struct k_fifo *q, char col, uint64_t t_in, uint32_t ms, enum drop_cause nomem) {
+    struct seq_item *it = k_malloc(sizeof(*it));
+    if (!it) { drop_count(nomem); return false; }
+    it->value = col;
+    it->t_in  = t_in;
+    it->ms    = ms;
+    TRACE_EV("cmd_in", col, t_in);
+    if (q == &prio_fifo) {
+        fifo_enq(FQ_PRIO, 1);
+    } else {
+        fifo_enq(FQ_SEQ, 1);
+        retain_q_push(col);
+    }
+    k_fifo_put(q, it);
+    return true;
+}
+static inline bool seq_enqueue(struct k_fifo *q, char col, uint64_t t_in, enum drop_cause nomem) {
+    return seq_enqueue_ms(q, col, t_in, 0, nomem);
+}
 //synkkaus
 K_SEM_DEFINE(release_sem, 0, 1);
-
-static volatile bool red_trig = false;
-static volatile bool yel_trig = false;
-static volatile bool grn_trig = false;
+K_SEM_DEFINE(abort_sem, 0, 1);   // LED-vaihe odottaa tätä LIGHT_MS:n ajan
+// Dispatcher kirjoittaa ennen LED-mutexin lukitusta, LED-taski lukee sen
+// jälkeen: mutex järjestää muistin myös eri ytimien välillä (SMP)
+static uint64_t disp_t;     // dispatcherin herätyshetki, yksi vaihe kerrallaan
+static uint32_t phase_ms;   // käynnistettävän vaiheen kesto
+static uint32_t phase_id;   // vaiheen komennon t_in:n alimmat 32 bittiä (trace.h)
+K_SEM_DEFINE(prog_sem, 0, 1);        // herättää dispatcherin kun ohjelma käynnistyy
+
+// Vain oman mutexin alla
+static bool red_trig = false;
+static bool yel_trig = false;
+static bool grn_trig = false;
 
 K_MUTEX_DEFINE(red_mutex);    K_CONDVAR_DEFINE(red_cv);
 K_MUTEX_DEFINE(yellow_mutex); K_CONDVAR_DEFINE(yellow_cv);
@@ -77,7 +134,8 @@ K_MUTEX_DEFINE(green_mutex);  K_CONDVAR_DEFINE(green_cv);
 //protot
 static int init_led(void);
 static int init_uart(void);
-static int init_buttons(void);
+static bool retain_restore(void);
+static void plan_boot(void);
 
 static void uart_task(void *, void *, void *);
 static void dispatcher_task(void *, void *, void *);
@@ -85,99 +143,189 @@ static void red_led_task(void *, void *, void *);
 static void yellow_led_task(void *, void *, void *);
 static void green_led_task(void *, void *, void *);
 
-static void btn_red_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins);
-static void btn_yel_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins);
-static void btn_grn_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins);
-
-static void red_work_fn(struct k_work *work);
-static void yel_work_fn(struct k_work *work);
-static void grn_work_fn(struct k_work *work);
-
-K_WORK_DEFINE(red_work, red_work_fn);
-K_WORK_DEFINE(yel_work, yel_work_fn);
-K_WORK_DEFINE(grn_work, grn_work_fn);
-
 //AJASTIN
-/* Ajastin laukaisee valitun värin FIFOon timer_workin kautta. */
-static struct k_timer timer;
-static char timer_color = 'R';   // minkä värin ajastin laukaisee
-static int  timer_delay_s = 0;   //viimeisin asetettu viive
+/* A-laukaisut kellonajan mukaan (wallclock.h), väri timer_color lisäyshetkellä */
+static char timer_color = 'R';   // minkä värin seuraava A-laukaisu saa
 
-static void timer_work_fn(struct k_work *work) {
-    ARG_UNUSED(work);
-    struct seq_item *it = k_malloc(sizeof(*it));
-    if (!it) return;
-    it->value = timer_color;  //väri mikä laitetaan
-    k_fifo_put(&seq_fifo, it);
-    PRINTK("TIMER -> %c (Wait %d s)\n", timer_color, timer_delay_s);
+// Laukaisu (wallclock.c, järjestelmän workqueue)
+static void wall_emit(char col, uint64_t t_in) {
+    if (ingress_submit(ING_TIMER, col, t_in)) PRINTK("TIMER -> %c\n", col);
 }
-K_WORK_DEFINE(timer_work, timer_work_fn);
 
-static void timer_handler(struct k_timer *t) {
-    ARG_UNUSED(t);
-    k_work_submit(&timer_work);
+// Napit ja ilmaisimet (inputs.c, järjestelmän workqueue)
+static void input_emit(char col, uint64_t t_in) {
+    if (ingress_submit(ING_BUTTON, col, t_in)) PRINTK("BTN -> %c\n", col);
 }
 
-//nappien määrittely
-#define BUTTON_RED  DT_ALIAS(sw1)
-#define BUTTON_YEL  DT_ALIAS(sw2)
-#define BUTTON_GRN  DT_ALIAS(sw3)
+// Suunnitelman askel (schedule.c, järjestelmän workqueue)
+static void plan_emit(char col, uint64_t t_in) {
+    if (ingress_submit(ING_PLAN, col, t_in)) PRINTK("PLAN -> %c\n", col);
+}
 
-static const struct gpio_dt_spec btn_red = GPIO_DT_SPEC_GET(BUTTON_RED, gpios);
-static const struct gpio_dt_spec btn_yel = GPIO_DT_SPEC_GET(BUTTON_YEL, gpios);
-static const struct gpio_dt_spec btn_grn = GPIO_DT_SPEC_GET(BUTTON_GRN, gpios);
+// Rajoittimen läpäissyt komento seq_fifoon (ingress.c, ilman lukkoa)
+static void ingress_emit(enum ing_source src, char col, uint64_t t_in) {
+    static const enum drop_cause nomem[ING_SOURCE_COUNT] = {
+        [ING_UART] = DROP_NOMEM_UART, [ING_FRAME] = DROP_NOMEM_UART,
+        [ING_BUTTON] = DROP_NOMEM_BTN, [ING_TIMER] = DROP_NOMEM_TIMER,
+        [ING_PLAN] = DROP_NOMEM_TIMER,
+    };
+    seq_enqueue(&seq_fifo, col, t_in, nomem[src]);
+}
 
-static struct gpio_callback btn_red_cb;
-static struct gpio_callback btn_yel_cb;
-static struct gpio_callback btn_grn_cb;
+// Ei käynnisty itsestään: main() käynnistää vaiheittain kun init onnistui
+#define START_GATED K_TICKS_FOREVER
 
-// Debuggaus taski
+// Debuggaus taski, käynnistyy kun dbg_sub on alustettu
 static void debug_task(void *, void *, void *);
 #define DEBUG_PRIORITY  (5 + 2)
-K_THREAD_DEFINE(debug_thread, 1024, debug_task, NULL, NULL, NULL, DEBUG_PRIORITY, 0, 0);
-K_FIFO_DEFINE(taskdbg_fifo);
-
-struct taskdbg_msg {
-    void *fifo_reserved;
-    char ev;   // 'S' start, '1' LED ON, '0' LED OFF, 'D' debug toggle
-    char col;  // 'R','Y','G','1','0'
-};
-
-static inline void taskdbg_push(char ev, char col) {
-    if (!dbg_on) return;
-    struct taskdbg_msg *m = k_malloc(sizeof(*m));
-    if (!m) return;
-    m->ev = ev; m->col = col;
-    k_fifo_put(&taskdbg_fifo, m);
+K_THREAD_DEFINE(debug_thread, 1024, debug_task, NULL, NULL, NULL, DEBUG_PRIORITY, 0, START_GATED);
+// Valon tilat ja kestot valoväylältä (lightbus.h), ei omaa jonoa
+static struct lb_sub dbg_sub;
+
+#if defined(CONFIG_TRACING)
+// Julkaisijan kontekstissa: aikaleima pysyy GPIO-muutoksen kohdalla
+static void trace_listen(const struct light_rec *r) {
+    if (r->ev == LB_ON) {
+        TRACE_EV("led_on", r->col, r->id);
+    } else if (r->ev == LB_OFF) {
+        TRACE_EV("led_off", r->col | (r->aborted << 8), r->id);
+        TRACE_EV("meas", r->col, r->usec);
+    }
 }
+static struct lb_sub trace_sub;
+#endif
 
 #define STACKSIZE 1024
 #define PRIORITY  5
-K_THREAD_DEFINE(uart_thread,       STACKSIZE, uart_task,       NULL,NULL,NULL, PRIORITY, 0, 0);
-K_THREAD_DEFINE(dispatcher_thread, STACKSIZE, dispatcher_task, NULL,NULL,NULL, PRIORITY, 0, 0);
-K_THREAD_DEFINE(red_thread,        STACKSIZE, red_led_task,    NULL,NULL,NULL, PRIORITY, 0, 0);
-K_THREAD_DEFINE(yellow_thread,     STACKSIZE, yellow_led_task, NULL,NULL,NULL, PRIORITY, 0, 0);
-K_THREAD_DEFINE(green_thread,      STACKSIZE, green_led_task,  NULL,NULL,NULL, PRIORITY, 0, 0);
+K_THREAD_DEFINE(uart_thread,       STACKSIZE, uart_task,       NULL,NULL,NULL, PRIORITY, 0, START_GATED);
+K_THREAD_DEFINE(dispatcher_thread, STACKSIZE, dispatcher_task, NULL,NULL,NULL, PRIORITY, 0, START_GATED);
+K_THREAD_DEFINE(red_thread,        STACKSIZE, red_led_task,    NULL,NULL,NULL, PRIORITY, 0, START_GATED);
+K_THREAD_DEFINE(yellow_thread,     STACKSIZE, yellow_led_task, NULL,NULL,NULL, PRIORITY, 0, START_GATED);
+K_THREAD_DEFINE(green_thread,      STACKSIZE, green_led_task,  NULL,NULL,NULL, PRIORITY, 0, START_GATED);
+
+
+#if defined(CONFIG_LV_SMP_PIN)
+// Syöte ja valot eri ytimille (Kconfig LV_SMP_PIN). Kiinnitys vaatii että
+// säie ei ole ajovalmis: portitetut (myös debug_task) ennen k_thread_startia,
+// workqueue odottaa tässä vaiheessa jonossaan. Ajetaan mainin alussa.
+static void smp_pin_one(k_tid_t t, const char *name, int cpu) {
+    int err = k_thread_cpu_pin(t, cpu);
+    if (err) printk("SMP pin %s -> CPU%d failed (%d)\n", name, cpu, err);
+}
 
+static void smp_pin(void) {
+    smp_pin_one(uart_thread,       "uart",     CONFIG_LV_CPU_INPUT);
+    smp_pin_one(debug_thread,      "debug",    CONFIG_LV_CPU_INPUT);
+    smp_pin_one(k_work_queue_thread_get(&k_sys_work_q), "sysworkq", CONFIG_LV_CPU_INPUT);
+    smp_pin_one(dispatcher_thread, "dispatcher", CONFIG_LV_CPU_LIGHT);
+    smp_pin_one(red_thread,        "red",      CONFIG_LV_CPU_LIGHT);
+    smp_pin_one(yellow_thread,     "yellow",   CONFIG_LV_CPU_LIGHT);
+    smp_pin_one(green_thread,      "green",    CONFIG_LV_CPU_LIGHT);
+    printk("SMP %u CPUs: input CPU%d, light CPU%d\n", arch_num_cpus(),
+           CONFIG_LV_CPU_INPUT, CONFIG_LV_CPU_LIGHT);
+}
+#endif
+
+// Käynnistys vaiheittain, valot ensin: aika ensimmäiseen ohjattuun valoon
+// minimoidaan, ja säie käynnistyy vasta kun sen laitteet on alustettu (B: raportti)
+#if defined(CONFIG_LV_WCET)
+static void wcet_main(void);
+#endif
 
 int main(void)
 {
-    k_timer_init(&timer, timer_handler, NULL);
-
+    boot_mark(BOOT_MAIN, 0);
+#if defined(CONFIG_LV_SMP_PIN)
+    smp_pin();
+#endif
+    wc_init(wall_emit);
+    inputs_init(input_emit);
+    sched_init(plan_emit);
+    ingress_init(ingress_emit);
+    // Tilaajat ennen LED-taskeja, muuten LB_START-tietueet ohitettaisiin
+    lb_sub_thread(&dbg_sub, "debug");
+    k_thread_start(debug_thread);
+    lightstats_init();
+#if defined(CONFIG_TRACING)
+    lb_sub_listen(&trace_sub, "trace", trace_listen);
+#endif
+    retain_init();
+    deadline_init(LIGHT_MS);
     timing_init();
     timing_start();
-    init_uart();
-    init_led();
-    init_buttons();
+    boot_mark(BOOT_TIMING, 0);
+#if defined(CONFIG_LV_WCET)
+    // Mittausajo: säikeet jäävät käynnistämättä, käsittelijät ajetaan eristettyinä
+    wcet_main();
+    return 0;
+#endif
+
+    int err = init_led();
+    boot_mark(BOOT_LED, err);
+    if (err == 0) {
+        k_thread_start(red_thread);
+        k_thread_start(yellow_thread);
+        k_thread_start(green_thread);
+        k_thread_start(dispatcher_thread);
+        boot_mark(BOOT_LED_THREADS, 0);
+    } else {
+        printk("LED init failed (%d), sequencer not started\n", err);
+    }
+
+    if (!retain_restore()) plan_boot();
+    boot_mark(BOOT_RESTORE, 0);
+
+    err = init_uart();
+    boot_mark(BOOT_UART, err);
+    if (err == 0) {
+        k_thread_start(uart_thread);
+        boot_mark(BOOT_UART_THREAD, 0);
+    } else {
+        printk("UART init failed (%d), no command input\n", err);
+    }
+
+    // napit eivät käynnistä säiettä: virhe vain raporttiin
+    err = inputs_start();
+    boot_mark(BOOT_BUTTONS, err);
+    if (err) printk("Button init failed (%d)\n", err);
     return 0;
 }
 
 //Initit
+#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+static void uart_rx_isr(const struct device *dev, void *user_data) {
+    ARG_UNUSED(user_data);
+    if (!uart_irq_update(dev)) return;
+
+    while (uart_irq_rx_ready(dev)) {
+        uint8_t *dst;
+        uint32_t room = ring_buf_put_claim(&rx_ring, &dst, RX_RING_SIZE);
+        if (room == 0) {            // rengas täynnä: tavu hukataan
+            uint8_t junk;
+            drop_count(DROP_RX_OVERRUN);
+            if (uart_fifo_read(dev, &junk, 1) <= 0) break;
+            continue;
+        }
+        int n = uart_fifo_read(dev, dst, (int)room);
+        ring_buf_put_finish(&rx_ring, n > 0 ? (uint32_t)n : 0);
+        if (n <= 0) break;
+    }
+    k_sem_give(&rx_sem);
+}
+#endif
+
 static int init_uart(void) {
     if (!device_is_ready(uart_dev)) {
         PRINTK("UART device not ready\n");
         return -ENODEV;
     }
+#ifdef CONFIG_UART_INTERRUPT_DRIVEN
+    // ajuri ilman keskeytystukea (-ENOSYS) -> jäädään pollaukseen
+    if (uart_irq_callback_user_data_set(uart_dev, uart_rx_isr, NULL) == 0) {
+        uart_irq_rx_enable(uart_dev);
+        atomic_set(&rx_irq, 1);
+    }
+#endif
     return 0;
 }
 static int init_led(void) {
@@ -196,165 +344,531 @@ static int init_led(void) {
     PRINTK("LEDs configured\n");
     return 0;
 }
-static int init_buttons(void) {
-    int ret;
+//UART taski
+// - R/Y/G: syttyy heti ja timer_color päivittyy viimeisimmän värin mukaan
+// - D: debug toggle
+// - S: säiketilastot (CPU, ajoikkunat, pinon huippu)
+// - M: deadline-ohitukset ja pahimmat tapaukset
+// - X: hätä-punainen prioriteettikaistaan, !R/!Y/!G: väri prioriteettikaistaan
+// - C + HHMMSS[mmm] + rivinvaihto: seinäkello hostin ajasta, toistuva synkkaus
+//   korjaa kiteen ryömimisen (wallclock.h)
+// - ISO A + HHMMSS: laukaisu kellonaikaan timer_colorilla, toistuu päivittäin;
+//   A. poistaa kaikki, A? kello ja laukaisut
+// - 0xA5-kehys: binäärikomentoerä (frame.h), vastaus ACK/NAK <seq>
+// - P<nimi>=<ohjelma>: käännä ja tallenna (program.h), P<nimi>+rivinvaihto: aja, P.: pysäytä
+// - F: profiloija päälle / pois + näytteiden dumppaus (profiler.h)
+// - E: hukatut tapahtumat syittäin + FIFOjen syvyys ja huippu (drops.h)
+// - L<suunnitelma>: lataus passiiviseen pankkiin, vaihto askeleen rajalla
+//   (schedule.h), L. pysäyttää, L? tila
+// - W: lämmin uudelleenkäynnistys, tila palautuu __noinit-RAMista (retain.h)
+// - V: ajossa oleva suunnitelma flashiin (planstore.h), ajetaan bootissa
+// - B: käynnistyksen vaiheiden aikaleimat (bootprof.h)
+// - I: sisääntulon rajoitin lähteittäin: tokenit, pidetyt, hylätyt (ingress.h)
+// - T: valovaiheiden tilastot ja valoväylän tilaajat (lightstats.h, lightbus.h)
+
+static char time_buf[10];
+static int  time_buf_len = 0;
+static char time_mode = 0;      // 'A' tai 'C' kun aikaa luetaan
+static bool prio_next = false;  // true kun ! tullut
+
+//Ohjelman lataus: P -> nimi -> '=' teksti / rivinvaihto
+enum { PM_OFF = 0, PM_NAME, PM_OP, PM_TEXT };
+#define PROG_SRC_MAX 96
+static uint8_t prog_mode = PM_OFF;
+static char    prog_name;
+static char    prog_src[PROG_SRC_MAX];
+static int     prog_src_len;
+static bool    prog_src_overflow;
 
-    if (!gpio_is_ready_dt(&btn_red) || !gpio_is_ready_dt(&btn_yel) || !gpio_is_ready_dt(&btn_grn)) {
-        PRINTK("Button ports not ready\n");
-        return -ENODEV;
+static inline void time_mode_reset(void) {
+    time_mode   = 0; //tilakone "A":lle ja "C":lle
+    time_buf_len = 0;
+    time_buf[0] = '\0';
+}
+// A: laukaisu kellonaikaan secs (vuorokauden alusta)
+static void timer_set(int secs) {
+    retain_timer(timer_color);
+    int err = wc_add((uint32_t)secs, timer_color);
+    if (err == -EAGAIN) {
+        drop_count(DROP_BAD_TIME);
+        printk("WALL clock not set\n");
+    } else if (err == -ENOMEM) {
+        printk("WALL trigger list full\n");
+    } else {
+        PRINTK("WALL %02d:%02d:%02d -> %c\n", secs / 3600, secs / 60 % 60, secs % 60, timer_color);
     }
-    ret = gpio_pin_configure_dt(&btn_red, GPIO_INPUT);  if (ret) return ret;
-    ret = gpio_pin_configure_dt(&btn_yel, GPIO_INPUT);  if (ret) return ret;
-    ret = gpio_pin_configure_dt(&btn_grn, GPIO_INPUT);  if (ret) return ret;
-
-    ret = gpio_pin_interrupt_configure_dt(&btn_red, GPIO_INT_EDGE_TO_ACTIVE); if (ret) return ret;
-    ret = gpio_pin_interrupt_configure_dt(&btn_yel, GPIO_INT_EDGE_TO_ACTIVE); if (ret) return ret;
-    ret = gpio_pin_interrupt_configure_dt(&btn_grn, GPIO_INT_EDGE_TO_ACTIVE); if (ret) return ret;
-
-    gpio_init_callback(&btn_red_cb, btn_red_isr, BIT(btn_red.pin));
-    gpio_add_callback(btn_red.port, &btn_red_cb);
+}
 
-    gpio_init_callback(&btn_yel_cb, btn_yel_isr, BIT(btn_yel.pin));
-    gpio_add_callback(btn_yel.port, &btn_yel_cb);
+// C: HHMMSS tai HHMMSSmmm
+static void clock_set(void) {
+    time_buf[time_buf_len] = '\0';
+    int ms = 0;
+    if (time_buf_len == 9) {
+        for (int i = 6; i < 9; ++i) {
+            if (!isdigit((unsigned char)time_buf[i])) { ms = -1; break; }
+            ms = ms * 10 + (time_buf[i] - '0');
+        }
+        time_buf[6] = '\0';
+    } else if (time_buf_len != 6) {
+        ms = -1;
+    }
+    int secs = ms < 0 ? TIME_LEN_ERROR : time_parse(time_buf);
+    if (secs < 0) {
+        drop_count(DROP_BAD_TIME);
+        PRINTK("Invalid clock (ERROR=%d)\n", secs);
+        return;
+    }
+    int32_t err = wc_sync((uint32_t)secs * 1000U + (uint32_t)ms);
+    struct wc_state st;
+    wc_snapshot(&st);
+    printk("CLOCK %02d:%02d:%02d.%03d err %d ms drift %d ppb\n",
+           secs / 3600, secs / 60 % 60, secs % 60, ms, err, st.ppb);
+}
 
-    gpio_init_callback(&btn_grn_cb, btn_grn_isr, BIT(btn_grn.pin));
-    gpio_add_callback(btn_grn.port, &btn_grn_cb);
+// Lämmin käynnistys: edellisen ajon tila takaisin __noinit-RAMista (retain.h)
+// Palauttaa true jos suunnitelma palautettiin
+static bool retain_restore(void) {
+    static struct retain_hot  h;
+    static struct sched_bank plan;
+    uint64_t c0 = dl_stamp();
+
+    if (!retain_boot(&h, &plan)) { printk("RETAIN cold boot\n"); return false; }
+
+    timer_color = h.timer_color;
+    if (h.wall.valid) wc_restore(&h.wall);
+    // kesken jäänyt vaihe ensin, jäljellä olevalla ajalla
+    if (h.cur_col && h.cur_elapsed_ms < h.cur_ms) {
+        seq_enqueue_ms(h.cur_prio ? &prio_fifo : &seq_fifo, h.cur_col, c0,
+                       h.cur_ms - h.cur_elapsed_ms, DROP_NOMEM_UART);
+    }
+    for (uint8_t i = 0; i < h.q_len; ++i) {
+        seq_enqueue(&seq_fifo, h.q[(h.q_head + i) % RETAIN_QMAX], c0, DROP_NOMEM_UART);
+    }
+    retain_timer(timer_color);
+    if (h.plan_gen) sched_restore(&plan, h.plan_idx, MAX(h.plan_rem_ms, 1U));
+
+    uint32_t us = (uint32_t)dl_to_us(dl_stamp() - c0);
+    printk("RETAIN warm boot %u: phase %c %u ms left, %u queued, wall %s %u triggers, plan gen %u (%u us)\n",
+           h.warm_boots + 1, h.cur_col ? h.cur_col : '-',
+           h.cur_col ? h.cur_ms - h.cur_elapsed_ms : 0, h.q_len,
+           h.wall.valid ? "set" : "unset", h.wall.n, h.plan_gen, us);
+    return h.plan_gen != 0;
+}
 
-    printk("Buttons configured (R/Y/G)\n");
-    return 0;
+// Flashiin tallennettu suunnitelma käyntiin heti bootissa (planstore.h)
+static void plan_boot(void) {
+    static struct sched_bank plan;
+    int n = plan_store_load(&plan);
+    if (n <= 0) {
+        if (n < 0 && n != -ENOTSUP) printk("NVS plan load failed (%d)\n", n);
+        return;
+    }
+    sched_restore(&plan, 0, plan.step[0].delay_s * 1000U);
+    printk("NVS plan %d steps started\n", n);
 }
 
-//Button ISR + work-funktiot (R/Y/G)
+// V: ajossa oleva suunnitelma flashiin, ei suunnitelmaa -> tallennus pois
+static void plan_save(void) {
+    uint8_t idx;
+    uint32_t rem;
+    const struct sched_bank *b = sched_active_bank(&idx, &rem);
+    int err = plan_store_save(b);
+    if (err)    printk("NVS plan save failed (%d)\n", err);
+    else if (b) printk("NVS plan saved %u steps\n", b->n);
+    else        printk("NVS plan erased\n");
+}
 
-static void btn_red_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins) {
-    ARG_UNUSED(dev); ARG_UNUSED(cb); ARG_UNUSED(pins);
-    k_work_submit(&red_work);
+#if defined(CONFIG_ARCH_POSIX) || defined(CONFIG_LV_WCET)
+// Tavallinen jono tyhjäksi (native_sim-reset, WCET-mittauksen teardown)
+static void seq_drain(void) {
+    struct seq_item *it;
+    while ((it = k_fifo_get(&seq_fifo, K_NO_WAIT)) != NULL) {
+        fifo_deq(FQ_SEQ, 1);
+        k_free(it);
+    }
 }
-static void btn_yel_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins) {
-    ARG_UNUSED(dev); ARG_UNUSED(cb); ARG_UNUSED(pins);
-    k_work_submit(&yel_work);
+#endif
+
+static void warm_restart(void) {
+    retain_dump();
+#if defined(CONFIG_ARCH_POSIX)
+    // native_sim: prosessi ei säilytä RAMia resetin yli -> emuloidaan:
+    // tila jäädytetään, elävä tila pois (ajastimet, jono, vaihe) ja
+    // palautetaan samalla polulla kuin bootissa
+    retain_freeze();
+    wc_reset();
+    sched_reset();
+    seq_drain();
+    if (retain_phase_active()) k_sem_give(&abort_sem);   // käynnissä oleva vaihe katkeaa
+    retain_restore();
+#else
+    k_msleep(10);   // tulosteet ulos
+    sys_reboot(SYS_REBOOT_WARM);
+#endif
 }
-static void btn_grn_isr(const struct device *dev, struct gpio_callback *cb, uint32_t pins) {
-    ARG_UNUSED(dev); ARG_UNUSED(cb); ARG_UNUSED(pins);
-    k_work_submit(&grn_work);
+
+static void uart_handle_prog(unsigned char urc) {
+    bool eol = (urc == '\r' || urc == '\n');
+
+    switch (prog_mode) {
+    case PM_NAME:
+        prog_mode = PM_OFF;
+        if (urc == '.') { prog_stop(); printk("PROG stop\n"); return; }
+        if (!isalnum(urc)) { printk("PROG bad name\n"); return; }
+        prog_name = (char)toupper(urc);
+        prog_mode = PM_OP;
+        return;
+    case PM_OP:
+        prog_mode = PM_OFF;
+        if (urc == '=') {
+            prog_src_len = 0;
+            prog_src_overflow = false;
+            prog_mode = PM_TEXT;
+        } else if (eol) {
+            if (prog_run(prog_name) == 0) {
+                k_sem_give(&prog_sem);
+                printk("PROG %c run\n", prog_name);
+            } else {
+                printk("PROG %c not found\n", prog_name);
+            }
+        } else {
+            printk("PROG bad op\n");
+        }
+        return;
+    case PM_TEXT:
+        if (!eol) {
+            if (prog_src_len < PROG_SRC_MAX) prog_src[prog_src_len++] = (char)urc;
+            else prog_src_overflow = true;
+            return;
+        }
+        prog_mode = PM_OFF;
+        if (prog_src_overflow) { printk("PROG %c too long\n", prog_name); return; }
+        int n = prog_store(prog_name, prog_src, (size_t)prog_src_len);
+        if (n > 0) printk("PROG %c ok %d insn\n", prog_name, n);
+        else if (n == -ENOMEM) printk("PROG %c no slot\n", prog_name);
+        else printk("PROG %c error at %d\n", prog_name, -n - 1);
+        return;
+    default:
+        prog_mode = PM_OFF;
+        return;
+    }
 }
 
-static void red_work_fn(struct k_work *work) {
-    struct seq_item *item = k_malloc(sizeof(*item));
-    if (item) { item->value = 'R'; k_fifo_put(&seq_fifo, item); PRINTK("BTN -> R\n"); }
+//Suunnitelman lataus: merkit suoraan passiiviseen pankkiin
+static bool plan_first;
+
+static void uart_handle_plan(unsigned char urc) {
+    bool first = plan_first;
+    plan_first = false;
+    if (first && urc == '?') { sched_load_abort(); sched_dump(); return; }
+    if (urc != '\r' && urc != '\n') { sched_load_feed((char)urc); return; }
+
+    int n = sched_load_end();
+    if (n > 0)       printk("PLAN ok %d steps\n", n);
+    else if (n == 0) printk("PLAN stop\n");
+    else             printk("PLAN error at %d\n", -n - 1);
 }
-static void yel_work_fn(struct k_work *work) {
-    struct seq_item *item = k_malloc(sizeof(*item));
-    if (item) { item->value = 'Y'; k_fifo_put(&seq_fifo, item); PRINTK("BTN -> Y\n"); }
+
+// Edellisen kehyksen seq (uudelleenlähetys = dup), 'N' nollaa
+static int last_frame_seq = -1;
+
+// Yksi ASCII-merkki
+static void uart_handle_ascii(unsigned char urc, uint64_t t_in) {
+    if (prog_mode) { uart_handle_prog(urc); return; }
+    if (sched_loading()) { uart_handle_plan(urc); return; }
+    if (time_mode == 'C') {
+        if (urc == '\r' || urc == '\n') { clock_set(); time_mode_reset(); return; }
+        if (time_buf_len < 9) time_buf[time_buf_len++] = (char)urc;
+        if (time_buf_len == 9) { clock_set(); time_mode_reset(); }
+        return;
+    }
+    if (time_mode) {
+        if (urc == '\r' || urc == '\n') { time_mode_reset(); return; }
+        if (time_buf_len == 0 && urc == '.') { wc_clear(); printk("WALL cleared\n"); time_mode_reset(); return; }
+        if (time_buf_len == 0 && urc == '?') { wc_dump(); time_mode_reset(); return; }
+        if (time_buf_len < 6) time_buf[time_buf_len++] = (char)urc;
+        if (time_buf_len == 6) {
+            time_buf[6] = '\0';
+            int secs = time_parse(time_buf);  // validoinnit timeparsessa
+            if (secs >= 0) {
+                timer_set(secs);
+            } else {
+                drop_count(DROP_BAD_TIME);
+                PRINTK("Invalid time '%s' (ERROR=%d)\n", time_buf, secs);
+            }
+            time_mode_reset();
+        }
+        return;
+    }
+    char c = (char)toupper(urc);
+    if (c == 'A' || c == 'C') { time_mode_reset(); time_mode = c; return; }
+    if (c == 'P') { prog_mode = PM_NAME; return; }
+    if (c == 'L') { sched_load_begin(); plan_first = true; return; }
+    if (c == '!') { prio_next = true; return; }
+    if (c == 'X') { prio_next = true; c = 'R'; }
+    if (c == 'R' || c == 'Y' || c == 'G') {
+        if (prio_next) {
+            prio_next = false;
+            seq_enqueue(&prio_fifo, c, t_in, DROP_NOMEM_UART);
+        } else {
+            timer_color = c;
+            retain_timer(c);
+            ingress_submit(ING_UART, c, t_in);
+        }
+        return;
+    }
+    prio_next = false;
+    if (c == 'D') {
+        bool new_state = !atomic_get(&dbg_on);
+        lb_publish(LB_DEBUG, new_state ? '1' : '0', 0, 0, false);   // '1' = ON, '0' = OFF
+        atomic_set(&dbg_on, new_state);
+        return;
+    }
+    if (c == 'S') { thread_stats_dump(); return; }
+    if (c == 'M') { deadline_dump();     return; }
+    if (c == 'F') {
+        if (prof_running()) { prof_stop(); prof_dump(); }
+        else { prof_start(); printk("PROF start\n"); }
+        return;
+    }
+    if (c == 'E') { drops_dump(); return; }
+    if (c == 'W') { warm_restart(); return; }
+    if (c == 'V') { plan_save();    return; }
+    if (c == 'B') { boot_report();  return; }
+    if (c == 'I') { ingress_dump(); return; }
+    if (c == 'T') { lightstats_dump(); lb_dump(); return; }
+    if (c == 'N') { last_frame_seq = -1; printk("SESSION\n"); return; }   // uusi host-istunto
+    if (!isspace(urc)) drop_count(DROP_UNKNOWN_CHAR);
 }
-static void grn_work_fn(struct k_work *work) {
-    struct seq_item *item = k_malloc(sizeof(*item));
-    if (item) { item->value = 'G'; k_fifo_put(&seq_fifo, item); PRINTK("BTN -> G\n"); }
+
+// Valmis kehys: koko erä jonoon yhdellä k_fifo_put_listillä per jono
+
+static void uart_handle_frame(struct frame_rx *rx, uint64_t t_in) {
+    if (rx->seq == last_frame_seq) {      // uudelleenlähetys, ei jonoon toista kertaa
+        printk("ACK %u %u dup\n", rx->seq, rx->ncmd);
+        return;
+    }
+    struct seq_item *head = NULL, *tail = NULL;
+    struct seq_item *phead = NULL, *ptail = NULL;
+    int queued = 0, nprio = 0, nseq = 0;
+
+    // Rajoitin koko erälle: tokenit riittävät alkuosalle, loput hylätään
+    for (int i = 0; i < rx->ncmd; ++i) {
+        if (rx->cmd[i].op != 'A' && !rx->cmd[i].prio) nseq++;
+    }
+    int allow = ingress_take(ING_FRAME, nseq);
+
+    for (int i = 0; i < rx->ncmd; ++i) {
+        const struct frame_cmd *fc = &rx->cmd[i];
+        if (fc->op == 'A') { timer_set(fc->secs); continue; }
+        if (!fc->prio && allow-- <= 0) continue;
+
+        struct seq_item *it = k_malloc(sizeof(*it));
+        if (!it) { drop_add(DROP_NOMEM_UART, rx->ncmd - i); break; }
+        it->value = fc->op;
+        it->t_in  = t_in;
+        it->ms    = 0;
+        it->fifo_reserved = NULL;
+        TRACE_EV("cmd_in", fc->op, t_in);
+        if (fc->prio) {
+            if (ptail) ptail->fifo_reserved = it; else phead = it;
+            ptail = it;
+        } else {
+            timer_color = fc->op;
+            retain_timer(fc->op);
+            retain_q_push(fc->op);
+            if (tail) tail->fifo_reserved = it; else head = it;
+            tail = it;
+        }
+        if (fc->prio) nprio++;
+        queued++;
+    }
+    if (phead) { fifo_enq(FQ_PRIO, nprio);          k_fifo_put_list(&prio_fifo, phead, ptail); }
+    if (head)  { fifo_enq(FQ_SEQ, queued - nprio);  k_fifo_put_list(&seq_fifo, head, tail); }
+
+    // jonoon yhteensä ja niistä prio: rajoitin ohittaa normaaleja, ei prioja,
+    // joten host ei voi päätellä jonoon menneitä pelkästä määrästä
+    last_frame_seq = rx->seq;
+    printk("ACK %u %d %d\n", rx->seq, queued, nprio);
 }
 
-//UART taski
-// - R/Y/G: syttyy heti ja timer_color päivittyy viimeisimmän värin mukaan
-// - D: debug toggle
-// - ISO A + HHMMSS: timemode päivittyy--> ajastin käyntiin-->timer_color Viikko5
+// Odottaa RX-dataa; palauttaa false jos mitään ei tullut
+static bool uart_rx_wait(void) {
+    if (!ring_buf_is_empty(&rx_ring)) return true;
+    if (atomic_get(&rx_irq)) return k_sem_take(&rx_sem, K_MSEC(FRAME_TIMEOUT_MS)) == 0;
 
-static char time_buf[7];
-static int  time_buf_len = 0;
-static bool time_mode = false;  // true kun A tullut
+    unsigned char rc;
+    bool got = false;
+    while (ring_buf_space_get(&rx_ring) > 0 && uart_poll_in(uart_dev, &rc) == 0) {
+        ring_buf_put(&rx_ring, &rc, 1);
+        got = true;
+    }
+    if (!got) k_msleep(5);
+    return got;
+}
 
-static inline void time_mode_reset(void) {
-    time_mode   = false; //tilakone "A":lle
-    time_buf_len = 0;
-    time_buf[0] = '\0';
+static struct frame_rx frx;
+
+// Yksi vastaanotettu tavu: kehyksen jatko, kehyksen alku tai ASCII-komento
+static void uart_rx_byte(uint8_t b, uint64_t t_in) {
+    if (frame_active(&frx)) {
+        enum frame_result r = frame_feed(&frx, b);
+        if (r == FRAME_OK) uart_handle_frame(&frx, t_in);
+        else if (r != FRAME_MORE) { drop_count(DROP_BAD_FRAME); printk("NAK %u %d\n", frx.seq, r); }
+    } else if (b == FRAME_SYNC && !time_mode && !prog_mode && !sched_loading()) {
+        frame_start(&frx);
+    } else {
+        uart_handle_ascii(b, t_in);
+    }
 }
+
 void uart_task(void *a, void *b, void *c) {
     ARG_UNUSED(a); ARG_UNUSED(b); ARG_UNUSED(c);
-    char rc;
+    uint32_t last_rx_ms = 0;
+
+    boot_mark(BOOT_READY, 0);
+    printk("BOOT ready %u us\n", boot_us(BOOT_READY));
 
     while (1) {
-        if (uart_poll_in(uart_dev, &rc) == 0) {
-            unsigned char urc = (unsigned char)rc;
-
-            if (time_mode) {
-                if (urc == '\r' || urc == '\n') { time_mode_reset(); continue; }
-                if (time_buf_len < 6) time_buf[time_buf_len++] = (char)urc;
-                if (time_buf_len == 6) {
-                    time_buf[6] = '\0';
-                    int secs = time_parse(time_buf);  // validoinnit timeparsessa
-                    if (secs >= 0) {
-                        timer_delay_s = secs;
-                        k_timer_stop(&timer);
-                        k_timer_start(&timer, K_SECONDS(timer_delay_s), K_NO_WAIT);
-                    } else {
-                        PRINTK("Invalid time '%s' (ERROR=%d)\n", time_buf, secs);
-                    }
-                    time_mode_reset();
-                }
-                continue;
-            }
-            char c = (char)toupper(urc);
-            if (c == 'A') { time_mode_reset(); time_mode = true; continue; }
-            if (c == 'R' || c == 'Y' || c == 'G') {
-                timer_color = c;
-                struct seq_item *item = k_malloc(sizeof(*item));
-                if (item) { item->value = c; k_fifo_put(&seq_fifo, item); }
-                continue;
-            }
-            if (c == 'D') {
-                bool new_state = !dbg_on;
-                struct taskdbg_msg *m = k_malloc(sizeof(*m));
-                if (m) {
-                    m->ev  = 'D';
-                    m->col = new_state ? '1' : '0';   // '1' = ON, '0' = OFF
-                    k_fifo_put(&taskdbg_fifo, m);
-                }
-                dbg_on = new_state; 
-                continue;
+        if (!uart_rx_wait()) {
+            if (frame_active(&frx) && k_uptime_get_32() - last_rx_ms > FRAME_TIMEOUT_MS) {
+                frame_reset(&frx);
+                drop_count(DROP_BAD_FRAME);
+                printk("NAK timeout\n");
             }
+            continue;
+        }
+        last_rx_ms = k_uptime_get_32();
+
+        uint8_t *p;
+        uint32_t n;
+        while ((n = ring_buf_get_claim(&rx_ring, &p, RX_RING_SIZE)) > 0) {
+            uint64_t t_in = dl_stamp();
+            for (uint32_t i = 0; i < n; ++i) uart_rx_byte(p[i], t_in);
+            ring_buf_get_finish(&rx_ring, n);
         }
-        k_msleep(5);
     }
 }
 // Dispatcher + LED taskit
+// Käynnistettävä vaihe
+struct phase_req {
+    char col;
+    bool prio;
+    uint32_t ms;
+    uint64_t t_in;
+};
+
+// Edellinen tavallinen vaihe oli ohjelman askel (vuorottelu, program.h)
+static bool prog_last;
+
+// Seuraava vaihe: prio_fifo ensin, sitten ajossa oleva ohjelma ja seq_fifo
+// vuorotellen, ettei ohjelma (x0) näännytä UARTia, nappeja ja ajastimia
+static void dispatcher_next(struct phase_req *rq) {
+    struct k_poll_event ev[3] = {
+        K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_FIFO_DATA_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, &prio_fifo),
+        K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_FIFO_DATA_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, &seq_fifo),
+        K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SEM_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, &prog_sem),
+    };
+    while (1) {
+        struct seq_item *it = k_fifo_get(&prio_fifo, K_NO_WAIT);
+        if (it) fifo_deq(FQ_PRIO, 1);
+        if (!it) {
+            k_sem_take(&prog_sem, K_NO_WAIT);
+            bool seq_turn = prog_last && !k_fifo_is_empty(&seq_fifo);
+            if (!seq_turn && prog_next(&rq->col, &rq->ms, LIGHT_MS)) {
+                prog_last = true;
+                rq->prio = false;
+                rq->t_in = dl_stamp();   // ohjelman askel: ei jonoviivettä
+                return;
+            }
+            it = k_fifo_get(&seq_fifo, K_NO_WAIT);
+            if (it) { fifo_deq(FQ_SEQ, 1); retain_q_pop(); rq->prio = false; prog_last = false; }
+        } else {
+            rq->prio = true;
+        }
+        if (it) {
+            rq->col  = it->value;
+            rq->ms   = it->ms ? it->ms : LIGHT_MS;
+            rq->t_in = it->t_in;
+            k_free(it);
+            return;
+        }
+        ev[0].state = K_POLL_STATE_NOT_READY;
+        ev[1].state = K_POLL_STATE_NOT_READY;
+        ev[2].state = K_POLL_STATE_NOT_READY;
+        k_poll(ev, 3, K_FOREVER);
+    }
+}
+// Odottaa vaiheen loppua; prioriteettikomento katkaisee tavallisen vaiheen heti
+static void dispatcher_wait_release(bool prio) {
+    if (!prio) {
+        struct k_poll_event ev[2] = {
+            K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_SEM_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, &release_sem),
+            K_POLL_EVENT_INITIALIZER(K_POLL_TYPE_FIFO_DATA_AVAILABLE, K_POLL_MODE_NOTIFY_ONLY, &prio_fifo),
+        };
+        k_poll(ev, 2, K_FOREVER);
+        if (ev[0].state != K_POLL_STATE_SEM_AVAILABLE) {
+            k_sem_give(&abort_sem);
+            PRINTK("Preempt -> abort phase\n");
+        }
+    }
+    k_sem_take(&release_sem, K_FOREVER);
+    // vaihe saattoi päättyä samalla kun abort annettiin
+    k_sem_reset(&abort_sem);
+}
+
+// Vaihe käyntiin: LED-taski herätetään; false = tuntematon väri, ei vaihetta
+static bool dispatcher_step(const struct phase_req *rq) {
+    char ch = rq->col;
+    deadline_check(DL_INPUT_DISPATCH, rq->t_in, ch);
+    TRACE_EV("cmd_disp", ch, rq->t_in);
+    phase_ms = rq->ms;
+    phase_id = (uint32_t)rq->t_in;
+    retain_phase_start(ch, rq->prio, rq->ms);
+    disp_t = dl_stamp();
+
+    switch (ch) {
+        case 'R':
+            k_mutex_lock(&red_mutex, K_FOREVER);
+            red_trig = true;
+            k_condvar_signal(&red_cv);
+            k_mutex_unlock(&red_mutex);
+            PRINTK("Dispatch -> RED\n");
+            break;
+        case 'Y':
+            k_mutex_lock(&yellow_mutex, K_FOREVER);
+            yel_trig = true;
+            k_condvar_signal(&yellow_cv);
+            k_mutex_unlock(&yellow_mutex);
+            PRINTK("Dispatch -> YELLOW\n");
+            break;
+        case 'G':
+            k_mutex_lock(&green_mutex, K_FOREVER);
+            grn_trig = true;
+            k_condvar_signal(&green_cv);
+            k_mutex_unlock(&green_mutex);
+            PRINTK("Dispatch -> GREEN\n");
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
 static void dispatcher_task(void *a, void *b, void *c) {
     ARG_UNUSED(a); ARG_UNUSED(b); ARG_UNUSED(c);
     PRINTK("Dispatcher started\n");
 
     while (1) {
-        struct seq_item *it = k_fifo_get(&seq_fifo, K_FOREVER);
-        char ch = it->value;
-        k_free(it);
-
-        switch (ch) {
-            case 'R':
-                k_mutex_lock(&red_mutex, K_FOREVER);
-                red_trig = true;
-                k_condvar_signal(&red_cv);
-                k_mutex_unlock(&red_mutex);
-                PRINTK("Dispatch -> RED\n");
-                break;
-            case 'Y':
-                k_mutex_lock(&yellow_mutex, K_FOREVER);
-                yel_trig = true;
-                k_condvar_signal(&yellow_cv);
-                k_mutex_unlock(&yellow_mutex);
-                PRINTK("Dispatch -> YELLOW\n");
-                break;
-            case 'G':
-                k_mutex_lock(&green_mutex, K_FOREVER);
-                grn_trig = true;
-                k_condvar_signal(&green_cv);
-                k_mutex_unlock(&green_mutex);
-                PRINTK("Dispatch -> GREEN\n");
-                break;
-            default:
-                continue;
-        }
-        k_sem_take(&release_sem, K_FOREVER);
+        struct phase_req rq;
+        dispatcher_next(&rq);
+        if (!dispatcher_step(&rq)) continue;
+        dispatcher_wait_release(rq.prio);
     }
 }
 
 static void red_led_task(void *, void *, void*) {
-    taskdbg_push('S','R');
+    lb_publish(LB_START, 'R', 0, 0, false);
     while (1) {
         k_mutex_lock(&red_mutex, K_FOREVER);
         while (!red_trig) {
@@ -364,25 +878,28 @@ static void red_led_task(void *, void *, void*) {
         k_mutex_unlock(&red_mutex);
 
         timing_t t0 = timing_counter_get();
-        taskdbg_push('1','R');
         gpio_pin_set_dt(&red, 1);
-        k_msleep(LIGHT_MS);
-        taskdbg_push('0','R');
+        uint64_t on_t = dl_stamp();
+        boot_mark(BOOT_FIRST_LIGHT, 0);
+        uint32_t id   = phase_id;
+        lb_publish(LB_ON, 'R', id, 0, false);
+        deadline_check(DL_DISPATCH_ON, disp_t, 'R');
+        uint32_t ms = phase_ms;
+        bool aborted = (k_sem_take(&abort_sem, K_MSEC(ms)) == 0);
         gpio_pin_set_dt(&red, 0);
         timing_t t1 = timing_counter_get();
 
         uint64_t ns   = timing_cycles_to_ns(timing_cycles_get(&t0, &t1));
-        uint64_t usec = ns / 1000ULL;
-
-        struct meas_item *m = k_malloc(sizeof(*m));
-        if (m) { m->value = 'R'; m->usec = usec; k_fifo_put(&meas_fifo, m); }
+        lb_publish(LB_OFF, 'R', id, (uint32_t)(ns / 1000ULL), aborted);
+        if (!aborted) deadline_check_len(DL_PHASE, on_t, ms, 'R');
 
+        retain_phase_end();
         k_sem_give(&release_sem);
     }
 }
 
 static void yellow_led_task(void *, void *, void*) {
-    taskdbg_push('S','Y');
+    lb_publish(LB_START, 'Y', 0, 0, false);
     while (1) {
         k_mutex_lock(&yellow_mutex, K_FOREVER);
         while (!yel_trig) {
@@ -392,27 +909,30 @@ static void yellow_led_task(void *, void *, void*) {
         k_mutex_unlock(&yellow_mutex);
 
         timing_t t0 = timing_counter_get();
-        taskdbg_push('1','Y');
         gpio_pin_set_dt(&red, 1);
         gpio_pin_set_dt(&green, 1);
-        k_msleep(LIGHT_MS);
-        taskdbg_push('0','Y');
+        uint64_t on_t = dl_stamp();
+        boot_mark(BOOT_FIRST_LIGHT, 0);
+        uint32_t id   = phase_id;
+        lb_publish(LB_ON, 'Y', id, 0, false);
+        deadline_check(DL_DISPATCH_ON, disp_t, 'Y');
+        uint32_t ms = phase_ms;
+        bool aborted = (k_sem_take(&abort_sem, K_MSEC(ms)) == 0);
         gpio_pin_set_dt(&red, 0);
         gpio_pin_set_dt(&green, 0);
         timing_t t1 = timing_counter_get();
 
         uint64_t ns   = timing_cycles_to_ns(timing_cycles_get(&t0, &t1));
-        uint64_t usec = ns / 1000ULL;
-
-        struct meas_item *m = k_malloc(sizeof(*m));
-        if (m) { m->value = 'Y'; m->usec = usec; k_fifo_put(&meas_fifo, m); }
+        lb_publish(LB_OFF, 'Y', id, (uint32_t)(ns / 1000ULL), aborted);
+        if (!aborted) deadline_check_len(DL_PHASE, on_t, ms, 'Y');
 
+        retain_phase_end();
         k_sem_give(&release_sem);
     }
 }
 
 static void green_led_task(void *, void *, void*) {
-    taskdbg_push('S','G');
+    lb_publish(LB_START, 'G', 0, 0, false);
     while (1) {
         k_mutex_lock(&green_mutex, K_FOREVER);
         while (!grn_trig) {
@@ -422,67 +942,59 @@ static void green_led_task(void *, void *, void*) {
         k_mutex_unlock(&green_mutex);
 
         timing_t t0 = timing_counter_get();
-        taskdbg_push('1','G');
         gpio_pin_set_dt(&green, 1);
-        k_msleep(LIGHT_MS);
-        taskdbg_push('0','G');
+        uint64_t on_t = dl_stamp();
+        boot_mark(BOOT_FIRST_LIGHT, 0);
+        uint32_t id   = phase_id;
+        lb_publish(LB_ON, 'G', id, 0, false);
+        deadline_check(DL_DISPATCH_ON, disp_t, 'G');
+        uint32_t ms = phase_ms;
+        bool aborted = (k_sem_take(&abort_sem, K_MSEC(ms)) == 0);
         gpio_pin_set_dt(&green, 0);
         timing_t t1 = timing_counter_get();
 
         uint64_t ns   = timing_cycles_to_ns(timing_cycles_get(&t0, &t1));
-        uint64_t usec = ns / 1000ULL;
-
-        struct meas_item *m = k_malloc(sizeof(*m));
-        if (m) { m->value = 'G'; m->usec = usec; k_fifo_put(&meas_fifo, m); }
+        lb_publish(LB_OFF, 'G', id, (uint32_t)(ns / 1000ULL), aborted);
+        if (!aborted) deadline_check_len(DL_PHASE, on_t, ms, 'G');
 
+        retain_phase_end();
         k_sem_give(&release_sem);
     }
 }
 //Debug taski
+static const char *col_name(char c) {
+    switch (c) {
+    case 'R': return "RED";
+    case 'Y': return "YELLOW";
+    case 'G': return "GREEN";
+    }
+    return "?";
+}
+
 static void debug_task(void *, void *, void *) {
     static uint8_t  seq_count = 0;
     static uint64_t seq_sum_us = 0;
 
     while (1) {
-        struct taskdbg_msg *m = k_fifo_get(&taskdbg_fifo, K_FOREVER);
-        if (m) {
-            switch (m->ev) {
-            case 'S':
-                switch (m->col) {
-                case 'R': printk("Red task started\n");    break;
-                case 'Y': printk("Yellow task started\n"); break;
-                case 'G': printk("Green task started\n");  break;
-                }
-                break;
-            case '1':
-                switch (m->col) {
-                case 'R': printk("RED ON\n");    break;
-                case 'Y': printk("YELLOW ON\n"); break;
-                case 'G': printk("GREEN ON\n");  break;
-                }
-                break;
-            case '0':
-                switch (m->col) {
-                case 'R': printk("RED OFF\n");    break;
-                case 'Y': printk("YELLOW OFF\n"); break;
-                case 'G': printk("GREEN OFF\n");  break;
-                }
-                break;
-            case 'D':
-                printk("DEBUG %s\n", (m->col=='1') ? "ON" : "OFF");
-                break;
-            default:
-                break;
+        struct light_rec r;
+        if (lb_read(&dbg_sub, &r, K_FOREVER) != 0) continue;
+        switch (r.ev) {
+        case LB_START:
+            if (!atomic_get(&dbg_on)) break;
+            switch (r.col) {
+            case 'R': printk("Red task started\n");    break;
+            case 'Y': printk("Yellow task started\n"); break;
+            case 'G': printk("Green task started\n");  break;
             }
-            k_free(m);
-        }
-
-        struct meas_item *mm;
-        while ((mm = k_fifo_get(&meas_fifo, K_NO_WAIT)) != NULL) {
-            printk("TASK %c time: %llu us\n",
-                   mm->value, (unsigned long long)mm->usec);
-
-            seq_sum_us += mm->usec;
+            break;
+        case LB_ON:
+            if (atomic_get(&dbg_on)) printk("%s ON\n", col_name(r.col));
+            break;
+        case LB_OFF:
+            if (atomic_get(&dbg_on)) printk("%s OFF\n", col_name(r.col));
+            printk("TASK %c time: %u us\n", r.col, r.usec);
+
+            seq_sum_us += r.usec;
             seq_count++;
             if (seq_count == 3) {
                 printk("Total (3 tasks): %llu us\n",
@@ -491,9 +1003,84 @@ static void debug_task(void *, void *, void *) {
                 seq_count = 0;
                 seq_sum_us = 0;
             }
-            k_free(mm);
+            break;
+        case LB_DEBUG:
+            printk("DEBUG %s\n", (r.col=='1') ? "ON" : "OFF");
+            break;
         }
-
-        k_yield();
     }
 }
+
+#if defined(CONFIG_LV_WCET)
+// WCET-tapaukset (wcet.h): jokainen käsittelijä omassa tilassaan, teardown
+// palauttaa jonot ja rajoittimen niin että jokainen toisto kulkee saman polun
+// Syöte-ISR: yksi pinni / portin kaikki pinnit samalla keskeytyksellä
+static void wcet_input_isr(void) {
+    uint32_t m = inputs_wcet_port_mask();
+    inputs_wcet_isr(m & -m);
+}
+static void wcet_input_isr_port(void) { inputs_wcet_isr(inputs_wcet_port_mask()); }
+static void wcet_input_setup(void) {
+    ingress_reset();
+    inputs_wcet_pend_all();
+}
+static void wcet_input_done(void) {
+    inputs_wcet_cancel();
+    seq_drain();
+}
+static void wcet_wall_emit(void) { wall_emit(timer_color, dl_stamp()); }
+
+// A-laukaisun lisäys täyteen listaan vaille yksi: alkuun, kaikki siirtyvät
+static void wcet_wall_setup(void) {
+    wc_reset();
+    wc_sync(0);
+    for (uint32_t i = 1; i < WC_MAX_TRIG; ++i) wc_add(3600U * i, 'R');
+}
+static void wcet_wall_add(void) { wc_add(60, 'G'); }
+
+// Dispatcher: jonossa yksi komento -> otto jonosta + LED-taskin herätys
+static void wcet_disp_setup(void) {
+    seq_enqueue(&seq_fifo, 'R', dl_stamp(), DROP_NOMEM_UART);
+}
+static void wcet_disp_step(void) {
+    struct phase_req rq;
+    dispatcher_next(&rq);
+    dispatcher_step(&rq);
+}
+static void wcet_disp_done(void) {
+    red_trig = false;
+    retain_phase_end();
+}
+
+// uart_task: ASCII-väri ja kehyksen viimeinen tavu (CRC + koko erä jonoon)
+static uint8_t wcet_frame[3 + 3 + 2];
+static void wcet_uart_cmd(void) { uart_rx_byte('R', dl_stamp()); }
+static void wcet_frame_setup(void) {
+    static uint8_t seq;
+    uint8_t *f = wcet_frame;
+    f[0] = FRAME_SYNC; f[1] = 3; f[2] = ++seq;   // eri seq: ei dup-polkua
+    f[3] = 'R'; f[4] = 'Y'; f[5] = 'G';
+    uint16_t crc = crc16_itu_t(0xFFFF, &f[1], 5);
+    f[6] = crc >> 8; f[7] = crc & 0xFF;
+    ingress_reset();
+    for (size_t i = 0; i < sizeof(wcet_frame) - 1; ++i) uart_rx_byte(f[i], dl_stamp());
+}
+static void wcet_frame_last(void) { uart_rx_byte(wcet_frame[sizeof(wcet_frame) - 1], dl_stamp()); }
+
+static const struct wcet_case wcet_cases[] = {
+    { "input_isr",       NULL,           wcet_input_isr,   wcet_input_done },
+    { "input_isr_port",  NULL,           wcet_input_isr_port, wcet_input_done },
+    { "input_drain_all", wcet_input_setup, inputs_wcet_drain, wcet_input_done },
+    { "wall_emit",       ingress_reset,  wcet_wall_emit,   seq_drain },
+    { "wall_add",        wcet_wall_setup, wcet_wall_add,   wc_reset },
+    { "dispatcher_step", wcet_disp_setup, wcet_disp_step,  wcet_disp_done },
+    { "uart_byte_cmd",   ingress_reset,  wcet_uart_cmd,    seq_drain },
+    { "uart_byte_frame", wcet_frame_setup, wcet_frame_last, seq_drain },
+};
+
+static void wcet_main(void) {
+    atomic_val_t dbg = atomic_set(&dbg_on, 0);   // PRINTK pois: mitataan käsittelijä, ei konsolia
+    wcet_run_all(wcet_cases, ARRAY_SIZE(wcet_cases), CONFIG_LV_WCET_ITERATIONS);
+    atomic_set(&dbg_on, dbg);
+}
+#endif
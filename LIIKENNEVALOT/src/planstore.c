@@ -0,0 +1,88 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#include <errno.h>
+#include "planstore.h"
+
+#if defined(CONFIG_SETTINGS)
+#include <zephyr/settings/settings.h>
+
+struct plan_rec {
+    struct plan_rec_hdr hdr;
+    struct sched_step   step[SCHED_MAX_STEPS];
+};
+
+static struct plan_rec rec;     // settings_load kirjoittaa tähän suoraan
+static size_t rec_len;
+static bool   rec_seen;
+
+static uint16_t rec_crc(const struct plan_rec *r) {
+    uint16_t crc = crc16_itu_t(0xFFFF, (const uint8_t *)&r->hdr, offsetof(struct plan_rec_hdr, crc));
+    return crc16_itu_t(crc, (const uint8_t *)r->step, r->hdr.n * sizeof(struct sched_step));
+}
+
+static int plan_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg) {
+    const char *next;
+    if (!settings_name_steq(name, "plan", &next) || next) return -ENOENT;
+    if (len < sizeof(rec.hdr) || len > sizeof(rec)) return -EINVAL;
+
+    ssize_t n = read_cb(cb_arg, &rec, len);
+    if (n < 0) return (int)n;
+    rec_len  = (size_t)n;
+    rec_seen = true;
+    return 0;
+}
+SETTINGS_STATIC_HANDLER_DEFINE(lv_plan, "lv", NULL, plan_set, NULL, NULL);
+
+int plan_store_load(struct sched_bank *out) {
+    int err = settings_subsys_init();
+    if (err) return err;
+    rec_seen = false;
+    err = settings_load_subtree("lv");
+    if (err) return err;
+    if (!rec_seen) return 0;
+
+    // tallennettaessa validoitu: tarkistetaan vain eheys
+    const struct plan_rec_hdr *h = &rec.hdr;
+    if (h->magic != PLAN_REC_MAGIC || h->version != PLAN_REC_VERSION ||
+        h->n == 0 || h->n > SCHED_MAX_STEPS ||
+        rec_len != sizeof(*h) + h->n * sizeof(struct sched_step) ||
+        h->crc != rec_crc(&rec)) {
+        return -EBADMSG;
+    }
+    out->gen  = 1;
+    out->n    = h->n;
+    out->loop = h->loop != 0;
+    memcpy(out->step, rec.step, h->n * sizeof(struct sched_step));
+    return h->n;
+}
+
+int plan_store_save(const struct sched_bank *b) {
+    int err = settings_subsys_init();
+    if (err) return err;
+    if (!b || b->n == 0) return settings_delete("lv/plan");
+
+    memset(&rec, 0, sizeof(rec));
+    rec.hdr.magic   = PLAN_REC_MAGIC;
+    rec.hdr.version = PLAN_REC_VERSION;
+    rec.hdr.n       = b->n;
+    rec.hdr.loop    = b->loop;
+    memcpy(rec.step, b->step, b->n * sizeof(struct sched_step));
+    rec.hdr.crc = rec_crc(&rec);
+    return settings_save_one("lv/plan", &rec, sizeof(rec.hdr) + b->n * sizeof(struct sched_step));
+}
+
+#else
+
+int plan_store_load(struct sched_bank *out) {
+    ARG_UNUSED(out);
+    return -ENOTSUP;
+}
+
+int plan_store_save(const struct sched_bank *b) {
+    ARG_UNUSED(b);
+    return -ENOTSUP;
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef PLANSTORE_H
+#define PLANSTORE_H
+
+#include "schedule.h"
+
+// Suunnitelma flashissa (settings + NVS, avain "lv/plan") valmiiksi
+// validoituna binäärinä: otsake + askeleet (viive s, väri) sellaisenaan.
+// Bootissa tietue luetaan suoraan pankkiin ilman tekstin jäsennystä.
+// native_sim: flash-simulaattori (flash.bin säilyy ajojen välillä).
+
+#define PLAN_REC_MAGIC    0x504C    // "LP"
+#define PLAN_REC_VERSION  1
+
+struct plan_rec_hdr {
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  n;
+    uint8_t  loop;
+    uint8_t  reserved;
+    uint16_t crc;       // CRC-16/CCITT otsakkeen alusta (ilman crc) + askeleet
+};
+
+// Lataa tallennetun suunnitelman; palauttaa askelten määrän,
+// 0 jos tallennusta ei ole, <0 virhe (ei settingsiä, rikkinäinen tietue)
+int plan_store_load(struct sched_bank *out);
+// Tallentaa pankin (validoitu jo latauksessa); n == 0 poistaa tallennuksen
+int plan_store_save(const struct sched_bank *b);
+
+#endif
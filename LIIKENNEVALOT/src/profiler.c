@@ -0,0 +1,106 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#if defined(CONFIG_CPU_CORTEX_M)
+#include <cmsis_core.h>
+#endif
+#include "profiler.h"
+
+struct prof_sample {
+    uint32_t pc;
+    uint16_t tid;       // indeksi prof_threads-taulukkoon
+    uint16_t flags;
+};
+#define PROF_F_NOPC  BIT(0)
+
+static struct prof_sample prof_ring[PROF_RING];
+static uint32_t prof_head;       // kirjoitettuja näytteitä yhteensä
+static uint32_t prof_lost;       // ylikirjoitetut
+static k_tid_t  prof_threads[PROF_MAX_THREADS];
+static uint8_t  prof_nthreads;
+static bool     prof_on;
+
+static struct k_timer prof_timer;
+
+static uint16_t prof_thread_idx(k_tid_t t) {
+    for (uint8_t i = 0; i < prof_nthreads; ++i) {
+        if (prof_threads[i] == t) return i;
+    }
+    if (prof_nthreads < PROF_MAX_THREADS) {
+        prof_threads[prof_nthreads] = t;
+        return prof_nthreads++;
+    }
+    return UINT16_MAX;
+}
+
+// Ajastinkeskeytys (ISR-konteksti)
+static void prof_tick(struct k_timer *t) {
+    ARG_UNUSED(t);
+    struct prof_sample *s = &prof_ring[prof_head % PROF_RING];
+
+    if (prof_head >= PROF_RING) prof_lost++;
+#if defined(CONFIG_CPU_CORTEX_M)
+    // säietila käyttää PSP:tä: laitteiston tallentama kehys, PC sanassa 6
+    const uint32_t *frame = (const uint32_t *)(uintptr_t)__get_PSP();
+    s->pc    = frame ? frame[6] : 0;
+    s->flags = frame ? 0 : PROF_F_NOPC;
+#else
+    s->pc    = 0;
+    s->flags = PROF_F_NOPC;
+#endif
+    s->tid = prof_thread_idx(k_current_get());
+    prof_head++;
+}
+
+void prof_start(void) {
+    static bool inited;
+    if (!inited) {
+        k_timer_init(&prof_timer, prof_tick, NULL);
+        inited = true;
+    }
+    unsigned int key = irq_lock();
+    prof_head = 0;
+    prof_lost = 0;
+    prof_nthreads = 0;
+    irq_unlock(key);
+    prof_on = true;
+    k_timer_start(&prof_timer, K_USEC(1000000 / PROF_HZ), K_USEC(1000000 / PROF_HZ));
+}
+
+void prof_stop(void) {
+    k_timer_stop(&prof_timer);
+    prof_on = false;
+}
+
+bool prof_running(void) {
+    return prof_on;
+}
+
+void prof_dump(void) {
+    bool was_on = prof_on;
+    prof_stop();
+
+    uint32_t n     = MIN(prof_head, (uint32_t)PROF_RING);
+    uint32_t first = prof_head - n;
+
+    printk("PROF BEGIN %u %u %u\n", PROF_HZ, n, prof_lost);
+    for (uint8_t i = 0; i < prof_nthreads; ++i) {
+        const char *name = k_thread_name_get(prof_threads[i]);
+        printk("PROF T %u %s\n", i, (name && name[0]) ? name : "?");
+    }
+    // peräkkäiset samat näytteet yhdelle riville
+    uint32_t run = 0;
+    struct prof_sample prev = { 0 };
+    for (uint32_t k = 0; k < n; ++k) {
+        struct prof_sample s = prof_ring[(first + k) % PROF_RING];
+        if (run && s.pc == prev.pc && s.tid == prev.tid) { run++; continue; }
+        if (run) printk("PROF S %u %08x %u\n", prev.tid, prev.pc, run);
+        prev = s;
+        run = 1;
+    }
+    if (run) printk("PROF S %u %08x %u\n", prev.tid, prev.pc, run);
+    printk("PROF END\n");
+
+    prof_head = 0;
+    prof_lost = 0;
+    if (was_on) prof_start();
+}
@@ -0,0 +1,22 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Näytteistävä profiloija: jaksollinen ajastinkeskeytys tallentaa
+// keskeytetyn PC:n ja säikeen kiinteään RAM-renkaaseen.
+// Host: host/profsym symboloi näytteet zephyr.elf:iä vasten (flame graph).
+//
+// Näytetaajuus rajoittuu järjestelmän tikkiin (CONFIG_SYS_CLOCK_TICKS_PER_SEC).
+// PC saadaan Cortex-M:llä PSP:n pinokehyksestä; muilla arkkitehtuureilla
+// (native_sim) vain säie, PC = 0.
+
+#define PROF_HZ          1000
+#define PROF_RING        512     // näytettä, vanhin ylikirjoitetaan
+#define PROF_MAX_THREADS 16
+
+void prof_start(void);
+void prof_stop(void);
+bool prof_running(void);
+// Tulostaa renkaan PROF-riveinä ja tyhjentää sen
+void prof_dump(void);
+
+#endif
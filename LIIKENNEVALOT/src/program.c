@@ -0,0 +1,145 @@
+#include <zephyr/kernel.h>
+#include <ctype.h>
+#include "program.h"
+
+static struct prog progs[PROG_SLOTS];
+static struct k_spinlock prog_lock;
+
+//Ajotila (dispatcher)
+static const struct prog *run_prog;
+static uint8_t  run_pc;
+static uint8_t  run_rep;     // nykyisen käskyn toistoja jäljellä
+static uint16_t run_loops;   // kierroksia jäljellä (0 + forever)
+static bool     run_forever;
+
+static const char prog_colors[4] = { 0, 'R', 'Y', 'G' };
+
+static int color_code(char c) {
+    switch (c) {
+    case 'R': return 1;
+    case 'Y': return 2;
+    case 'G': return 3;
+    default:  return 0;
+    }
+}
+
+// Lähteestä tavukoodiin; palauttaa käskyjen määrän tai -(pos+1)
+static int prog_compile(const char *src, size_t len, struct prog *out) {
+    size_t i = 0;
+    out->n = 0;
+    out->loops = 1;
+
+    while (i < len) {
+        char c = (char)toupper((unsigned char)src[i]);
+        if (c == ' ' || c == ',') { i++; continue; }
+
+        if (c == 'X') {                      // xN: koko ohjelman toisto
+            size_t st = i++;
+            uint32_t v = 0;
+            if (i >= len || !isdigit((unsigned char)src[i])) return -(int)(st + 1);
+            while (i < len && isdigit((unsigned char)src[i])) {
+                v = v * 10 + (uint32_t)(src[i++] - '0');
+                if (v > UINT16_MAX) return -(int)(st + 1);
+            }
+            out->loops = (uint16_t)v;
+            continue;
+        }
+
+        int col = color_code(c);
+        if (!col) return -(int)(i + 1);
+        size_t st = i++;
+        uint32_t dur = 0;
+        while (i < len && isdigit((unsigned char)src[i])) {
+            dur = dur * 10 + (uint32_t)(src[i++] - '0');
+            if (dur > 255) return -(int)(st + 1);
+        }
+        if (i > st + 1 && dur == 0) return -(int)(st + 1);
+
+        // sama askel kuin edellinen -> kasvatetaan toistoa
+        if (out->n) {
+            uint8_t *last = &out->code[(out->n - 1) * 2];
+            uint8_t rep = (uint8_t)(last[0] >> PROG_REP_SHIFT);
+            if ((last[0] & PROG_COLOR_MASK) == col && last[1] == dur && rep + 1 < PROG_MAX_REP) {
+                last[0] = (uint8_t)(((rep + 1) << PROG_REP_SHIFT) | col);
+                continue;
+            }
+        }
+        if (out->n == PROG_MAX_INSN) return -(int)(st + 1);
+        out->code[out->n * 2]     = (uint8_t)col;
+        out->code[out->n * 2 + 1] = (uint8_t)dur;
+        out->n++;
+    }
+    return out->n ? out->n : -(int)(len + 1);
+}
+
+int prog_store(char name, const char *src, size_t len) {
+    struct prog tmp;
+    int n = prog_compile(src, len, &tmp);
+    if (n < 0) return n;
+    tmp.name = name;
+
+    k_spinlock_key_t key = k_spin_lock(&prog_lock);
+    struct prog *slot = NULL;
+    for (int i = 0; i < PROG_SLOTS; ++i) {
+        if (progs[i].name == name) { slot = &progs[i]; break; }
+        if (!slot && progs[i].name == 0) slot = &progs[i];
+    }
+    if (slot) {
+        if (slot == run_prog) run_prog = NULL;   // ajossa oleva korvataan -> pysäytys
+        *slot = tmp;
+    }
+    k_spin_unlock(&prog_lock, key);
+    return slot ? n : -ENOMEM;
+}
+
+int prog_run(char name) {
+    int ret = -ENOENT;
+    k_spinlock_key_t key = k_spin_lock(&prog_lock);
+    for (int i = 0; i < PROG_SLOTS; ++i) {
+        if (progs[i].name == name) {
+            run_prog    = &progs[i];
+            run_pc      = 0;
+            run_rep     = (uint8_t)((progs[i].code[0] >> PROG_REP_SHIFT) + 1);
+            run_forever = progs[i].loops == 0;
+            run_loops   = progs[i].loops;
+            ret = 0;
+            break;
+        }
+    }
+    k_spin_unlock(&prog_lock, key);
+    return ret;
+}
+
+void prog_stop(void) {
+    k_spinlock_key_t key = k_spin_lock(&prog_lock);
+    run_prog = NULL;
+    k_spin_unlock(&prog_lock, key);
+}
+
+bool prog_active(void) {
+    return run_prog != NULL;
+}
+
+bool prog_next(char *col, uint32_t *ms, uint32_t default_ms) {
+    bool ok = false;
+    k_spinlock_key_t key = k_spin_lock(&prog_lock);
+    const struct prog *p = run_prog;
+
+    if (p) {
+        const uint8_t *insn = &p->code[run_pc * 2];
+        *col = prog_colors[insn[0] & PROG_COLOR_MASK];
+        *ms  = insn[1] ? insn[1] * 1000U : default_ms;
+        ok = true;
+
+        // ohjelmalaskuri eteenpäin
+        if (--run_rep == 0) {
+            if (++run_pc == p->n) {
+                run_pc = 0;
+                if (!run_forever && --run_loops == 0) run_prog = NULL;
+            }
+            if (run_prog) run_rep = (uint8_t)((p->code[run_pc * 2] >> PROG_REP_SHIFT) + 1);
+        }
+    }
+    k_spin_unlock(&prog_lock, key);
+    return ok;
+}
@@ -0,0 +1,44 @@
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Valosekvenssiohjelmat: lähdeteksti käännetään kerran tavukoodiksi ja
+// dispatcher ajaa sitä ohjelmalaskurilla (ei seq_item-allokointeja).
+//   "RYGY x100"   väri ilman kestoa = LIGHT_MS, xN = koko ohjelma N kertaa
+//   "G30 Y3 R27"  väri + kesto sekunteina (1..255), x0 = ikuisesti
+// Peräkkäiset samat askeleet yhdistetään toistoksi.
+//
+// Dispatcher vuorottelee ohjelman ja seq_fifon välillä: jos seq_fifossa on
+// komento (UART, nappi, A-laukaisu, L-suunnitelma), ohjelman askeleen jälkeen
+// ajetaan yksi jonon komento ennen seuraavaa askelta. Ohjelma jatkaa samasta
+// kohdasta; prio_fifo ohittaa molemmat kuten ennenkin.
+
+#define PROG_SLOTS     4
+#define PROG_MAX_INSN  32
+#define PROG_MAX_REP   64
+
+// Käsky = 2 tavua: [rep-1 (6b) | väri (2b)] [kesto s, 0 = LIGHT_MS]
+#define PROG_COLOR_MASK  0x03
+#define PROG_REP_SHIFT   2
+
+struct prog {
+    char     name;      // 0 = vapaa paikka
+    uint8_t  n;         // käskyjä
+    uint16_t loops;     // 0 = ikuisesti
+    uint8_t  code[PROG_MAX_INSN * 2];
+};
+
+// Kääntää ja tallentaa nimelle; palauttaa käskyjen määrän tai
+// -(virhekohta + 1) jos lähde on virheellinen, -ENOMEM jos paikat täynnä
+int prog_store(char name, const char *src, size_t len);
+// Käynnistää tallennetun ohjelman alusta, -ENOENT jos nimeä ei ole
+int prog_run(char name);
+void prog_stop(void);
+bool prog_active(void);
+// Seuraava askel: väri ja kesto (ms); false kun ohjelma loppui / ei ajossa
+bool prog_next(char *col, uint32_t *ms, uint32_t default_ms);
+
+#endif
@@ -0,0 +1,173 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#include "retain.h"
+
+#define RETAIN_MAGIC  0x4C565245u   // "ERVL"
+
+struct retain_plan {
+    uint32_t magic;
+    struct sched_bank bank;
+    uint32_t crc;
+};
+
+static __noinit struct retain_hot  r_hot;
+static __noinit struct retain_plan r_plan;
+
+static struct k_spinlock r_lock;
+static struct k_timer    r_tick;
+static uint32_t          r_phase_t0;     // k_uptime_get_32 vaiheen alussa
+static bool              r_frozen;
+
+static uint32_t hot_crc(const struct retain_hot *h) {
+    return crc32_ieee((const uint8_t *)h, offsetof(struct retain_hot, crc));
+}
+static uint32_t plan_crc(const struct retain_plan *p) {
+    return crc32_ieee((const uint8_t *)p, offsetof(struct retain_plan, crc));
+}
+static inline void hot_seal(void) { r_hot.crc = hot_crc(&r_hot); }
+
+// Jaksollinen: kulunut aika, seinäkello, suunnitelman kohta
+static void retain_tick_fn(struct k_timer *t) {
+    ARG_UNUSED(t);
+    uint8_t idx;
+    uint32_t rem;
+    const struct sched_bank *b = sched_active_bank(&idx, &rem);
+    struct wc_state wall;
+    wc_snapshot(&wall);
+
+    k_spinlock_key_t key = k_spin_lock(&r_lock);
+    if (!r_frozen) {
+        if (r_hot.cur_col) r_hot.cur_elapsed_ms = k_uptime_get_32() - r_phase_t0;
+        r_hot.wall        = wall;
+        r_hot.plan_gen    = b ? b->gen : 0;
+        r_hot.plan_idx    = idx;
+        r_hot.plan_rem_ms = rem;
+        // pankki kopioidaan vain kun se vaihtui (vaihto tapahtuu harvoin)
+        if (b && (r_plan.magic != RETAIN_MAGIC || r_plan.bank.gen != b->gen)) {
+            r_plan.magic = RETAIN_MAGIC;
+            r_plan.bank  = *b;
+            r_plan.crc   = plan_crc(&r_plan);
+        }
+        hot_seal();
+    }
+    k_spin_unlock(&r_lock, key);
+}
+
+void retain_init(void) {
+    k_timer_init(&r_tick, retain_tick_fn, NULL);
+}
+
+bool retain_boot(struct retain_hot *hot, struct sched_bank *plan) {
+    k_spinlock_key_t key = k_spin_lock(&r_lock);
+    bool ok = r_hot.magic == RETAIN_MAGIC && r_hot.crc == hot_crc(&r_hot) &&
+              r_hot.q_len <= RETAIN_QMAX && r_hot.q_head < RETAIN_QMAX &&
+              r_hot.wall.n <= WC_MAX_TRIG;
+    if (ok) {
+        *hot = r_hot;
+        bool plan_ok = r_hot.plan_gen && r_plan.magic == RETAIN_MAGIC &&
+                       r_plan.crc == plan_crc(&r_plan) && r_plan.bank.gen == r_hot.plan_gen;
+        if (!plan_ok) hot->plan_gen = 0;
+        else if (plan) *plan = r_plan.bank;
+    }
+
+    // uusi tila: vain laskurit jatkuvat
+    uint32_t boots  = ok ? r_hot.warm_boots + 1 : 0;
+    uint32_t phases = ok ? r_hot.phases : 0;
+    memset(&r_hot, 0, sizeof(r_hot));
+    r_hot.magic       = RETAIN_MAGIC;
+    r_hot.warm_boots  = boots;
+    r_hot.phases      = phases;
+    r_hot.timer_color = ok ? hot->timer_color : 'R';
+    hot_seal();
+    r_frozen = false;
+    k_spin_unlock(&r_lock, key);
+
+    k_timer_start(&r_tick, K_MSEC(RETAIN_TICK_MS), K_MSEC(RETAIN_TICK_MS));
+    return ok;
+}
+
+void retain_timer(char color) {
+    k_spinlock_key_t key = k_spin_lock(&r_lock);
+    if (!r_frozen) {
+        r_hot.timer_color = color;
+        hot_seal();
+    }
+    k_spin_unlock(&r_lock, key);
+}
+
+void retain_phase_start(char col, bool prio, uint32_t ms) {
+    k_spinlock_key_t key = k_spin_lock(&r_lock);
+    if (!r_frozen) {
+        r_phase_t0 = k_uptime_get_32();
+        r_hot.cur_col = col;
+        r_hot.cur_prio = prio;
+        r_hot.cur_ms = ms;
+        r_hot.cur_elapsed_ms = 0;
+        hot_seal();
+    }
+    k_spin_unlock(&r_lock, key);
+}
+
+void retain_phase_end(void) {
+    k_spinlock_key_t key = k_spin_lock(&r_lock);
+    if (!r_frozen) {
+        r_hot.cur_col = 0;
+        r_hot.phases++;
+        hot_seal();
+    }
+    k_spin_unlock(&r_lock, key);
+}
+
+void retain_q_push(char col) {
+    k_spinlock_key_t key = k_spin_lock(&r_lock);
+    if (!r_frozen) {
+        if (r_hot.q_len == RETAIN_QMAX) {       // vanhin pois peilistä
+            r_hot.q_head = (r_hot.q_head + 1) % RETAIN_QMAX;
+            r_hot.q_len--;
+            if (r_hot.q_lost < UINT8_MAX) r_hot.q_lost++;
+        }
+        r_hot.q[(r_hot.q_head + r_hot.q_len) % RETAIN_QMAX] = col;
+        r_hot.q_len++;
+        hot_seal();
+    }
+    k_spin_unlock(&r_lock, key);
+}
+
+void retain_q_pop(void) {
+    k_spinlock_key_t key = k_spin_lock(&r_lock);
+    if (!r_frozen) {
+        if (r_hot.q_lost) {
+            r_hot.q_lost--;
+        } else if (r_hot.q_len) {
+            r_hot.q_head = (r_hot.q_head + 1) % RETAIN_QMAX;
+            r_hot.q_len--;
+        }
+        hot_seal();
+    }
+    k_spin_unlock(&r_lock, key);
+}
+
+bool retain_phase_active(void) {
+    return r_hot.cur_col != 0;
+}
+
+void retain_freeze(void) {
+    k_spinlock_key_t key = k_spin_lock(&r_lock);
+    r_frozen = true;
+    k_spin_unlock(&r_lock, key);
+    k_timer_stop(&r_tick);
+}
+
+void retain_dump(void) {
+    struct retain_hot h;
+    k_spinlock_key_t key = k_spin_lock(&r_lock);
+    h = r_hot;
+    k_spin_unlock(&r_lock, key);
+    printk("RETAIN warm %u phases %u timer %c wall %s %u triggers\n",
+           h.warm_boots, h.phases, h.timer_color, h.wall.valid ? "set" : "unset", h.wall.n);
+    printk("RETAIN phase %c %u/%u ms queued %u plan gen %u step %u\n",
+           h.cur_col ? h.cur_col : '-', h.cur_elapsed_ms, h.cur_ms, h.q_len,
+           h.plan_gen, h.plan_idx + 1);
+}
@@ -0,0 +1,58 @@
+#ifndef RETAIN_H
+#define RETAIN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "schedule.h"
+#include "wallclock.h"
+
+// Sekvensserin tila __noinit-RAMissa CRC:llä. Lämmin reset (watchdog,
+// sys_reboot) säilyttää RAMin, joten bootissa validi tila palautetaan:
+// käynnissä ollut vaihe jatkuu jäljellä olevalla ajalla, jonossa olleet
+// värit, seinäkello A-laukaisuineen ja suunnitelma palaavat. Kylmä käynnistys -> CRC ei täsmää.
+//
+// Kuuma osa päivittyy tapahtumista + RETAIN_TICK_MS välein (kulunut aika),
+// suunnitelmapankki vain kun sen gen vaihtuu.
+
+#define RETAIN_QMAX     16
+#define RETAIN_TICK_MS  50
+
+struct retain_hot {
+    uint32_t magic;
+    uint32_t warm_boots;
+    uint32_t phases;            // ajetut vaiheet käynnistysten yli
+    char     timer_color;
+    struct wc_state wall;       // seinäkello ja A-laukaisut (wallclock.h)
+    char     cur_col;           // käynnissä oleva vaihe, 0 = ei
+    bool     cur_prio;
+    uint32_t cur_ms;
+    uint32_t cur_elapsed_ms;
+    uint8_t  q_head;
+    uint8_t  q_len;
+    uint8_t  q_lost;            // peili ylivuoti: näin monta poistoa ohitetaan
+    char     q[RETAIN_QMAX];    // seq_fifon värit saapumisjärjestyksessä
+    uint8_t  plan_idx;
+    uint32_t plan_rem_ms;
+    uint32_t plan_gen;          // 0 = ei suunnitelmaa
+    uint32_t crc;
+};
+
+void retain_init(void);
+// Validoi edellisen käynnistyksen tilan; true -> *hot (ja plan jos ei NULL)
+// sisältää palautettavan tilan. Aloittaa uuden tilan (warm_boots kasvaa).
+bool retain_boot(struct retain_hot *hot, struct sched_bank *plan);
+
+// Päivityskohdat. retain_timer: A-laukaisujen väri
+void retain_timer(char color);
+void retain_phase_start(char col, bool prio, uint32_t ms);
+void retain_phase_end(void);
+void retain_q_push(char col);
+void retain_q_pop(void);
+bool retain_phase_active(void);
+
+// Tila jäädytetään (native_sim W-komennon emulointi): päivitykset ohitetaan
+void retain_freeze(void);
+
+void retain_dump(void);
+
+#endif
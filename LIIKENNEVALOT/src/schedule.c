@@ -0,0 +1,196 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+#include <ctype.h>
+#include "schedule.h"
+#include "deadline.h"
+
+static struct sched_bank banks[2];
+
+// Aktiivinen pankki: vain sched_work vaihtaa. Julkaistu: uart_task asettaa,
+// sched_work ottaa rajalla (atomic_ptr_clear). Lukijat (dump, lataus) näkevät
+// aina kokonaisen pankin.
+static atomic_ptr_t sched_active  = ATOMIC_PTR_INIT(NULL);
+static atomic_ptr_t sched_pending = ATOMIC_PTR_INIT(NULL);
+static atomic_t     sched_due;      // ajastin laukesi -> askeleen raja
+static uint8_t      sched_idx;      // vain sched_work
+static uint32_t     sched_gen;
+static volatile uint64_t sched_t_in;
+// Vain vaihdon ja pankin valinnan ajan (muutama käsky), ei latauksen ajan
+static struct k_spinlock sched_lock;
+
+static void (*sched_emit)(char col, uint64_t t_in);
+
+static struct k_timer sched_timer;
+static void sched_work_fn(struct k_work *work);
+K_WORK_DEFINE(sched_work, sched_work_fn);
+
+static void sched_expiry(struct k_timer *t) {
+    ARG_UNUSED(t);
+    sched_t_in = dl_stamp();
+    atomic_set(&sched_due, 1);
+    k_work_submit(&sched_work);
+}
+
+// Ajetaan järjestelmän workqueuessa: ainoa paikka jossa aktiivinen vaihtuu
+static void sched_work_fn(struct k_work *work) {
+    ARG_UNUSED(work);
+    struct sched_bank *b = atomic_ptr_get(&sched_active);
+
+    if (b) {
+        if (!atomic_clear(&sched_due)) return;     // kesken askeleen: ei vaihtoa
+        sched_emit(b->step[sched_idx].col, sched_t_in);
+    }
+    // askeleen raja: odottava pankki aktiiviseksi
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+    if (b && ++sched_idx >= b->n) {
+        sched_idx = 0;
+        if (!b->loop) b = NULL;
+    }
+    struct sched_bank *nb = atomic_ptr_clear(&sched_pending);
+    if (nb) {
+        b = nb->n ? nb : NULL;
+        sched_idx = 0;
+    }
+    atomic_ptr_set(&sched_active, b);
+    k_spin_unlock(&sched_lock, key);
+
+    if (b) {
+        k_timer_start(&sched_timer, K_SECONDS(b->step[sched_idx].delay_s), K_NO_WAIT);
+    } else {
+        k_timer_stop(&sched_timer);
+    }
+}
+
+void sched_init(void (*emit)(char col, uint64_t t_in)) {
+    sched_emit = emit;
+    k_timer_init(&sched_timer, sched_expiry, NULL);
+}
+
+//Lataus (uart_task)
+static struct sched_bank *ld;       // kirjoitettava pankki, NULL = ei latausta
+static int      ld_pos;
+static int      ld_err;
+static bool     ld_num;             // luku kesken
+static bool     ld_star;
+
+void sched_load_begin(void) {
+    // perutaan odottava julkaisu lukon alla (work ei ole kesken vaihdon):
+    // sen jälkeen aktiivinen ei voi vaihtua kirjoittamamme pankin päälle
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+    atomic_ptr_clear(&sched_pending);
+    struct sched_bank *act = atomic_ptr_get(&sched_active);
+    k_spin_unlock(&sched_lock, key);
+    ld = (act == &banks[0]) ? &banks[1] : &banks[0];
+    ld->n = 0;
+    ld->loop = false;
+    ld_pos = 0;
+    ld_err = 0;
+    ld_num = false;
+    ld_star = false;
+}
+
+bool sched_loading(void) {
+    return ld != NULL;
+}
+
+void sched_load_abort(void) {
+    ld = NULL;
+}
+
+static int ld_fail(void) {
+    if (!ld_err) ld_err = -(ld_pos + 1);
+    return ld_err;
+}
+
+int sched_load_feed(char c) {
+    if (!ld) return -1;
+    if (ld_err) { ld_pos++; return ld_err; }
+
+    c = (char)toupper((unsigned char)c);
+    int r = 0;
+    if (isdigit((unsigned char)c) && ld_num) {
+        uint32_t *d = &ld->step[ld->n - 1].delay_s;
+        *d = *d * 10 + (uint32_t)(c - '0');
+        if (*d > SCHED_MAX_DELAY) r = ld_fail();
+    } else if (c == ' ' || c == ',') {
+        if (ld_num && ld->step[ld->n - 1].delay_s == 0) r = ld_fail();
+        ld_num = false;
+    } else if ((c == 'R' || c == 'Y' || c == 'G') && !ld_star && !ld_num) {
+        if (ld->n >= SCHED_MAX_STEPS) {
+            r = ld_fail();
+        } else {
+            ld->step[ld->n].col = c;
+            ld->step[ld->n].delay_s = 0;
+            ld->n++;
+            ld_num = true;
+        }
+    } else if (c == '*' && !ld_star && !ld_num && ld->n) {
+        ld_star = true;
+        ld->loop = true;
+    } else if (c == '.' && ld_pos == 0) {
+        // pysäytys: tyhjä pankki
+    } else {
+        r = ld_fail();
+    }
+    ld_pos++;
+    return r;
+}
+
+int sched_load_end(void) {
+    if (!ld) return -1;
+    if (ld_num && ld->step[ld->n - 1].delay_s == 0) ld_fail();
+    int err = ld_err;
+    struct sched_bank *b = ld;
+    ld = NULL;
+    if (err) return err;
+
+    b->gen = ++sched_gen;
+    atomic_ptr_set(&sched_pending, b);
+    // ei aktiivista suunnitelmaa: work ottaa pankin heti, muuten rajalla
+    if (atomic_ptr_get(&sched_active) == NULL) k_work_submit(&sched_work);
+    return b->n;
+}
+
+const struct sched_bank *sched_active_bank(uint8_t *idx, uint32_t *rem_ms) {
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+    struct sched_bank *a = atomic_ptr_get(&sched_active);
+    *idx    = sched_idx;
+    *rem_ms = a ? k_timer_remaining_get(&sched_timer) : 0;
+    k_spin_unlock(&sched_lock, key);
+    return a;
+}
+
+void sched_reset(void) {
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+    atomic_ptr_clear(&sched_pending);
+    atomic_ptr_set(&sched_active, NULL);
+    atomic_clear(&sched_due);
+    k_spin_unlock(&sched_lock, key);
+    k_timer_stop(&sched_timer);
+}
+
+void sched_restore(const struct sched_bank *b, uint8_t idx, uint32_t rem_ms) {
+    if (!b->n || idx >= b->n || b->n > SCHED_MAX_STEPS) return;
+    sched_reset();
+    banks[0] = *b;
+    sched_gen = MAX(sched_gen, b->gen);
+    k_spinlock_key_t key = k_spin_lock(&sched_lock);
+    sched_idx = idx;
+    atomic_ptr_set(&sched_active, &banks[0]);
+    k_spin_unlock(&sched_lock, key);
+    k_timer_start(&sched_timer, K_MSEC(rem_ms), K_NO_WAIT);
+}
+
+void sched_dump(void) {
+    struct sched_bank *a = atomic_ptr_get(&sched_active);
+    struct sched_bank *p = atomic_ptr_get(&sched_pending);
+    if (a) {
+        printk("PLAN bank %d gen %u step %u/%u%s\n", (int)(a - banks), a->gen,
+               sched_idx + 1, a->n, a->loop ? " loop" : "");
+    } else {
+        printk("PLAN idle\n");
+    }
+    if (p) printk("PLAN pending bank %d gen %u (%u steps)\n", (int)(p - banks), p->gen, p->n);
+}
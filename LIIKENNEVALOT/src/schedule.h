@@ -0,0 +1,53 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Ajastettu suunnitelma kahdessa pankissa: uusi suunnitelma kirjoitetaan ja
+// validoidaan passiiviseen pankkiin merkki kerrallaan (uart_task) samalla kun
+// aktiivinen pyörii. Valmis pankki julkaistaan sched_pendingiin ja ajastimen
+// work vaihtaa sen aktiiviseksi yhdellä atomic_ptr_set:llä vasta askelten
+// rajalla, joten lataus ei koskaan pysäytä tai katko käynnissä olevaa sarjaa.
+//
+//   "R10 G30 Y3 *"   väri + viive sekunteina ennen väriä, '*' = toista
+//   tyhjä / "."      pysäyttää suunnitelman seuraavalla rajalla
+
+#define SCHED_MAX_STEPS  64
+#define SCHED_MAX_DELAY  86399
+
+struct sched_step {
+    uint32_t delay_s;   // odotus edellisestä askeleesta
+    char     col;
+};
+
+struct sched_bank {
+    uint32_t gen;       // latauslaskuri, näkyy dumpissa
+    uint8_t  n;
+    bool     loop;
+    struct sched_step step[SCHED_MAX_STEPS];
+};
+
+// emit: askeleen väri jonoon (ajastimen work -säie), t_in = laukeamishetki
+void sched_init(void (*emit)(char col, uint64_t t_in));
+
+// Lataus: begin valitsee passiivisen pankin (peruu odottavan julkaisun),
+// feed jäsentää merkin, end validoi ja julkaisee.
+// feed/end palauttavat 0 tai -(virhekohta + 1); end palauttaa onnistuessa
+// askelten määrän.
+void sched_load_begin(void);
+int  sched_load_feed(char c);
+int  sched_load_end(void);
+bool sched_loading(void);
+void sched_load_abort(void);
+
+void sched_dump(void);
+
+// Lämmin uudelleenkäynnistys (retain.h): aktiivinen pankki, askel ja
+// jäljellä oleva viive; restore käynnistää pankin suoraan aktiiviseksi.
+const struct sched_bank *sched_active_bank(uint8_t *idx, uint32_t *rem_ms);
+void sched_restore(const struct sched_bank *b, uint8_t idx, uint32_t rem_ms);
+// Pysäyttää heti (ei rajalla), peruu odottavan
+void sched_reset(void);
+
+#endif
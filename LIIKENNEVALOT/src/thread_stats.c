@@ -0,0 +1,47 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include "thread_stats.h"
+
+//Kokonaissyklit (sis. idle) prosentteja varten
+static uint64_t stats_total;
+
+static void thread_stats_line(const struct k_thread *cthread, void *user_data) {
+    ARG_UNUSED(user_data);
+    struct k_thread *t = (struct k_thread *)cthread;
+    k_thread_runtime_stats_t rs;
+    uint64_t cycles = 0, peak = 0;
+    uint32_t windows = 0;
+
+    if (k_thread_runtime_stats_get(t, &rs) == 0) {
+        cycles = rs.execution_cycles;
+#ifdef CONFIG_SCHED_THREAD_USAGE_ANALYSIS
+        peak    = rs.peak_cycles;
+        windows = t->base.usage.num_windows;   // kuinka monta kertaa vaihdettu sisään
+#endif
+    }
+    // promilleina, yksi desimaali
+    uint32_t pm = stats_total ? (uint32_t)(cycles * 1000U / stats_total) : 0;
+
+    size_t unused = 0;
+    size_t size   = t->stack_info.size;
+    if (k_thread_stack_space_get(t, &unused) != 0) unused = size;
+
+    const char *name = k_thread_name_get(t);
+    printk("%-18s %10llu %3u.%u%% %7u %8llu %5u/%u\n",
+           name ? name : "?",
+           (unsigned long long)cycles, pm / 10, pm % 10, windows,
+           (unsigned long long)peak, (unsigned)(size - unused), (unsigned)size);
+}
+
+void thread_stats_dump(void) {
+    k_thread_runtime_stats_t all;
+
+    stats_total = 0;
+    if (k_thread_runtime_stats_all_get(&all) == 0) stats_total = all.execution_cycles;
+
+    printk("STATS %llu cycles @ %u Hz\n",
+           (unsigned long long)stats_total, (unsigned)sys_clock_hw_cycles_per_sec());
+    printk("%-18s %10s %6s %7s %8s %s\n", "thread", "cycles", "cpu", "sw", "peak", "stack");
+    // ei pidetä säielistan lukkoa printkien ajan
+    k_thread_foreach_unlocked(thread_stats_line, NULL);
+}
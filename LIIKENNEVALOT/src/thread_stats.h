@@ -0,0 +1,8 @@
+#ifndef THREAD_STATS_H
+#define THREAD_STATS_H
+
+// Säiekohtainen CPU-käyttö, ajoikkunat ja pinon huippukäyttö.
+// Vaatii CONFIG_SCHED_THREAD_USAGE ja CONFIG_THREAD_STACK_INFO (prj.conf).
+void thread_stats_dump(void);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Sovelluksen omat tapahtumat Zephyrin tracing-virtaan (CTF: named_event).
+// Käytössä vain overlay-tracing*.conf:lla, muuten makrot katoavat.
+// arg1 on komennon tunniste (syötteen aikaleima t_in), jolla host/traceview
+// yhdistää syötteen, dispatchin ja LED-vaiheen samaksi komennoksi.
+//
+//   cmd_in    col, t_in        syöte jonoon (UART, kehys, nappi, ajastin)
+//   cmd_disp  col, t_in        dispatcher otti komennon
+//   led_on    col, t_in        GPIO päälle
+//   led_off   col|abort<<8, t_in
+//   meas      col, us          LED-taskin mittaama vaiheen kesto
+//   (led_on/led_off/meas: valoväylän kuuntelija, lightbus.h)
+//   drop      cause, yhteensä  hukattu tapahtuma (drops.h)
+//   fifo_hwm  jono, syvyys     jonon uusi huippu (drops.h)
+
+#if defined(CONFIG_TRACING)
+#include <zephyr/tracing/tracing.h>
+#define TRACE_EV(name, a0, a1) sys_trace_named_event((name), (uint32_t)(a0), (uint32_t)(a1))
+#else
+#define TRACE_EV(name, a0, a1) do { (void)(a0); (void)(a1); } while (0)
+#endif
+
+#endif
@@ -0,0 +1,254 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <stdlib.h>
+#include "wallclock.h"
+#include "deadline.h"
+
+static struct k_spinlock wc_lock;
+static bool     wc_set;
+// Vaiheen ankkuri: kellonaika wc_base hetkellä wc_up0 (k_uptime_get)
+static int64_t  wc_up0;
+static uint32_t wc_base;
+// Taajuusvirheen mittausväli: host-aika wc_dbase hetkellä wc_dup0
+static int64_t  wc_dup0;
+static uint32_t wc_dbase;
+static int32_t  wc_ppb;
+static int32_t  wc_last_err;
+static uint32_t wc_syncs, wc_steps, wc_fired;
+
+static struct wc_trigger wc_trig[WC_MAX_TRIG];     // tod_s-järjestyksessä
+static uint8_t  wc_n;
+static uint32_t wc_cursor;      // tähän kellonaikaan asti laukaistu (ms)
+
+static void (*wc_emit)(char col, uint64_t t_in);
+static volatile uint64_t wc_t_in;
+
+static struct k_timer wc_timer;
+static void wc_work_fn(struct k_work *work);
+K_WORK_DEFINE(wc_work, wc_work_fn);
+
+// a - b vuorokauden kehällä, (-12 h, 12 h]
+static int32_t wrap_diff(uint32_t a, uint32_t b) {
+    int32_t d = (int32_t)(((int64_t)a - b) % WC_DAY_MS);
+    if (d > (int32_t)(WC_DAY_MS / 2))       d -= WC_DAY_MS;
+    else if (d <= -(int32_t)(WC_DAY_MS / 2)) d += WC_DAY_MS;
+    return d;
+}
+
+static uint32_t now_locked(int64_t up) {
+    int64_t el = up - wc_up0;
+    el += el * wc_ppb / 1000000000;
+    return (uint32_t)(((int64_t)wc_base + el) % WC_DAY_MS);
+}
+
+// Laukaisun etäisyys kursorista, (0, vrk]
+static uint32_t trig_off(uint8_t i) {
+    uint32_t off = (wc_trig[i].tod_s * 1000U + WC_DAY_MS - wc_cursor) % WC_DAY_MS;
+    return off ? off : WC_DAY_MS;
+}
+
+// Kursorin ja nykyhetken väliin osuneet listan järjestyksessä, kursori eteenpäin
+static int collect_locked(uint32_t now, char *cols) {
+    int32_t d = wrap_diff(now, wc_cursor);
+    if (d <= 0) return 0;           // kello korjattiin taaksepäin: odotetaan
+    uint8_t start = 0;
+    while (start < wc_n && wc_trig[start].tod_s * 1000U <= wc_cursor) start++;
+    int n = 0;
+    for (uint8_t k = 0; k < wc_n; ++k) {
+        uint8_t i = (uint8_t)((start + k) % wc_n);
+        if (trig_off(i) > (uint32_t)d) break;
+        cols[n++] = wc_trig[i].col;
+    }
+    wc_cursor = now;
+    wc_fired += (uint32_t)n;
+    return n;
+}
+
+// Ajastin seuraavaan laukaisuun; kellonajan viive -> uptime taajuuskorjauksella
+static void arm_locked(uint32_t now) {
+    if (!wc_set || !wc_n) { k_timer_stop(&wc_timer); return; }
+    uint32_t off = WC_DAY_MS;
+    for (uint8_t i = 0; i < wc_n; ++i) off = MIN(off, trig_off(i));
+    int64_t wait = (int64_t)off - wrap_diff(now, wc_cursor);
+    if (wait < 0) wait = 0;
+    wait = (wait * 1000000000 + (1000000000 + wc_ppb) - 1) / (1000000000 + wc_ppb);
+    k_timer_start(&wc_timer, K_MSEC(MIN(wait, (int64_t)WC_REARM_MAX_MS)), K_NO_WAIT);
+}
+
+static void wc_expiry(struct k_timer *t) {
+    ARG_UNUSED(t);
+    wc_t_in = dl_stamp();
+    k_work_submit(&wc_work);
+}
+
+// Järjestelmän workqueue: herätys voi olla myös pelkkä välitarkistus
+static void wc_work_fn(struct k_work *work) {
+    ARG_UNUSED(work);
+    char cols[WC_MAX_TRIG];
+    int n = 0;
+    uint64_t t_in = wc_t_in;
+
+    k_spinlock_key_t key = k_spin_lock(&wc_lock);
+    if (wc_set) {
+        uint32_t now = now_locked(k_uptime_get());
+        n = collect_locked(now, cols);
+        arm_locked(now);
+    }
+    k_spin_unlock(&wc_lock, key);
+
+    for (int i = 0; i < n; ++i) wc_emit(cols[i], t_in);
+}
+
+void wc_init(void (*emit)(char col, uint64_t t_in)) {
+    wc_emit = emit;
+    k_timer_init(&wc_timer, wc_expiry, NULL);
+}
+
+int32_t wc_sync(uint32_t ms_of_day) {
+    ms_of_day %= WC_DAY_MS;
+    int32_t err = 0;
+    k_spinlock_key_t key = k_spin_lock(&wc_lock);
+    int64_t up = k_uptime_get();
+
+    if (!wc_set) {
+        wc_set    = true;
+        wc_cursor = ms_of_day;
+        wc_dup0   = up;
+        wc_dbase  = ms_of_day;
+    } else {
+        err = wrap_diff(ms_of_day, now_locked(up));
+        if (abs(err) > WC_STEP_MS) {
+            // kellon asetus: väliin jääneet laukaisut ohitetaan, mittaus alusta
+            wc_steps++;
+            wc_cursor = ms_of_day;
+            wc_dup0   = up;
+            wc_dbase  = ms_of_day;
+        } else if (up - wc_dup0 >= WC_DRIFT_MIN_MS) {
+            // jäännösvirhe koko mittausväliltä nykyisellä korjauksella,
+            // puolet siitä korjaukseen (ms-resoluution ja siirtoviiveen kohina)
+            int64_t l = up - wc_dup0;
+            int64_t pred = l + l * wc_ppb / 1000000000;
+            int32_t e = wrap_diff(ms_of_day, (uint32_t)(((int64_t)wc_dbase + pred) % WC_DAY_MS));
+            int64_t ppb = wc_ppb + (int64_t)e * 1000000000 / l / 2;
+            wc_ppb   = (int32_t)CLAMP(ppb, -WC_PPB_MAX, WC_PPB_MAX);
+            wc_dup0  = up;
+            wc_dbase = ms_of_day;
+        }
+    }
+    wc_up0 = up;
+    wc_base = ms_of_day;
+    wc_last_err = err;
+    wc_syncs++;
+    arm_locked(ms_of_day);
+    k_spin_unlock(&wc_lock, key);
+    return err;
+}
+
+bool wc_valid(void) {
+    return wc_set;
+}
+
+uint32_t wc_now_ms(void) {
+    k_spinlock_key_t key = k_spin_lock(&wc_lock);
+    uint32_t now = wc_set ? now_locked(k_uptime_get()) : 0;
+    k_spin_unlock(&wc_lock, key);
+    return now;
+}
+
+int wc_add(uint32_t tod_s, char col) {
+    if (tod_s >= WC_DAY_MS / 1000 || (col != 'R' && col != 'Y' && col != 'G')) return -EINVAL;
+    char cols[WC_MAX_TRIG];
+    int n = 0, ret = 0;
+    uint64_t t_in = dl_stamp();
+
+    k_spinlock_key_t key = k_spin_lock(&wc_lock);
+    if (!wc_set) {
+        ret = -EAGAIN;
+    } else {
+        // erääntyneet ensin, ettei uusi (jo mennyt) aika laukea tänään
+        uint32_t now = now_locked(k_uptime_get());
+        n = collect_locked(now, cols);
+        uint8_t pos = 0;
+        while (pos < wc_n && wc_trig[pos].tod_s <= tod_s) {
+            if (wc_trig[pos].tod_s == tod_s && wc_trig[pos].col == col) break;
+            pos++;
+        }
+        if (pos < wc_n && wc_trig[pos].tod_s == tod_s && wc_trig[pos].col == col) {
+            // sama laukaisu on jo listassa
+        } else if (wc_n >= WC_MAX_TRIG) {
+            ret = -ENOMEM;
+        } else {
+            for (uint8_t i = wc_n; i > pos; --i) wc_trig[i] = wc_trig[i - 1];
+            wc_trig[pos].tod_s = tod_s;
+            wc_trig[pos].col   = col;
+            wc_n++;
+        }
+        arm_locked(now);
+    }
+    k_spin_unlock(&wc_lock, key);
+
+    for (int i = 0; i < n; ++i) wc_emit(cols[i], t_in);
+    return ret;
+}
+
+void wc_clear(void) {
+    k_spinlock_key_t key = k_spin_lock(&wc_lock);
+    wc_n = 0;
+    k_timer_stop(&wc_timer);
+    k_spin_unlock(&wc_lock, key);
+}
+
+void wc_reset(void) {
+    k_spinlock_key_t key = k_spin_lock(&wc_lock);
+    wc_set = false;
+    wc_n   = 0;
+    wc_ppb = 0;
+    k_timer_stop(&wc_timer);
+    k_spin_unlock(&wc_lock, key);
+    k_work_cancel(&wc_work);
+}
+
+void wc_snapshot(struct wc_state *st) {
+    k_spinlock_key_t key = k_spin_lock(&wc_lock);
+    st->valid = wc_set;
+    st->ms    = wc_set ? now_locked(k_uptime_get()) : 0;
+    st->ppb   = wc_ppb;
+    st->n     = wc_n;
+    for (uint8_t i = 0; i < wc_n; ++i) st->trig[i] = wc_trig[i];
+    k_spin_unlock(&wc_lock, key);
+}
+
+void wc_restore(const struct wc_state *st) {
+    if (!st->valid || st->n > WC_MAX_TRIG) return;
+    wc_reset();
+    k_spinlock_key_t key = k_spin_lock(&wc_lock);
+    int64_t up = k_uptime_get();
+    wc_set    = true;
+    wc_up0    = wc_dup0  = up;
+    wc_base   = wc_dbase = wc_cursor = st->ms % WC_DAY_MS;
+    wc_ppb    = CLAMP(st->ppb, -WC_PPB_MAX, WC_PPB_MAX);
+    wc_n      = st->n;
+    for (uint8_t i = 0; i < wc_n; ++i) wc_trig[i] = st->trig[i];
+    arm_locked(wc_base);
+    k_spin_unlock(&wc_lock, key);
+}
+
+static void print_tod(const char *pre, uint32_t ms) {
+    printk("%s%02u:%02u:%02u.%03u", pre, ms / 3600000U, ms / 60000U % 60U,
+           ms / 1000U % 60U, ms % 1000U);
+}
+
+void wc_dump(void) {
+    struct wc_state st;
+    wc_snapshot(&st);
+    if (!st.valid) { printk("WALL clock not set\n"); return; }
+    print_tod("WALL ", st.ms);
+    printk(" drift %d ppb err %d ms syncs %u steps %u fired %u\n",
+           st.ppb, wc_last_err, wc_syncs, wc_steps, wc_fired);
+    for (uint8_t i = 0; i < st.n; ++i) {
+        print_tod("WALL trig ", st.trig[i].tod_s * 1000U);
+        printk(" %c\n", st.trig[i].col);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef WALLCLOCK_H
+#define WALLCLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Seinäkello ja kellonaikaan sidotut laukaisut.
+//
+// Kello asetetaan hostilta (C+HHMMSS[mmm]) ja kulkee k_uptime_get():n
+// päällä. Jokainen synkkaus korjaa vaiheen heti; kiteen taajuusvirhe
+// arvioidaan vähintään WC_DRIFT_MIN_MS pitkältä väliltä ja korjaus (ppb)
+// lisätään jatkuvasti kuluneeseen aikaan, joten virhe ei kerry päivän mittaan.
+//
+// A+HHMMSS lisää laukaisun kellonajalle, toistuu päivittäin. Laukaisut
+// ovat kellonajan mukaan järjestetyssä listassa; yksi k_timer odottaa
+// seuraavaa. Herätessä kaikki kursorin ja nykyhetken väliin osuneet
+// laukaistaan listan järjestyksessä samalla aikaleimalla, ja seuraava
+// herätys lasketaan kellosta eikä edellisestä viiveestä -> ei kertyvää
+// vinoumaa vaikka samalle sekunnille osuisi useita.
+
+#define WC_DAY_MS         86400000U
+#define WC_MAX_TRIG       16
+#define WC_DRIFT_MIN_MS   60000U        // lyhyempi väli: vain vaihekorjaus
+#define WC_STEP_MS        2000          // suurempi virhe = kellon asetus, ei drift
+#define WC_PPB_MAX        500000        // +-500 ppm
+#define WC_REARM_MAX_MS   60000U        // pitkä odotus pilkotaan: korjaus käyttöön, kursori tuoreena
+
+struct wc_trigger {
+    uint32_t tod_s;     // sekunteja vuorokauden alusta
+    char     col;
+};
+
+// Lämpimän uudelleenkäynnistyksen yli (retain.h)
+struct wc_state {
+    bool     valid;
+    uint32_t ms;        // kellonaika näytteistyshetkellä
+    int32_t  ppb;
+    uint8_t  n;
+    struct wc_trigger trig[WC_MAX_TRIG];
+};
+
+// emit: laukaisun väri jonoon (järjestelmän workqueue), t_in = herätyshetki
+void wc_init(void (*emit)(char col, uint64_t t_in));
+
+// Synkkaus host-ajasta (ms vuorokauden alusta). Palauttaa virheen ms
+// ennen korjausta (0 ensimmäisellä kerralla).
+int32_t  wc_sync(uint32_t ms_of_day);
+bool     wc_valid(void);
+uint32_t wc_now_ms(void);
+
+// 0, -EAGAIN (kelloa ei asetettu), -ENOMEM (lista täynnä). Sama aika ja
+// väri uudestaan ei lisää toista.
+int  wc_add(uint32_t tod_s, char col);
+void wc_clear(void);
+// Kello ja laukaisut pois, ajastin seis (native_sim W)
+void wc_reset(void);
+
+void wc_snapshot(struct wc_state *st);
+void wc_restore(const struct wc_state *st);
+
+void wc_dump(void);
+
+#endif
@@ -0,0 +1,87 @@
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/timing/timing.h>
+#if defined(CONFIG_DCACHE) || defined(CONFIG_ICACHE)
+#include <zephyr/cache.h>
+#endif
+#include "wcet.h"
+
+static const char *const cond_names[WCET_COND_COUNT] = {
+    [WCET_WARM]    = "warm",
+    [WCET_COLD]    = "cold",
+    [WCET_IRQOFF]  = "irqoff",
+    [WCET_PREEMPT] = "preempt",
+};
+
+static uint8_t thrash_buf[CONFIG_LV_WCET_THRASH_SIZE];
+
+// Syrjäyttää välimuistin ja prefetch-puskurin ennen kylmää mittausta
+static void cache_cold(void) {
+    for (size_t i = 0; i < sizeof(thrash_buf); i += 16) {
+        thrash_buf[i] = (uint8_t)(thrash_buf[i] + 1);
+    }
+#if defined(CONFIG_DCACHE)
+    sys_cache_data_flush_and_invd_all();
+#endif
+#if defined(CONFIG_ICACHE)
+    sys_cache_instr_invd_all();
+#endif
+}
+
+void wcet_measure(const struct wcet_case *c, enum wcet_cond cond, uint32_t iter,
+                  struct wcet_result *res) {
+    k_tid_t self = k_current_get();
+    int prio = k_thread_priority_get(self);
+    k_thread_priority_set(self, cond == WCET_PREEMPT
+                          ? K_PRIO_PREEMPT(CONFIG_NUM_PREEMPT_PRIORITIES - 1)
+                          : K_PRIO_COOP(0));
+
+    res->n = 0; res->min = UINT32_MAX; res->max = 0; res->sum = 0;
+    for (uint32_t i = 0; i < iter; ++i) {
+        if (c->setup) c->setup();
+        if (cond == WCET_COLD) cache_cold();
+
+        timing_t t0, t1;
+        if (cond == WCET_IRQOFF) {
+            unsigned int key = irq_lock();
+            t0 = timing_counter_get();
+            c->run();
+            t1 = timing_counter_get();
+            irq_unlock(key);
+        } else {
+            t0 = timing_counter_get();
+            c->run();
+            t1 = timing_counter_get();
+        }
+        if (c->teardown) c->teardown();
+
+        uint32_t cyc = (uint32_t)timing_cycles_get(&t0, &t1);
+        res->min = MIN(res->min, cyc);
+        res->max = MAX(res->max, cyc);
+        res->sum += cyc;
+        res->n++;
+    }
+    k_thread_priority_set(self, prio);
+}
+
+static void wcet_empty(void) { }
+
+static void wcet_row(const struct wcet_case *c, uint32_t iter) {
+    for (int k = 0; k < WCET_COND_COUNT; ++k) {
+        struct wcet_result r;
+        wcet_measure(c, (enum wcet_cond)k, iter, &r);
+        printk("WCET %-16s %-7s %6u %8u %8u %8u %10u\n", c->name, cond_names[k], r.n,
+               r.min, (uint32_t)(r.sum / MAX(r.n, 1U)), r.max,
+               (uint32_t)timing_cycles_to_ns(r.max));
+    }
+}
+
+void wcet_run_all(const struct wcet_case *cases, int n, uint32_t iter) {
+    static const struct wcet_case empty = { "empty", NULL, wcet_empty, NULL };
+
+    printk("WCET BEGIN %s %u %u\n", CONFIG_BOARD, (uint32_t)timing_freq_get(), iter);
+    printk("WCET case             cond         n      min      avg      max     max_ns\n");
+    wcet_row(&empty, iter);
+    for (int i = 0; i < n; ++i) wcet_row(&cases[i], iter);
+    printk("WCET END\n");
+}
@@ -0,0 +1,43 @@
+#ifndef WCET_H
+#define WCET_H
+
+#include <stdint.h>
+
+// WCET-mittaus (CONFIG_LV_WCET, overlay-wcet.conf). Jokainen tapaus ajetaan
+// eristettynä n kertaa kussakin ehdossa; setup/teardown eivät ole mittauksessa.
+// Ajo korkeimmalla co-op-prioriteetilla (paitsi PREEMPT), joten vain
+// keskeytykset voivat häiritä, ja IRQOFF poistaa nekin.
+//
+// Tuloste (sykleinä, timing API), vakiomuoto julkaisujen vertailuun:
+//   WCET BEGIN <board> <hz> <iter>
+//   WCET <tapaus> <ehto> <n> <min> <avg> <max> <max_ns>
+//   WCET END
+// Rivi "empty" on mittauksen oma kustannus; sitä ei vähennetä muista.
+
+enum wcet_cond {
+    WCET_WARM,      // toistettu peräkkäin, välimuisti lämmin
+    WCET_COLD,      // puskuri läpi (+ välimuistin invalidointi) ennen jokaista
+    WCET_IRQOFF,    // irq_lock mittauksen ajan
+    WCET_PREEMPT,   // alin preemptiivinen prioriteetti: muut säikeet voivat keskeyttää
+    WCET_COND_COUNT
+};
+
+struct wcet_case {
+    const char *name;
+    void (*setup)(void);      // NULL = ei mitään
+    void (*run)(void);
+    void (*teardown)(void);
+};
+
+struct wcet_result {
+    uint32_t n;
+    uint32_t min, max;
+    uint64_t sum;
+};
+
+void wcet_measure(const struct wcet_case *c, enum wcet_cond cond, uint32_t iter,
+                  struct wcet_result *res);
+// Koko taulukko: empty + tapaukset, kaikki ehdot
+void wcet_run_all(const struct wcet_case *cases, int n, uint32_t iter);
+
+#endif
@@ -0,0 +1,156 @@
+#include "CitySim.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace city {
+
+int32_t color_code(char c) {
+    switch (c) {
+    case 'R': case 'r': return RED;
+    case 'Y': case 'y': return YELLOW;
+    case 'G': case 'g': return GREEN;
+    }
+    return OFF;
+}
+
+char color_char(int32_t c) {
+    static const char names[] = "-RYG";
+    return c >= 0 && c <= 3 ? names[c] : '?';
+}
+
+void CityState::resize(size_t count) {
+    n = count;
+    padded = (count + 7) & ~size_t(7);
+    for (auto *v : { &phase, &remaining, &q_len, &q_hwm, &plan_base, &plan_len, &plan_loop,
+                     &plan_step, &plan_left, &served, &overflow })
+        v->assign(padded, 0);
+    q_bits.assign(padded, 0);
+}
+
+void step_scalar(CityState &st, const PlanTable &pt, int32_t dt, int32_t light, size_t begin, size_t end) {
+    const int32_t *pcol = pt.color.data();
+    const int32_t *pdel = pt.delay_ms.data();
+    for (size_t i = begin; i < end; ++i) {
+        int32_t  qlen = st.q_len[i];
+        uint32_t qb   = st.q_bits[i];
+
+        // 1) suunnitelma
+        int32_t plen = st.plan_len[i];
+        if (plen > 0) {
+            int32_t left = st.plan_left[i] - dt;
+            if (left <= 0) {
+                int32_t base = st.plan_base[i], s = st.plan_step[i];
+                if (qlen < QCAP) { qb |= (uint32_t)pcol[base + s] << (2 * qlen); qlen++; }
+                else             st.overflow[i]++;
+                int32_t ns = s + 1;
+                if (ns == plen) {
+                    ns = 0;
+                    if (!st.plan_loop[i]) st.plan_len[i] = 0;
+                }
+                left += pdel[base + ns];
+                st.plan_step[i] = ns;
+            }
+            st.plan_left[i] = left;
+        }
+
+        // 2) vaihe
+        int32_t ph = st.phase[i];
+        int32_t r  = st.remaining[i];
+        bool active = ph != OFF;
+        if (active) r -= dt;
+        bool done = active && r <= 0;
+        if ((!active || done) && qlen > 0) {
+            ph = (int32_t)(qb & 3u);
+            qb >>= 2;
+            qlen--;
+            r = (done ? r : 0) + light;
+        } else if (done) {
+            ph = OFF;
+            r  = 0;
+        }
+        st.served[i] += done;
+        st.phase[i]     = ph;
+        st.remaining[i] = r;
+        st.q_bits[i]    = qb;
+        st.q_len[i]     = qlen;
+        st.q_hwm[i]     = std::max(st.q_hwm[i], qlen);
+    }
+}
+
+#if !defined(CITYSIM_AVX2)
+void step_avx2(CityState &st, const PlanTable &pt, int32_t dt, int32_t light, size_t begin, size_t end) {
+    step_scalar(st, pt, dt, light, begin, end);
+}
+bool avx2_available() { return false; }
+#else
+bool avx2_available() { return __builtin_cpu_supports("avx2"); }
+#endif
+
+CitySim::CitySim(size_t n, int32_t light_ms, KernelKind kind) : light_(light_ms) {
+    st_.resize(n);
+    if (kind == KernelKind::Auto) kind = avx2_available() ? KernelKind::Avx2 : KernelKind::Scalar;
+    if (kind == KernelKind::Avx2 && !avx2_available()) throw std::runtime_error("AVX2 not available");
+    kind_ = kind;
+}
+
+int CitySim::add_plan(const std::vector<sim::PlanStep> &steps, bool loop, int32_t min_delay_ms) {
+    if (steps.empty()) return -1;
+    PlanRef ref{(int32_t)pt_.color.size(), (int32_t)steps.size(), loop};
+    for (const auto &s : steps) {
+        int32_t c = color_code(s.color);
+        if (c == OFF) return -1;
+        pt_.color.push_back(c);
+        pt_.delay_ms.push_back(std::max<int32_t>((int32_t)s.delay_s * 1000, min_delay_ms));
+    }
+    refs_.push_back(ref);
+    return (int)refs_.size() - 1;
+}
+
+int CitySim::add_plan(const std::string &spec, int32_t min_delay_ms) {
+    std::vector<sim::PlanStep> steps;
+    bool loop;
+    if (!sim::parse_plan(spec, steps, loop)) return -1;
+    return add_plan(steps, loop, min_delay_ms);
+}
+
+void CitySim::assign(size_t i, int plan, int32_t offset_ms) {
+    const PlanRef &p = refs_.at((size_t)plan);
+    st_.plan_base[i] = p.base;
+    st_.plan_len[i]  = p.len;
+    st_.plan_loop[i] = p.loop ? -1 : 0;
+    st_.plan_step[i] = 0;
+    st_.plan_left[i] = pt_.delay_ms[(size_t)p.base] + offset_ms;
+}
+
+bool CitySim::push(size_t i, char color) {
+    int32_t c = color_code(color);
+    if (c == OFF) return false;
+    if (st_.q_len[i] >= QCAP) { st_.overflow[i]++; return false; }
+    st_.q_bits[i] |= (uint32_t)c << (2 * st_.q_len[i]);
+    st_.q_len[i]++;
+    st_.q_hwm[i] = std::max(st_.q_hwm[i], st_.q_len[i]);
+    return true;
+}
+
+void CitySim::step_range(int32_t dt_ms, size_t begin, size_t end) {
+    if (kind_ == KernelKind::Avx2) step_avx2(st_, pt_, dt_ms, light_, begin, end);
+    else                           step_scalar(st_, pt_, dt_ms, light_, begin, end);
+}
+
+void CitySim::step(int32_t dt_ms) {
+    step_range(dt_ms, 0, st_.padded);
+}
+
+CityTotals CitySim::totals() const {
+    CityTotals t;
+    for (size_t i = 0; i < st_.n; ++i) {
+        t.served   += (uint64_t)st_.served[i];
+        t.overflow += (uint64_t)st_.overflow[i];
+        t.queued   += (uint64_t)st_.q_len[i];
+        t.max_hwm   = std::max(t.max_hwm, st_.q_hwm[i]);
+        t.lit      += st_.phase[i] != OFF;
+    }
+    return t;
+}
+
+} // namespace city
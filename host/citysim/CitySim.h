@@ -0,0 +1,106 @@
+#ifndef CITYSIM_H
+#define CITYSIM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TrafficModel.h"
+
+// Kaupunkitason malli: sadattuhannet risteykset, jokaisella main.c:n
+// sekvensserin semantiikka (R/Y/G-vaihe LIGHT_MS, komennot jonossa,
+// suunnitelma L-muodossa). Tila on taulukoina (SoA) ja askel käsittelee
+// 8 risteystä kerrallaan AVX2:lla; ydin valitaan ajonaikaisesti.
+//
+// Tikin semantiikka (skalaari ja AVX2 identtiset):
+//   1) suunnitelma: plan_left -= dt; <= 0 -> väri jonoon (täynnä: overflow),
+//      seuraava askel, plan_left += sen viive. Korkeintaan yksi askel per tikki,
+//      joten viiveiden on oltava >= dt (add_plan pyöristää ylös).
+//   2) vaihe: remaining -= dt; <= 0 -> vaihe valmis (served). Vapaa risteys
+//      ottaa jonon kärjen, ylijäämä siirtyy seuraavan vaiheen pituuteen.
+// Jono on 2 bittiä per komento yhdessä 32-bittisessä sanassa (QCAP = 16):
+// kärki on alimmat bitit, lisäys siirto+or, otto siirto oikealle.
+// Prioriteettikaistaa ei mallinneta.
+
+namespace city {
+
+constexpr int QCAP = 16;
+enum Color : int32_t { OFF = 0, RED = 1, YELLOW = 2, GREEN = 3 };
+
+int32_t color_code(char c);     // 'R'/'Y'/'G' -> Color, muuten OFF
+char    color_char(int32_t c);
+
+// Kaikkien suunnitelmien askeleet peräkkäin (gather-indeksit)
+struct PlanTable {
+    std::vector<int32_t> color;
+    std::vector<int32_t> delay_ms;
+};
+
+struct CityState {
+    size_t n = 0;                       // risteyksiä
+    size_t padded = 0;                  // n pyöristettynä 8:n monikertaan
+    std::vector<int32_t>  phase;        // Color
+    std::vector<int32_t>  remaining;    // ms
+    std::vector<uint32_t> q_bits;
+    std::vector<int32_t>  q_len;
+    std::vector<int32_t>  q_hwm;        // jonon huippu: suunnitelma ehtii / ei ehdi
+    std::vector<int32_t>  plan_base;
+    std::vector<int32_t>  plan_len;     // 0 = ei suunnitelmaa / päättynyt
+    std::vector<int32_t>  plan_loop;    // -1 / 0
+    std::vector<int32_t>  plan_step;
+    std::vector<int32_t>  plan_left;    // ms seuraavaan askeleeseen
+    std::vector<int32_t>  served;
+    std::vector<int32_t>  overflow;
+
+    void resize(size_t count);
+};
+
+enum class KernelKind { Auto, Scalar, Avx2 };
+
+// Askelytimet väleille [begin, end); AVX2: begin ja end 8:n monikertoja
+void step_scalar(CityState &st, const PlanTable &pt, int32_t dt, int32_t light, size_t begin, size_t end);
+void step_avx2(CityState &st, const PlanTable &pt, int32_t dt, int32_t light, size_t begin, size_t end);
+bool avx2_available();
+
+struct CityTotals {
+    uint64_t served   = 0;
+    uint64_t overflow = 0;
+    uint64_t queued   = 0;
+    int32_t  max_hwm  = 0;
+    size_t   lit      = 0;              // risteyksiä joissa vaihe päällä
+};
+
+class CitySim {
+public:
+    explicit CitySim(size_t n, int32_t light_ms = 1000, KernelKind kind = KernelKind::Auto);
+
+    // Palauttaa suunnitelman tunnisteen; viiveet >= min_delay_ms
+    int  add_plan(const std::vector<sim::PlanStep> &steps, bool loop, int32_t min_delay_ms = 1);
+    int  add_plan(const std::string &spec, int32_t min_delay_ms = 1);   // "R30 Y3 G30 Y3 *", -1 = virhe
+    void assign(size_t i, int plan, int32_t offset_ms = 0);
+    bool push(size_t i, char color);    // UART-komento; false = jono täynnä
+
+    void step(int32_t dt_ms);
+    void step_range(int32_t dt_ms, size_t begin, size_t end);   // begin/end 8:n monikertoja
+
+    KernelKind kernel() const { return kind_; }
+    const char *kernel_name() const { return kind_ == KernelKind::Avx2 ? "avx2" : "scalar"; }
+    int32_t light() const { return light_; }
+    const CityState &state() const { return st_; }
+    CityState &state() { return st_; }
+    const PlanTable &plans() const { return pt_; }
+    CityTotals totals() const;
+
+private:
+    struct PlanRef { int32_t base, len; bool loop; };
+
+    CityState st_;
+    PlanTable pt_;
+    std::vector<PlanRef> refs_;
+    int32_t light_;
+    KernelKind kind_;
+};
+
+} // namespace city
+
+#endif
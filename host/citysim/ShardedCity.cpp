@@ -0,0 +1,161 @@
+#include "ShardedCity.h"
+#include <algorithm>
+#include <barrier>
+#include <stdexcept>
+#include <thread>
+
+namespace city {
+
+static inline uint64_t pack(uint32_t lo, uint32_t hi) { return (uint64_t)lo << 32 | hi; }
+
+static size_t auto_lanes(size_t padded, unsigned threads) {
+    size_t want = (size_t)std::max(threads, 1u) * SHARDS_PER_THREAD;
+    return std::min((padded + want - 1) / want, SHARD_MAX_LANES);
+}
+
+ShardedCity::ShardedCity(CitySim &sim, size_t shard_lanes, unsigned threads)
+    : sim_(sim) {
+    const size_t padded = sim_.state().padded;
+    if (shard_lanes == 0) shard_lanes = auto_lanes(padded, threads);
+    shard_lanes_ = std::max<size_t>((shard_lanes + 7) & ~size_t(7), 8);
+    for (size_t b = 0; b < padded; b += shard_lanes_) {
+        auto sh = std::make_unique<Shard>();
+        sh->begin = b;
+        sh->end   = std::min(b + shard_lanes_, padded);
+        shards_.push_back(std::move(sh));
+    }
+    nthreads_ = (unsigned)std::clamp<size_t>(threads, 1, std::max<size_t>(shards_.size(), 1));
+    ranges_ = std::make_unique<Range[]>(nthreads_);
+}
+
+ShardedCity::~ShardedCity() {
+    for (auto &sh : shards_) {
+        for (Event *e : sh->pending) delete e;
+        for (Event *e = sh->inbox.load(); e; ) { Event *n = e->next; delete e; e = n; }
+    }
+}
+
+void ShardedCity::link(size_t src, size_t dst, int32_t delay_ms, char color) {
+    if (src >= sim_.state().n || dst >= sim_.state().n) throw std::out_of_range("link");
+    Shard &sh = *shards_[src / shard_lanes_];
+    sh.links.push_back({(uint32_t)src, (uint32_t)dst, delay_ms, color_code(color)});
+    sh.prev_phase.push_back(sim_.state().phase[src]);
+    sh.prev_served.push_back(sim_.state().served[src]);
+}
+
+ShardStats ShardedCity::stats() const {
+    ShardStats s;
+    s.ticks  = tick_;
+    s.shards = processed_.load();
+    s.steals = steals_.load();
+    s.events = events_.load();
+    return s;
+}
+
+void ShardedCity::reset_ranges() {
+    const uint32_t n = (uint32_t)shards_.size();
+    for (unsigned w = 0; w < nthreads_; ++w) {
+        uint32_t lo = (uint32_t)((uint64_t)n * w / nthreads_);
+        uint32_t hi = (uint32_t)((uint64_t)n * (w + 1) / nthreads_);
+        ranges_[w].lohi.store(pack(lo, hi), std::memory_order_relaxed);
+    }
+}
+
+// Oma työ välin alusta
+bool ShardedCity::take_own(unsigned w, uint32_t &idx) {
+    auto &r = ranges_[w].lohi;
+    uint64_t v = r.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t lo = (uint32_t)(v >> 32), hi = (uint32_t)v;
+        if (lo >= hi) return false;
+        if (r.compare_exchange_weak(v, pack(lo + 1, hi), std::memory_order_acq_rel)) { idx = lo; return true; }
+    }
+}
+
+// Varastetaan muilta välin lopusta
+bool ShardedCity::steal(unsigned w, uint32_t &idx) {
+    for (unsigned k = 1; k < nthreads_; ++k) {
+        auto &r = ranges_[(w + k) % nthreads_].lohi;
+        uint64_t v = r.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t lo = (uint32_t)(v >> 32), hi = (uint32_t)v;
+            if (lo >= hi) break;
+            if (r.compare_exchange_weak(v, pack(lo, hi - 1), std::memory_order_acq_rel)) {
+                idx = hi - 1;
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Lukoton MPSC-pino: usea lähettäjä, vain kohdesirpaleen käsittely tyhjentää
+void ShardedCity::post(uint32_t dst_shard, Event *e) {
+    auto &box = shards_[dst_shard]->inbox;
+    e->next = box.load(std::memory_order_relaxed);
+    while (!box.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed)) { }
+}
+
+void ShardedCity::process(uint32_t s, uint64_t tick, int32_t dt) {
+    Shard &sh = *shards_[s];
+    CityState &st = sim_.state();
+
+    // 1) postilaatikko -> odottavat; erääntyneet deterministisessä järjestyksessä
+    for (Event *e = sh.inbox.exchange(nullptr, std::memory_order_acquire); e; e = e->next)
+        sh.pending.push_back(e);
+    if (!sh.pending.empty()) {
+        auto due_end = std::partition(sh.pending.begin(), sh.pending.end(),
+                                      [tick](const Event *e) { return e->due <= tick; });
+        std::sort(sh.pending.begin(), due_end, [](const Event *a, const Event *b) {
+            return a->due != b->due ? a->due < b->due : a->src != b->src ? a->src < b->src : a->dst < b->dst;
+        });
+        uint64_t n = 0;
+        for (auto it = sh.pending.begin(); it != due_end; ++it, ++n) {
+            sim_.push((*it)->dst, color_char((*it)->color));
+            delete *it;
+        }
+        sh.pending.erase(sh.pending.begin(), due_end);
+        if (n) events_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // 2) askel
+    sim_.step_range(dt, sh.begin, sh.end);
+    processed_.fetch_add(1, std::memory_order_relaxed);
+
+    // 3) vihreän aallon lähteet: uusi vihreä vaihe alkoi tällä tikillä
+    for (size_t k = 0; k < sh.links.size(); ++k) {
+        const Link &l = sh.links[k];
+        int32_t ph = st.phase[l.src], sv = st.served[l.src];
+        bool started = ph == GREEN && (sh.prev_phase[k] != GREEN || sv != sh.prev_served[k]);
+        sh.prev_phase[k]  = ph;
+        sh.prev_served[k] = sv;
+        if (!started) continue;
+        uint64_t dticks = std::max<int64_t>(1, ((int64_t)l.delay_ms + dt - 1) / dt);
+        post((uint32_t)(l.dst / shard_lanes_), new Event{tick + dticks, l.src, l.dst, l.color, nullptr});
+    }
+}
+
+void ShardedCity::run(int ticks, int32_t dt) {
+    if (ticks <= 0) return;
+    reset_ranges();
+    auto next_tick = [this]() noexcept {
+        ++tick_;
+        reset_ranges();
+    };
+    std::barrier sync((std::ptrdiff_t)nthreads_, next_tick);
+
+    auto body = [&](unsigned w) {
+        for (int t = 0; t < ticks; ++t) {
+            uint64_t tick = tick_;      // kirjoitetaan vain barrierin completionissa
+            uint32_t idx;
+            while (take_own(w, idx) || steal(w, idx)) process(idx, tick, dt);
+            sync.arrive_and_wait();
+        }
+    };
+    std::vector<std::jthread> pool;
+    for (unsigned w = 1; w < nthreads_; ++w) pool.emplace_back(body, w);
+    body(0);
+}
+
+} // namespace city
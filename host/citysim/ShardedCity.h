@@ -0,0 +1,94 @@
+#ifndef SHARDEDCITY_H
+#define SHARDEDCITY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "CitySim.h"
+
+// CitySim jaettuna välimuistin kokoisiin sirpaleisiin (shard) ja
+// ajettuna työtä varastavalla säiejoukolla:
+//   - jokainen säie omistaa yhtenäisen sirpalevälin tikin alussa; oma työ
+//     otetaan välin alusta, varas vie uhrin välin lopusta (yksi 64-bittinen
+//     CAS, ei lukkoja)
+//   - tikkien välissä std::barrier; sirpaleet eivät jaa tilaa tikin aikana
+//   - sirpaleiden väliset tapahtumat (vihreä aalto: src vihreäksi ->
+//     dst:lle väri viiveellä) kulkevat kohdesirpaleen lukottomaan
+//     postilaatikkoon (MPSC-pino) ja toteutetaan aikaisintaan seuraavalla
+//     tikillä, järjestettynä (erääntyminen, lähde) -> tulos ei riipu
+//     säikeiden määrästä eikä ajoituksesta
+
+namespace city {
+
+constexpr size_t   SHARD_MAX_LANES   = 4096;  // ~välimuistin kokoinen sirpale
+constexpr unsigned SHARDS_PER_THREAD = 4;     // varastettavaa myös epätasaisella kuormalla
+
+struct ShardStats {
+    uint64_t ticks     = 0;
+    uint64_t shards    = 0;     // käsiteltyjä sirpale-tikkejä
+    uint64_t steals    = 0;
+    uint64_t events    = 0;     // toimitettuja sirpaleiden välisiä tapahtumia
+};
+
+class ShardedCity {
+public:
+    // shard_lanes pyöristetään 8:n monikertaan (AVX2-ydin). 0 = säiemäärän
+    // mukaan: vähintään SHARDS_PER_THREAD sirpaletta säiettä kohden, enintään
+    // SHARD_MAX_LANES risteystä. Säikeitä ei tule enempää kuin sirpaleita
+    // (ylimääräinen säie vain odottaisi barrierissa).
+    ShardedCity(CitySim &sim, size_t shard_lanes = 0, unsigned threads = 1);
+    ~ShardedCity();
+
+    // Vihreä aalto: kun src:n vihreä vaihe alkaa, dst saa värin delay_ms myöhemmin
+    void link(size_t src, size_t dst, int32_t delay_ms, char color = 'G');
+
+    void run(int ticks, int32_t dt_ms);
+
+    size_t shards() const { return shards_.size(); }
+    size_t shard_lanes() const { return shard_lanes_; }
+    unsigned threads() const { return nthreads_; }
+    ShardStats stats() const;
+
+private:
+    struct Event {
+        uint64_t due;       // tikki jolla toteutetaan
+        uint32_t src, dst;
+        int32_t  color;
+        Event   *next;
+    };
+    struct Link {
+        uint32_t src, dst;
+        int32_t  delay_ms;
+        int32_t  color;
+    };
+    struct alignas(64) Shard {
+        size_t begin = 0, end = 0;
+        std::atomic<Event *> inbox{nullptr};
+        std::vector<Event *> pending;           // vain omistava käsittely koskee
+        std::vector<Link>    links;             // lähde tässä sirpaleessa
+        std::vector<int32_t> prev_phase, prev_served;   // linkkien lähteille
+    };
+    struct alignas(64) Range {
+        std::atomic<uint64_t> lohi{0};          // lo << 32 | hi
+    };
+
+    bool take_own(unsigned w, uint32_t &idx);
+    bool steal(unsigned w, uint32_t &idx);
+    void process(uint32_t s, uint64_t tick, int32_t dt);
+    void post(uint32_t dst_shard, Event *e);
+    void reset_ranges();
+
+    CitySim &sim_;
+    size_t shard_lanes_;
+    unsigned nthreads_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::unique_ptr<Range[]> ranges_;
+    uint64_t tick_ = 0;
+    std::atomic<uint64_t> processed_{0}, steals_{0}, events_{0};
+};
+
+} // namespace city
+
+#endif
@@ -0,0 +1,81 @@
+// AVX2-askel: käännetään -mavx2:lla, kutsutaan vain jos CPU tukee
+// (avx2_available). Sama logiikka kuin step_scalar, 8 risteystä kerrallaan;
+// haarat korvattu maskeilla, suunnitelman askeleet gatherilla.
+#include <immintrin.h>
+#include "CitySim.h"
+
+namespace city {
+
+static inline __m256i ld(const int32_t *p)  { return _mm256_loadu_si256((const __m256i *)p); }
+static inline __m256i ld(const uint32_t *p) { return _mm256_loadu_si256((const __m256i *)p); }
+static inline void st(int32_t *p, __m256i v)  { _mm256_storeu_si256((__m256i *)p, v); }
+static inline void st(uint32_t *p, __m256i v) { _mm256_storeu_si256((__m256i *)p, v); }
+
+void step_avx2(CityState &s, const PlanTable &pt, int32_t dt, int32_t light, size_t begin, size_t end) {
+    const __m256i zero  = _mm256_setzero_si256();
+    const __m256i one   = _mm256_set1_epi32(1);
+    const __m256i three = _mm256_set1_epi32(3);
+    const __m256i qcap  = _mm256_set1_epi32(QCAP);
+    const __m256i vdt   = _mm256_set1_epi32(dt);
+    const __m256i vlit  = _mm256_set1_epi32(light);
+    const int *pcol = (const int *)pt.color.data();
+    const int *pdel = (const int *)pt.delay_ms.data();
+
+    for (size_t i = begin; i < end; i += 8) {
+        __m256i qlen = ld(&s.q_len[i]);
+        __m256i qb   = ld(&s.q_bits[i]);
+
+        // 1) suunnitelma
+        __m256i plen = ld(&s.plan_len[i]);
+        __m256i pm   = _mm256_cmpgt_epi32(plen, zero);
+        __m256i left = _mm256_sub_epi32(ld(&s.plan_left[i]), _mm256_and_si256(vdt, pm));
+        __m256i emit = _mm256_and_si256(pm, _mm256_cmpgt_epi32(one, left));
+        if (!_mm256_testz_si256(emit, emit)) {
+            __m256i base = ld(&s.plan_base[i]);
+            __m256i step = ld(&s.plan_step[i]);
+            __m256i col  = _mm256_mask_i32gather_epi32(zero, pcol, _mm256_add_epi32(base, step), emit, 4);
+            __m256i room = _mm256_cmpgt_epi32(qcap, qlen);
+            __m256i enq  = _mm256_and_si256(emit, room);
+            __m256i sh   = _mm256_slli_epi32(qlen, 1);
+            qb   = _mm256_or_si256(qb, _mm256_and_si256(_mm256_sllv_epi32(col, sh), enq));
+            qlen = _mm256_sub_epi32(qlen, enq);
+            st(&s.overflow[i], _mm256_sub_epi32(ld(&s.overflow[i]), _mm256_andnot_si256(room, emit)));
+
+            __m256i ns   = _mm256_add_epi32(step, one);
+            __m256i wrap = _mm256_cmpeq_epi32(ns, plen);
+            ns = _mm256_andnot_si256(wrap, ns);
+            __m256i stop = _mm256_and_si256(_mm256_and_si256(wrap, emit),
+                                            _mm256_cmpeq_epi32(ld(&s.plan_loop[i]), zero));
+            __m256i del  = _mm256_mask_i32gather_epi32(zero, pdel, _mm256_add_epi32(base, ns), emit, 4);
+            left = _mm256_add_epi32(left, del);
+            st(&s.plan_step[i], _mm256_blendv_epi8(step, ns, emit));
+            st(&s.plan_len[i], _mm256_andnot_si256(stop, plen));
+        }
+        st(&s.plan_left[i], left);
+
+        // 2) vaihe
+        __m256i ph     = ld(&s.phase[i]);
+        __m256i active = _mm256_cmpgt_epi32(ph, zero);
+        __m256i r      = _mm256_sub_epi32(ld(&s.remaining[i]), _mm256_and_si256(vdt, active));
+        __m256i done   = _mm256_and_si256(active, _mm256_cmpgt_epi32(one, r));
+        __m256i freel  = _mm256_or_si256(_mm256_cmpeq_epi32(active, zero), done);
+        __m256i take   = _mm256_and_si256(freel, _mm256_cmpgt_epi32(qlen, zero));
+
+        ph   = _mm256_blendv_epi8(ph, _mm256_and_si256(qb, three), take);
+        qb   = _mm256_blendv_epi8(qb, _mm256_srli_epi32(qb, 2), take);
+        qlen = _mm256_add_epi32(qlen, take);
+        r    = _mm256_blendv_epi8(r, _mm256_add_epi32(_mm256_and_si256(r, done), vlit), take);
+        __m256i idle = _mm256_andnot_si256(take, done);
+        ph   = _mm256_andnot_si256(idle, ph);
+        r    = _mm256_andnot_si256(idle, r);
+
+        st(&s.served[i], _mm256_sub_epi32(ld(&s.served[i]), done));
+        st(&s.phase[i], ph);
+        st(&s.remaining[i], r);
+        st(&s.q_bits[i], qb);
+        st(&s.q_len[i], qlen);
+        st(&s.q_hwm[i], _mm256_max_epi32(ld(&s.q_hwm[i]), qlen));
+    }
+}
+
+} // namespace city
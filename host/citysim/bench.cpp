@@ -0,0 +1,43 @@
+// Askelytimien läpäisymittaus: citybench [risteykset] [tikit] [dt_ms]
+// Tulostaa risteys·tikit/s skalaari- ja AVX2-ytimelle samalla kaupungilla.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include "CitySim.h"
+
+static void build_city(city::CitySim &c) {
+    static const char *const plans[] = {
+        "R30 Y3 G30 Y3 *", "G20 Y3 R40 Y3 *", "R10 G10 *", "R45 Y3 G15 Y3 *",
+    };
+    int ids[4];
+    for (int p = 0; p < 4; ++p) ids[p] = c.add_plan(plans[p]);
+    std::mt19937 rng(1);
+    for (size_t i = 0; i < c.state().n; ++i)
+        c.assign(i, ids[rng() % 4], (int32_t)(rng() % 60000));
+}
+
+int main(int argc, char **argv) {
+    const size_t  n     = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    const int     ticks = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const int32_t dt    = argc > 3 ? std::atoi(argv[3]) : 100;
+
+    city::KernelKind kinds[] = { city::KernelKind::Scalar, city::KernelKind::Avx2 };
+    for (auto kind : kinds) {
+        if (kind == city::KernelKind::Avx2 && !city::avx2_available()) {
+            std::printf("avx2    not available on this CPU\n");
+            continue;
+        }
+        city::CitySim c(n, 1000, kind);
+        build_city(c);
+        auto t0 = std::chrono::steady_clock::now();
+        for (int t = 0; t < ticks; ++t) c.step(dt);
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        city::CityTotals tot = c.totals();
+        std::printf("%-7s %zu intersections x %d ticks (%d ms): %.3f s, %.1f M intersection-ticks/s, "
+                    "served %llu, overflow %llu, max queue %d\n",
+                    c.kernel_name(), n, ticks, dt, s, (double)n * ticks / s / 1e6,
+                    (unsigned long long)tot.served, (unsigned long long)tot.overflow, tot.max_hwm);
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Säiemäärän skaalautuminen: cityscale [risteykset] [tikit] [maks_säikeet]
+// Ajaa saman kaupungin 1, 2, 4, ... säikeellä ja tulostaa läpäisyn,
+// nopeutuksen ja hyötysuhteen. Naapuriristeykset on kytketty vihreällä
+// aallolla, joten sirpaleiden väliset tapahtumat ovat mukana kuormassa.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include "ShardedCity.h"
+
+static void build_city(city::CitySim &c, city::ShardedCity &sc) {
+    static const char *const plans[] = {
+        "R30 Y3 G30 Y3 *", "G20 Y3 R40 Y3 *", "R10 G10 *", "R45 Y3 G15 Y3 *",
+    };
+    int ids[4];
+    for (int p = 0; p < 4; ++p) ids[p] = c.add_plan(plans[p]);
+    std::mt19937 rng(1);
+    const size_t n = c.state().n;
+    for (size_t i = 0; i < n; ++i)
+        c.assign(i, ids[rng() % 4], (int32_t)(rng() % 60000));
+    // joka 16. risteys ohjaa seuraavaa kaupungin toisella laidalla
+    for (size_t i = 0; i + 1 < n; i += 16)
+        sc.link(i, (i + n / 2) % n, 4000);
+}
+
+int main(int argc, char **argv) {
+    const size_t   n     = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    const int      ticks = argc > 2 ? std::atoi(argv[2]) : 2000;
+    const unsigned maxt  = argc > 3 ? (unsigned)std::atoi(argv[3])
+                                    : std::max(1u, std::thread::hardware_concurrency());
+    const int32_t  dt    = 100;
+
+    std::printf("%zu intersections x %d ticks, %u hardware threads\n",
+                n, ticks, std::thread::hardware_concurrency());
+    double base = 0;
+    for (unsigned t = 1; t <= maxt; t *= 2) {
+        city::CitySim c(n, 1000);
+        city::ShardedCity sc(c, 0, t);      // sirpaleet säiemäärän mukaan
+        build_city(c, sc);
+        auto t0 = std::chrono::steady_clock::now();
+        sc.run(ticks, dt);
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        double rate = (double)n * ticks / s / 1e6;
+        if (t == 1) base = rate;
+        city::ShardStats st = sc.stats();
+        std::printf("threads %2u: %.3f s, %8.1f M intersection-ticks/s, speedup %.2f, efficiency %3.0f%%, "
+                    "shards %zu x %zu, steals %llu, events %llu\n",
+                    sc.threads(), s, rate, rate / base, 100.0 * rate / base / sc.threads(),
+                    sc.shards(), sc.shard_lanes(),
+                    (unsigned long long)st.steals, (unsigned long long)st.events);
+    }
+    return 0;
+}
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
+#include "HostCtl.h"
+
+LightController::~LightController() {
+    close();
+}
+
+bool LightController::open(const std::string &path, int baud) {
+    close();
+    if (!port_.open(path, baud)) return false;
+    start_reader();
+    return new_session();
+}
+
+bool LightController::attach(int fd) {
+    close();
+    if (!port_.attach(fd)) return false;
+    start_reader();
+    return new_session();
+}
+
+bool LightController::new_session() {
+    // rivinvaihto päättää firmwaren kesken jääneen A/C/P/L-tilan
+    std::lock_guard<std::mutex> wl(write_mx_);
+    {
+        std::lock_guard<std::mutex> lk(mx_);
+        next_seq_ = 0;
+    }
+    return port_.write_all("\nN", 2);
+}
+
+void LightController::start_reader() {
+    stop_ = false;
+    reader_ = std::thread(&LightController::reader_loop, this);
+}
+
+void LightController::close() {
+    stop_ = true;
+    if (reader_.joinable()) reader_.join();
+    port_.close();
+    fail_all("closed");
+}
+
+int64_t LightController::now_us() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - t0_).count();
+}
+
+bool LightController::write(const void *data, size_t len) {
+    std::lock_guard<std::mutex> lk(write_mx_);
+    return port_.write_all(static_cast<const char *>(data), len);
+}
+
+void LightController::set_line_handler(std::function<void(std::string_view)> h) {
+    std::lock_guard<std::mutex> lk(mx_);
+    line_handler_ = std::move(h);
+}
+
+std::future<PhaseResult> LightController::send_color(char color, bool prio) {
+    auto p = std::make_shared<Pending>();
+    p->color = color;
+    p->batch = -1;
+    p->idx   = 0;
+    p->res.color = color;
+    p->res.prio  = prio;
+    std::future<PhaseResult> f = p->done.get_future();
+
+    char cmd[2] = { '!', color };
+    {
+        // rekisteröinti ennen kirjoitusta: vastaus ei voi ohittaa pyyntöä
+        std::lock_guard<std::mutex> lk(mx_);
+        p->res.sent_us = now_us();
+        (prio ? prio_ : normal_).push_back(p);
+    }
+    if (!write(prio ? cmd : cmd + 1, prio ? 2 : 1)) {
+        std::lock_guard<std::mutex> lk(mx_);
+        auto &q = prio ? prio_ : normal_;
+        q.erase(std::remove(q.begin(), q.end(), p), q.end());
+        p->done.set_exception(std::make_exception_ptr(std::runtime_error("write failed")));
+    }
+    return f;
+}
+
+bool LightController::send_timer(int secs) {
+    if (secs < 0 || secs >= 24 * 3600) return false;
+    char buf[8];
+    std::snprintf(buf, sizeof(buf), "A%02d%02d%02d", secs / 3600, secs / 60 % 60, secs % 60);
+    return write(buf, 7);
+}
+
+bool LightController::sync_clock(int64_t ms) {
+    if (ms < 0 || ms >= 24 * 3600 * 1000) return false;
+    int secs = (int)(ms / 1000);
+    char buf[16];
+    int n = std::snprintf(buf, sizeof(buf), "C%02d%02d%02d%03d\n",
+                          secs / 3600, secs / 60 % 60, secs % 60, (int)(ms % 1000));
+    return write(buf, (size_t)n);
+}
+
+bool LightController::sync_clock() {
+    using namespace std::chrono;
+    auto now = system_clock::now();
+    std::time_t t = system_clock::to_time_t(now);
+    std::tm lt{};
+    localtime_r(&t, &lt);
+    int64_t ms = duration_cast<milliseconds>(now.time_since_epoch()).count() % 1000;
+    return sync_clock(((int64_t)lt.tm_hour * 3600 + lt.tm_min * 60 + lt.tm_sec) * 1000 + ms);
+}
+
+BatchHandle LightController::send_batch(const std::vector<BatchCmd> &cmds) {
+    BatchHandle h;
+    auto ack = std::make_unique<std::promise<FrameAck>>();
+    h.ack = ack->get_future();
+
+    uint8_t payload[FRAME_MAX_LEN];
+    size_t n = 0;
+    for (const BatchCmd &c : cmds) {
+        size_t need = c.color == 'A' ? 4 : (c.prio ? 2 : 1);
+        if (n + need > sizeof(payload)) {
+            ack->set_exception(std::make_exception_ptr(std::length_error("batch too long")));
+            return h;
+        }
+        if (c.color == 'A') {
+            payload[n++] = 'A';
+            payload[n++] = (uint8_t)(c.secs / 3600);
+            payload[n++] = (uint8_t)(c.secs / 60 % 60);
+            payload[n++] = (uint8_t)(c.secs % 60);
+        } else {
+            if (c.prio) payload[n++] = '!';
+            payload[n++] = (uint8_t)c.color;
+        }
+    }
+
+    std::vector<uint8_t> frame;
+    uint8_t seq;
+    std::lock_guard<std::mutex> wl(write_mx_);   // seq-järjestys = kirjoitusjärjestys
+    {
+        std::lock_guard<std::mutex> lk(mx_);
+        seq = next_seq_++;
+        if (!encode_frame(seq, payload, n, frame)) {
+            ack->set_exception(std::make_exception_ptr(std::length_error("empty batch")));
+            return h;
+        }
+        int64_t t = now_us();
+        int idx[2] = { 0, 0 };      // normaali, prio
+        for (const BatchCmd &c : cmds) {
+            if (c.color == 'A') continue;
+            auto p = std::make_shared<Pending>();
+            p->color = c.color;
+            p->batch = seq;
+            p->idx   = idx[c.prio]++;
+            p->res.color   = c.color;
+            p->res.prio    = c.prio;
+            p->res.sent_us = t;
+            h.phases.push_back(p->done.get_future());
+            (c.prio ? prio_ : normal_).push_back(p);
+        }
+        acks_[seq] = std::move(ack);
+    }
+    if (!port_.write_all(reinterpret_cast<const char *>(frame.data()), frame.size())) {
+        std::lock_guard<std::mutex> lk(mx_);
+        for (auto *q : { &prio_, &normal_ }) {
+            for (auto it = q->begin(); it != q->end();) {
+                if ((*it)->batch != seq) { ++it; continue; }
+                (*it)->done.set_exception(std::make_exception_ptr(std::runtime_error("write failed")));
+                it = q->erase(it);
+            }
+        }
+        if (acks_[seq]) {
+            acks_[seq]->set_exception(std::make_exception_ptr(std::runtime_error("write failed")));
+            acks_[seq].reset();
+        }
+    }
+    return h;
+}
+
+LineHandle LightController::send_line(std::string_view line) {
+    LineHandle h;
+    cmd_list cl;
+    h.error = cmd_parse(line.data(), line.size(), &cl);
+    if (h.error != COMMAND_OK) {
+        h.error_pos = cl.error_pos;
+        return h;
+    }
+    for (int i = 0; i < cl.count; ++i) {
+        const cmd_record &r = cl.cmd[i];
+        switch (r.type) {
+        case CMD_COLOR: h.phases.push_back(send_color(r.color));       break;
+        case CMD_PRIO:  h.phases.push_back(send_color(r.color, true)); break;
+        case CMD_TIMED: send_timer(r.seconds);                         break;
+        case CMD_DEBUG:
+        case CMD_QUERY: write(&r.color, 1);                            break;
+        }
+    }
+    return h;
+}
+
+void LightController::reader_loop() {
+    LineScanner sc;
+    char rx[256];
+    while (!stop_) {
+        long n = port_.read_some(rx, sizeof(rx), 50);
+        if (n < 0) break;
+        sc.feed(rx, (size_t)n, [this](std::string_view l) { on_line(l); });
+    }
+    fail_all("link closed");
+}
+
+void LightController::on_line(std::string_view line) {
+    const TraceEvent ev = parse_trace(line);
+    const int64_t t = now_us();
+
+    switch (ev.kind) {
+    case TraceKind::Dispatch: on_dispatch(ev.color, t); break;
+    case TraceKind::Task:     on_task(ev.color, (uint64_t)ev.value, t); break;
+    case TraceKind::Ack:      on_ack(ev, true); break;
+    case TraceKind::Nak:      on_ack(ev, false); break;
+    default: {
+        std::function<void(std::string_view)> h;
+        {
+            std::lock_guard<std::mutex> lk(mx_);
+            h = line_handler_;
+        }
+        if (h) h(line);
+        break;
+    }
+    }
+}
+
+void LightController::on_dispatch(char color, int64_t t) {
+    std::lock_guard<std::mutex> lk(mx_);
+    // prio-kaista ajetaan ensin
+    for (auto *q : { &prio_, &normal_ }) {
+        for (auto &p : *q) {
+            if (p->res.dispatch_us >= 0) continue;
+            if (p->color == color) { p->res.dispatch_us = t; return; }
+            break;
+        }
+    }
+}
+
+void LightController::on_task(char color, uint64_t us, int64_t t) {
+    std::lock_guard<std::mutex> lk(mx_);
+    for (auto *q : { &prio_, &normal_ }) {
+        auto it = std::find_if(q->begin(), q->end(),
+                               [color](const PendingPtr &p) { return p->color == color; });
+        if (it == q->end()) continue;
+        if (q == &prio_ && it != q->begin()) continue;   // prio-jonossa vain kärki kelpaa
+        // FIFO: ohitetut edeltäjät on pudotettu (k_malloc epäonnistui)
+        for (auto d = q->begin(); d != it; ++d) {
+            (*d)->done.set_exception(std::make_exception_ptr(std::runtime_error("dropped")));
+        }
+        PendingPtr p = *it;
+        q->erase(q->begin(), it + 1);
+        p->res.done_us  = t;
+        p->res.phase_us = us;
+        p->done.set_value(p->res);
+        return;
+    }
+    unmatched_++;
+}
+
+void LightController::on_ack(const TraceEvent &ev, bool ok) {
+    std::lock_guard<std::mutex> lk(mx_);
+    if (ev.seq < 0 || ev.seq > 255 || !acks_[ev.seq]) {
+        unmatched_++;
+        return;
+    }
+    std::unique_ptr<std::promise<FrameAck>> ack = std::move(acks_[ev.seq]);
+
+    // Jonoon menneet ovat kummankin kaistan alkuosa: rajoitin ohittaa vain
+    // normaaleja (prio menee aina), allokointivirhe lopettaa koko erän.
+    // dup: sama seq oli jo otettu vastaan, tästä erästä ei jonoon mitään
+    int keep_prio = 0, keep_norm = 0;
+    if (ok && !ev.dup) {
+        int queued = (int)ev.value;
+        int nprio  = ev.prio;
+        if (nprio < 0) {    // vanha firmware: oletetaan priot jonoon ensin
+            nprio = (int)std::count_if(prio_.begin(), prio_.end(),
+                                       [&](const PendingPtr &p) { return p->batch == ev.seq; });
+            nprio = std::min(nprio, queued);
+        }
+        keep_prio = nprio;
+        keep_norm = queued - nprio;
+    }
+    const char *why = !ok ? "frame rejected" : ev.dup ? "duplicate" : "dropped";
+    for (auto *q : { &prio_, &normal_ }) {
+        int keep = q == &prio_ ? keep_prio : keep_norm;
+        for (auto it = q->begin(); it != q->end();) {
+            if ((*it)->batch != ev.seq || (*it)->idx < keep) { ++it; continue; }
+            (*it)->done.set_exception(std::make_exception_ptr(std::runtime_error(why)));
+            it = q->erase(it);
+        }
+    }
+    if (ok) {
+        FrameAck a;
+        a.seq = ev.seq; a.queued = (int)ev.value; a.prio = keep_prio; a.dup = ev.dup;
+        ack->set_value(a);
+    } else {
+        ack->set_exception(std::make_exception_ptr(
+            std::runtime_error("NAK " + std::to_string(ev.value))));
+    }
+}
+
+void LightController::fail_all(const char *why) {
+    std::lock_guard<std::mutex> lk(mx_);
+    for (auto *q : { &prio_, &normal_ }) {
+        for (auto &p : *q) p->done.set_exception(std::make_exception_ptr(std::runtime_error(why)));
+        q->clear();
+    }
+    for (auto &a : acks_) {
+        if (a) {
+            a->set_exception(std::make_exception_ptr(std::runtime_error(why)));
+            a.reset();
+        }
+    }
+}
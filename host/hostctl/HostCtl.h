@@ -0,0 +1,126 @@
+#ifndef HOSTCTL_H
+#define HOSTCTL_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "CommandParser.h"
+#include "SerialPort.h"
+#include "TraceScan.h"
+
+// Firmwaren ohjaus putkitettuna: komennot kirjoitetaan heti ilman kaiun
+// odotusta, vastaukset yhdistetään pyyntöihin lukijasäikeessä.
+
+struct PhaseResult {
+    char     color      = 0;
+    bool     prio       = false;
+    int64_t  sent_us    = 0;
+    int64_t  dispatch_us = -1;  // -1 jos "Dispatch"-riviä ei tullut (debug pois)
+    int64_t  done_us    = 0;    // "TASK X time" -rivin saapuminen
+    uint64_t phase_us   = 0;    // firmwaren mittaama vaiheen kesto
+};
+
+struct FrameAck {
+    int  seq    = -1;
+    int  queued = 0;    // joista prio-kaistalla prio
+    int  prio   = 0;
+    bool dup    = false;
+};
+
+struct BatchCmd {
+    char color;         // 'R','Y','G' tai 'A'
+    bool prio = false;
+    int  secs = 0;      // 'A'
+};
+
+struct BatchHandle {
+    std::future<FrameAck> ack;
+    std::vector<std::future<PhaseResult>> phases;   // yksi per värikomento
+};
+
+// Rivikomento (CommandParser.h): koko rivi tarkistetaan ennen kuin mitään lähetetään
+struct LineHandle {
+    int error     = COMMAND_OK;     // COLOR_ERROR / TIME_ERROR / COMMAND_ERROR
+    int error_pos = -1;             // virheen kohta rivillä
+    std::vector<std::future<PhaseResult>> phases;   // yksi per väri (myös prio/X)
+};
+
+class LightController {
+public:
+    LightController() = default;
+    ~LightController();
+
+    LightController(const LightController &) = delete;
+    LightController &operator=(const LightController &) = delete;
+
+    // open ja attach aloittavat uuden istunnon (new_session)
+    bool open(const std::string &path, int baud = 115200);
+    // Valmiiksi avattu tiedostokuvaaja (testit, socketpair)
+    bool attach(int fd);
+    // "\nN": firmware unohtaa edellisen kehyksen seq:n (dup-tunnistus) ja
+    // vastaa "SESSION"; kehysnumerointi alkaa nollasta
+    bool new_session();
+    // Pysäyttää lukijan; odottavat pyynnöt epäonnistuvat
+    void close();
+
+    // R/Y/G (prio: prioriteettikaista), valmis kun vaihe on ajettu
+    std::future<PhaseResult> send_color(char color, bool prio = false);
+    // A+HHMMSS: laukaisu kellonaikaan secs, toistuu päivittäin (vaatii sync_clockin)
+    bool send_timer(int secs);
+    // C+HHMMSSmmm: firmwaren seinäkello; toistuva kutsu korjaa kiteen ryömimisen
+    bool sync_clock(int64_t ms_of_day);
+    // Paikallinen aika
+    bool sync_clock();
+    // Koko erä yhdessä CRC-kehyksessä
+    BatchHandle send_batch(const std::vector<BatchCmd> &cmds);
+    // Käyttäjän rivi, esim. "R !G A070000 S": virheellinen rivi ei lähetä mitään
+    LineHandle send_line(std::string_view line);
+    // Muut rivit (tilastot, debug) lukijasäikeessä
+    void set_line_handler(std::function<void(std::string_view)> h);
+
+    long unmatched_lines() const { return unmatched_.load(); }
+
+private:
+    struct Pending {
+        char    color;
+        int     batch;      // kehyksen seq, -1 = ASCII
+        int     idx;        // järjestys kehyksessä oman kaistansa sisällä
+        PhaseResult res;
+        std::promise<PhaseResult> done;
+    };
+    using PendingPtr = std::shared_ptr<Pending>;
+
+    void start_reader();
+    void reader_loop();
+    void on_line(std::string_view line);
+    void on_dispatch(char color, int64_t t);
+    void on_task(char color, uint64_t us, int64_t t);
+    void on_ack(const TraceEvent &ev, bool ok);
+    void fail_all(const char *why);
+    int64_t now_us() const;
+    bool write(const void *data, size_t len);
+
+    SerialPort port_;
+    std::thread reader_;
+    std::atomic<bool> stop_{false};
+    std::atomic<long> unmatched_{0};
+    std::chrono::steady_clock::time_point t0_ = std::chrono::steady_clock::now();
+
+    std::mutex write_mx_;
+    std::mutex mx_;
+    std::deque<PendingPtr> normal_;   // seq_fifo-järjestys
+    std::deque<PendingPtr> prio_;     // prio_fifo-järjestys
+    std::unique_ptr<std::promise<FrameAck>> acks_[256];
+    uint8_t next_seq_ = 0;
+    std::function<void(std::string_view)> line_handler_;
+};
+
+#endif
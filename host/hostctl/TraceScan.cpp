@@ -0,0 +1,88 @@
+#include <charconv>
+#include "TraceScan.h"
+
+static bool starts_with(std::string_view s, std::string_view p) {
+    return s.size() >= p.size() && s.compare(0, p.size(), p) == 0;
+}
+
+static char color_word(std::string_view w) {
+    if (starts_with(w, "RED"))    return 'R';
+    if (starts_with(w, "YELLOW")) return 'Y';
+    if (starts_with(w, "GREEN"))  return 'G';
+    return 0;
+}
+
+// Lukee kokonaisluvun ja siirtää s:n sen ohi (välilyönnit ohitetaan)
+static bool take_int(std::string_view &s, int64_t &v) {
+    while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+    auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+    if (r.ec != std::errc()) return false;
+    s.remove_prefix((size_t)(r.ptr - s.data()));
+    return true;
+}
+
+TraceEvent parse_trace(std::string_view line) {
+    TraceEvent ev;
+    int64_t v = 0;
+
+    if (starts_with(line, "Dispatch -> ")) {
+        ev.color = color_word(line.substr(12));
+        if (ev.color) ev.kind = TraceKind::Dispatch;
+    } else if (starts_with(line, "TASK ") && line.size() > 6) {
+        std::string_view rest = line.substr(6);
+        if (starts_with(rest, " time:")) {
+            rest.remove_prefix(6);
+            if (take_int(rest, v)) {
+                ev.kind  = TraceKind::Task;
+                ev.color = line[5];
+                ev.value = v;
+            }
+        }
+    } else if (starts_with(line, "TIMER -> ") && line.size() > 9) {
+        ev.kind  = TraceKind::Timer;
+        ev.color = line[9];
+    } else if (starts_with(line, "ACK ")) {
+        std::string_view rest = line.substr(4);
+        int64_t seq = 0;
+        if (take_int(rest, seq) && take_int(rest, v)) {
+            ev.kind  = TraceKind::Ack;
+            ev.seq   = (int)seq;
+            ev.value = v;
+            if (take_int(rest, v)) ev.prio = (int)v;
+            ev.dup   = rest.find("dup") != std::string_view::npos;
+        }
+    } else if (starts_with(line, "NAK ")) {
+        std::string_view rest = line.substr(4);
+        int64_t seq = 0;
+        ev.kind = TraceKind::Nak;
+        if (take_int(rest, seq)) {
+            ev.seq = (int)seq;
+            if (take_int(rest, v)) ev.value = v;
+        }
+    }
+    return ev;
+}
+
+uint16_t crc16_ccitt_false(const uint8_t *data, size_t len, uint16_t crc) {
+    for (size_t i = 0; i < len; ++i) {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (int b = 0; b < 8; ++b) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool encode_frame(uint8_t seq, const uint8_t *payload, size_t len, std::vector<uint8_t> &out) {
+    if (len == 0 || len > FRAME_MAX_LEN) return false;
+    out.clear();
+    out.reserve(len + 5);
+    out.push_back(FRAME_SYNC);
+    out.push_back((uint8_t)len);
+    out.push_back(seq);
+    out.insert(out.end(), payload, payload + len);
+    uint16_t crc = crc16_ccitt_false(out.data() + 1, len + 2);
+    out.push_back((uint8_t)(crc >> 8));
+    out.push_back((uint8_t)crc);
+    return true;
+}
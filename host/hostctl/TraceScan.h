@@ -0,0 +1,64 @@
+#ifndef TRACESCAN_H
+#define TRACESCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Firmwaren tulosterivien tunnistus ilman allokointeja.
+
+enum class TraceKind {
+    Other,
+    Dispatch,   // "Dispatch -> RED"
+    Task,       // "TASK R time: 1000123 us"
+    Timer,      // "TIMER -> R (Wait 5 s)"
+    Ack,        // "ACK <seq> <n> <prio>" / "ACK <seq> <n> dup"
+    Nak,        // "NAK <seq> <reason>" / "NAK timeout"
+};
+
+struct TraceEvent {
+    TraceKind kind  = TraceKind::Other;
+    char      color = 0;
+    int       seq   = -1;
+    int64_t   value = 0;    // Task: us, Ack: komentoja jonossa, Nak: syy
+    bool      dup   = false;
+    int       prio  = -1;   // Ack: joista prio-kaistalla (-1 = ei ilmoitettu)
+};
+
+TraceEvent parse_trace(std::string_view line);
+
+// Kiinteä rivipuskuri: feed() kutsuu on_line jokaisesta valmiista rivistä.
+// Liian pitkä rivi katkaistaan puskurin mittaan.
+class LineScanner {
+public:
+    template <typename F>
+    void feed(const char *data, size_t n, F &&on_line) {
+        for (size_t i = 0; i < n; ++i) {
+            char c = data[i];
+            if (c == '\n') {
+                size_t len = len_;
+                if (len && buf_[len - 1] == '\r') --len;
+                on_line(std::string_view(buf_, len));
+                len_ = 0;
+            } else if (len_ < sizeof(buf_)) {
+                buf_[len_++] = c;
+            }
+        }
+    }
+private:
+    char   buf_[256];
+    size_t len_ = 0;
+};
+
+// Binäärikehys (LIIKENNEVALOT/src/frame.h)
+constexpr uint8_t FRAME_SYNC    = 0xA5;
+constexpr size_t  FRAME_MAX_LEN = 64;
+
+// CRC-16/CCITT-FALSE (Zephyr crc16_itu_t, alku 0xFFFF)
+uint16_t crc16_ccitt_false(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF);
+
+// Palauttaa false jos payload on tyhjä tai liian pitkä
+bool encode_frame(uint8_t seq, const uint8_t *payload, size_t len, std::vector<uint8_t> &out);
+
+#endif
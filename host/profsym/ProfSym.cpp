@@ -0,0 +1,153 @@
+#include "ProfSym.h"
+
+#include <elf.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+
+bool ElfSymbols::load(const std::string &path) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) { err_ = "cannot open " + path; return false; }
+    std::vector<uint8_t> img((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    return load(img);
+}
+
+bool ElfSymbols::load(const std::vector<uint8_t> &img) {
+    syms_.clear();
+    err_.clear();
+    if (img.size() < EI_NIDENT || std::memcmp(img.data(), ELFMAG, SELFMAG) != 0) {
+        err_ = "not an ELF file";
+        return false;
+    }
+    if (img[EI_DATA] != ELFDATA2LSB) { err_ = "big-endian ELF not supported"; return false; }
+    if (img[EI_CLASS] == ELFCLASS32) return parse<Elf32_Ehdr, Elf32_Shdr, Elf32_Sym>(img);
+    if (img[EI_CLASS] == ELFCLASS64) return parse<Elf64_Ehdr, Elf64_Shdr, Elf64_Sym>(img);
+    err_ = "unknown ELF class";
+    return false;
+}
+
+template <typename T>
+static bool read_at(const std::vector<uint8_t> &img, uint64_t off, T &out) {
+    if (off > img.size() || img.size() - off < sizeof(T)) return false;
+    std::memcpy(&out, img.data() + off, sizeof(T));
+    return true;
+}
+
+template <typename Ehdr, typename Shdr, typename SymT>
+bool ElfSymbols::parse(const std::vector<uint8_t> &img) {
+    Ehdr eh;
+    if (!read_at(img, 0, eh)) { err_ = "truncated ELF header"; return false; }
+    // Thumb-funktioiden osoitteissa bitti 0 on tilabitti
+    const uint64_t addr_mask = eh.e_machine == EM_ARM ? ~uint64_t(1) : ~uint64_t(0);
+
+    for (unsigned i = 0; i < eh.e_shnum; ++i) {
+        Shdr sh;
+        if (!read_at(img, eh.e_shoff + (uint64_t)i * eh.e_shentsize, sh)) break;
+        if (sh.sh_type != SHT_SYMTAB || sh.sh_entsize == 0) continue;
+
+        Shdr strh;
+        if (!read_at(img, eh.e_shoff + (uint64_t)sh.sh_link * eh.e_shentsize, strh)) continue;
+        if (strh.sh_offset > img.size()) continue;
+        const char  *strtab = reinterpret_cast<const char *>(img.data() + strh.sh_offset);
+        const size_t strsz  = std::min<uint64_t>(strh.sh_size, img.size() - strh.sh_offset);
+
+        for (uint64_t k = 0; k < sh.sh_size / sh.sh_entsize; ++k) {
+            SymT s;
+            if (!read_at(img, sh.sh_offset + k * sh.sh_entsize, s)) break;
+            if ((s.st_info & 0xf) != STT_FUNC || s.st_value == 0) continue;
+            if (s.st_name >= strsz) continue;
+            const char *nm = strtab + s.st_name;
+            syms_.push_back({ s.st_value & addr_mask, s.st_size,
+                              std::string(nm, strnlen(nm, strsz - s.st_name)) });
+        }
+    }
+    if (syms_.empty()) { err_ = "no function symbols (stripped?)"; return false; }
+
+    std::sort(syms_.begin(), syms_.end(), [](const Sym &a, const Sym &b) {
+        return a.addr != b.addr ? a.addr < b.addr : a.size > b.size;
+    });
+    // aliakset samaan osoitteeseen: pidetään ensimmäinen
+    syms_.erase(std::unique(syms_.begin(), syms_.end(),
+                            [](const Sym &a, const Sym &b) { return a.addr == b.addr; }),
+                syms_.end());
+    return true;
+}
+
+std::string_view ElfSymbols::lookup(uint64_t addr) const {
+    auto it = std::upper_bound(syms_.begin(), syms_.end(), addr,
+                               [](uint64_t a, const Sym &s) { return a < s.addr; });
+    if (it == syms_.begin()) return {};
+    --it;
+    // koko 0 (asm-symbolit): hyväksytään seuraavaan symboliin asti
+    if (it->size && addr >= it->addr + it->size) return {};
+    return it->name;
+}
+
+uint64_t ElfSymbols::address_of(std::string_view name) const {
+    for (const Sym &s : syms_) {
+        if (s.name == name) return s.addr;
+    }
+    return 0;
+}
+
+ProfCapture parse_prof_log(std::istream &in) {
+    ProfCapture cap;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t p = line.find("PROF ");
+        if (p == std::string::npos) continue;
+        std::istringstream ls(line.substr(p + 5));
+        std::string tag;
+        ls >> tag;
+        if (tag == "BEGIN") {
+            cap = ProfCapture{};
+            ls >> cap.hz >> cap.samples >> cap.lost;
+        } else if (tag == "T") {
+            unsigned idx;
+            std::string name;
+            if (!(ls >> idx >> name)) continue;
+            if (cap.threads.size() <= idx) cap.threads.resize(idx + 1, "?");
+            cap.threads[idx] = name;
+        } else if (tag == "S") {
+            ProfSample s;
+            std::string pc;
+            if (!(ls >> s.tid >> pc >> s.count)) continue;
+            s.pc = (uint32_t)std::strtoul(pc.c_str(), nullptr, 16);
+            cap.runs.push_back(s);
+        } else if (tag == "END") {
+            cap.complete = true;
+        }
+    }
+    return cap;
+}
+
+std::vector<std::pair<std::string, unsigned>>
+fold_samples(const ProfCapture &cap, const ElfSymbols &syms) {
+    std::map<std::string, unsigned> acc;
+    char hex[16];
+    for (const ProfSample &s : cap.runs) {
+        std::string key = s.tid < cap.threads.size() ? cap.threads[s.tid] : "?";
+        key += ';';
+        if (s.pc == 0) {
+            key += "[no-pc]";
+        } else {
+            std::string_view fn = syms.lookup(s.pc);
+            if (fn.empty()) {
+                std::snprintf(hex, sizeof(hex), "0x%08x", s.pc);
+                key += hex;
+            } else {
+                key += fn;
+            }
+        }
+        acc[key] += s.count;
+    }
+    std::vector<std::pair<std::string, unsigned>> out(acc.begin(), acc.end());
+    std::stable_sort(out.begin(), out.end(),
+                     [](const auto &a, const auto &b) { return a.second > b.second; });
+    return out;
+}
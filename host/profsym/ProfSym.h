@@ -0,0 +1,62 @@
+#ifndef PROFSYM_H
+#define PROFSYM_H
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Firmwaren näytteistävän profiloijan (LIIKENNEVALOT/src/profiler.c)
+// dumpin symbolointi ja koonti flame graph -muotoon.
+
+// ELF:n funktiosymbolit (.symtab), ELF32 ja ELF64, little-endian.
+class ElfSymbols {
+public:
+    bool load(const std::string &path);
+    bool load(const std::vector<uint8_t> &image);
+
+    // Funktio johon osoite osuu, tyhjä jos ei löydy
+    std::string_view lookup(uint64_t addr) const;
+    // Symbolin alkuosoite (0 jos ei löydy)
+    uint64_t address_of(std::string_view name) const;
+    size_t size() const { return syms_.size(); }
+    const std::string &error() const { return err_; }
+
+private:
+    struct Sym {
+        uint64_t    addr;
+        uint64_t    size;
+        std::string name;
+    };
+    template <typename Ehdr, typename Shdr, typename SymT>
+    bool parse(const std::vector<uint8_t> &img);
+
+    std::vector<Sym> syms_;     // osoitejärjestyksessä
+    std::string      err_;
+};
+
+struct ProfSample {
+    unsigned tid;
+    uint32_t pc;
+    unsigned count;
+};
+
+struct ProfCapture {
+    unsigned hz       = 0;
+    unsigned samples  = 0;      // BEGIN-rivin ilmoittama määrä
+    unsigned lost     = 0;
+    std::vector<std::string> threads;
+    std::vector<ProfSample>  runs;
+    bool complete     = false;  // END nähty
+};
+
+// Poimii PROF-rivit muun tulosteen seasta. Viimeinen dumppi voittaa.
+ProfCapture parse_prof_log(std::istream &in);
+
+// "säie;funktio" -> näytteitä, laskevassa järjestyksessä
+std::vector<std::pair<std::string, unsigned>>
+fold_samples(const ProfCapture &cap, const ElfSymbols &syms);
+
+#endif
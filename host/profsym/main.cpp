@@ -0,0 +1,75 @@
+// profsym: firmwaren profiloijadumpin (UART 'F') symbolointi.
+//
+//   profsym <zephyr.elf> [capture.log|-] [--top N]
+//
+// Tulostaa flame graph -koontimuodon ("säie;funktio näytteet"), esim.
+//   profsym build/zephyr/zephyr.elf uart.log | flamegraph.pl > prof.svg
+// --top N tulostaa sen sijaan N yleisintä funktiota prosentteineen.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include "ProfSym.h"
+
+static void usage(const char *prog) {
+    std::fprintf(stderr, "usage: %s <zephyr.elf> [capture.log|-] [--top N]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) { usage(argv[0]); return 2; }
+
+    std::string elf = argv[1];
+    std::string log = "-";
+    int top = 0;
+    for (int i = 2; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--top") && i + 1 < argc) top = std::atoi(argv[++i]);
+        else if (argv[i][0] != '-' || !std::strcmp(argv[i], "-")) log = argv[i];
+        else { usage(argv[0]); return 2; }
+    }
+
+    ElfSymbols syms;
+    if (!syms.load(elf)) {
+        std::fprintf(stderr, "%s: %s\n", elf.c_str(), syms.error().c_str());
+        return 1;
+    }
+
+    ProfCapture cap;
+    if (log == "-") {
+        cap = parse_prof_log(std::cin);
+    } else {
+        std::ifstream f(log);
+        if (!f) { std::perror(log.c_str()); return 1; }
+        cap = parse_prof_log(f);
+    }
+    if (cap.runs.empty()) {
+        std::fprintf(stderr, "no PROF samples found\n");
+        return 1;
+    }
+    if (!cap.complete) std::fprintf(stderr, "warning: capture has no PROF END\n");
+    if (cap.lost) std::fprintf(stderr, "warning: %u samples overwritten in ring\n", cap.lost);
+
+    auto folded = fold_samples(cap, syms);
+    if (top <= 0) {
+        for (const auto &f : folded) std::printf("%s %u\n", f.first.c_str(), f.second);
+        return 0;
+    }
+
+    // funktiokohtainen yhteenveto säikeistä riippumatta
+    std::map<std::string, unsigned> fn;
+    unsigned total = 0;
+    for (const auto &f : folded) {
+        fn[f.first.substr(f.first.find(';') + 1)] += f.second;
+        total += f.second;
+    }
+    std::vector<std::pair<std::string, unsigned>> v(fn.begin(), fn.end());
+    std::stable_sort(v.begin(), v.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+    std::printf("%u samples @ %u Hz\n", total, cap.hz);
+    for (int i = 0; i < top && i < (int)v.size(); ++i) {
+        std::printf("%6.2f%%  %6u  %s\n", 100.0 * v[i].second / total, v[i].second, v[i].first.c_str());
+    }
+    return 0;
+}
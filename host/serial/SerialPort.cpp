@@ -0,0 +1,92 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "SerialPort.h"
+
+static speed_t to_speed(int baud) {
+    switch (baud) {
+    case 9600:   return B9600;
+    case 19200:  return B19200;
+    case 38400:  return B38400;
+    case 57600:  return B57600;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    default:     return B115200;
+    }
+}
+
+SerialPort::~SerialPort() {
+    close();
+}
+
+bool SerialPort::open(const std::string &path, int baud) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd_ < 0) return false;
+
+    struct termios tio;
+    if (tcgetattr(fd_, &tio) == 0) {
+        // pty:lle termios on ok, putkelle/socketille ei -> ohitetaan
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, to_speed(baud));
+        cfsetospeed(&tio, to_speed(baud));
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cc[VMIN]  = 0;
+        tio.c_cc[VTIME] = 0;
+        if (tcsetattr(fd_, TCSANOW, &tio) != 0) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SerialPort::attach(int fd) {
+    close();
+    if (fd < 0) return false;
+    int fl = fcntl(fd, F_GETFL);
+    if (fl < 0 || fcntl(fd, F_SETFL, fl | O_NONBLOCK) < 0) return false;
+    fd_ = fd;
+    return true;
+}
+
+void SerialPort::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool SerialPort::write_all(const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd_, data, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) {
+                struct pollfd p = { fd_, POLLOUT, 0 };
+                ::poll(&p, 1, 100);
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len  -= (size_t)n;
+    }
+    return true;
+}
+
+long SerialPort::read_some(char *buf, size_t len, int timeout_ms) {
+    struct pollfd p = { fd_, POLLIN, 0 };
+    int r = ::poll(&p, 1, timeout_ms);
+    if (r < 0) return errno == EINTR ? 0 : -1;
+    if (r == 0) return 0;
+    if (p.revents & (POLLERR | POLLNVAL)) return -1;
+
+    ssize_t n = ::read(fd_, buf, len);
+    if (n < 0) return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    // POLLHUP ilman dataa: pty:n toinen pää suljettu
+    if (n == 0 && (p.revents & POLLHUP)) return -1;
+    return (long)n;
+}
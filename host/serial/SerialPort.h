@@ -0,0 +1,36 @@
+#ifndef SERIALPORT_H
+#define SERIALPORT_H
+
+#include <cstddef>
+#include <string>
+
+// Raaka tty/pty-yhteys firmwaren komento-UARTiin (native_sim antaa pty:n,
+// rauta /dev/ttyACMx tms.)
+class SerialPort {
+public:
+    SerialPort() = default;
+    ~SerialPort();
+
+    SerialPort(const SerialPort &) = delete;
+    SerialPort &operator=(const SerialPort &) = delete;
+
+    // Palauttaa false ja errno:n jos avaus/termios epäonnistuu
+    bool open(const std::string &path, int baud = 115200);
+    // Ottaa omistukseen valmiin kuvaajan (putki, socketpair)
+    bool attach(int fd);
+    void close();
+    bool is_open() const { return fd_ >= 0; }
+    int fd() const { return fd_; }
+
+    // Kirjoittaa kaiken tai palauttaa false
+    bool write_all(const char *data, size_t len);
+
+    // Odottaa enintään timeout_ms, palauttaa luettujen tavujen määrän,
+    // 0 = timeout, -1 = virhe
+    long read_some(char *buf, size_t len, int timeout_ms);
+
+private:
+    int fd_ = -1;
+};
+
+#endif
@@ -0,0 +1,376 @@
+#include "TrafficModel.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include "TimeParser.h"
+
+namespace sim {
+
+static int color_idx(char c) {
+    switch (c) {
+    case 'R': return 0;
+    case 'Y': return 1;
+    case 'G': return 2;
+    }
+    return -1;
+}
+
+TrafficModel::TrafficModel(ModelConfig cfg)
+    : cfg_(cfg), rx_(k_), seq_fifo_(k_), prio_fifo_(k_),
+      trig_{{k_, 0, 1}, {k_, 0, 1}, {k_, 0, 1}},
+      abort_sem_(k_, 0, 1), release_sem_(k_, 0, 1), timer_sem_(k_, 0, 1),
+      prog_sem_(k_, 0, 1) {
+    k_.spawn(dispatcher_task());
+    for (int i = 0; i < 3; ++i) k_.spawn(led_task(i));
+    k_.spawn(uart_task());
+    k_.spawn(timer_task());
+}
+
+void TrafficModel::uart(vk::Time at, std::string_view bytes) {
+    k_.call_at(at, [this, b = std::string(bytes)] {
+        for (char c : b) rx_.put((uint8_t)c);
+    });
+}
+
+void TrafficModel::button(vk::Time at, char color) {
+    // ISR -> k_work -> seq_fifo samalla hetkellä
+    k_.call_at(at, [this, color] { enqueue(color, false); });
+}
+
+void TrafficModel::plan(std::vector<PlanStep> steps, bool loop) {
+    if (!steps.empty()) k_.spawn(plan_task(std::move(steps), loop));
+}
+
+void TrafficModel::program(vk::Time at, std::vector<ProgStep> steps, uint32_t loops) {
+    k_.call_at(at, [this, steps = std::move(steps), loops] {
+        prog_ = steps;
+        prog_loops_ = loops;
+        prog_done_ = 0;
+        prog_pos_ = 0;
+        prog_sem_.give();
+    });
+}
+
+// prog_next: seuraava askel, viimeisen kierroksen jälkeen ohjelma loppuu
+bool TrafficModel::prog_next(Item &it) {
+    if (prog_.empty()) return false;
+    const ProgStep &st = prog_[prog_pos_];
+    it = {st.color, false, k_.now(), true, st.len};
+    if (++prog_pos_ == prog_.size()) {
+        prog_pos_ = 0;
+        if (prog_loops_ && ++prog_done_ == prog_loops_) prog_.clear();
+    }
+    return true;
+}
+
+void TrafficModel::enqueue(char color, bool prio) {
+    accepted_++;
+    if (prio) {
+        prio_fifo_.put({color, true, k_.now()});
+    } else {
+        seq_log_.push_back(color);
+        seq_fifo_.put({color, false, k_.now()});
+    }
+}
+
+static constexpr vk::Time DAY = vk::s(86400);
+
+vk::Time TrafficModel::wall() const {
+    return (clock_off_ + k_.now()) % DAY;
+}
+
+// a - b vuorokauden kehällä, (-12 h, 12 h]
+static vk::Time wrap_diff(vk::Time a, vk::Time b) {
+    vk::Time d = (a - b) % DAY;
+    if (d > DAY / 2) d -= DAY;
+    else if (d <= -DAY / 2) d += DAY;
+    return d;
+}
+
+// wallclock.c collect_locked: kursorin ja nykyhetken väliin osuneet järjestyksessä
+void TrafficModel::fire_due() {
+    if (clock_off_ < 0 || triggers_.empty()) return;
+    vk::Time now = wall(), d = wrap_diff(now, cursor_);
+    if (d <= 0) return;
+    size_t start = 0;
+    while (start < triggers_.size() && vk::s(triggers_[start].tod_s) <= cursor_) start++;
+    for (size_t k = 0; k < triggers_.size(); ++k) {
+        const Trigger &t = triggers_[(start + k) % triggers_.size()];
+        vk::Time off = (vk::s(t.tod_s) - cursor_ + DAY) % DAY;
+        if (off == 0 || off > d) break;
+        timer_fired_++;
+        enqueue(t.color, false);
+    }
+    cursor_ = now;
+}
+
+vk::Time TrafficModel::next_wait() const {
+    if (clock_off_ < 0 || triggers_.empty()) return vk::FOREVER;
+    vk::Time off = DAY;
+    for (const Trigger &t : triggers_) {
+        vk::Time o = (vk::s(t.tod_s) - cursor_ + DAY) % DAY;
+        off = std::min(off, o ? o : DAY);
+    }
+    // WC_REARM_MAX_MS: kursori pysyy alle puolen vuorokauden päässä
+    return std::clamp<vk::Time>(off - wrap_diff(wall(), cursor_), 0, vk::s(60));
+}
+
+void TrafficModel::timer_set(int secs) {
+    if (clock_off_ < 0) { bad_time_++; return; }
+    fire_due();
+    auto pos = std::upper_bound(triggers_.begin(), triggers_.end(), secs,
+                                [](int s, const Trigger &t) { return s < t.tod_s; });
+    bool dup = std::any_of(triggers_.begin(), pos, [&](const Trigger &t) {
+        return t.tod_s == secs && t.color == timer_color_;
+    });
+    if (!dup && triggers_.size() < 16) triggers_.insert(pos, {secs, timer_color_});   // WC_MAX_TRIG
+    timer_sem_.give();
+}
+
+// C: HHMMSS tai HHMMSSmmm; virtuaaliaika ei ryömi, joten vain asetus
+void TrafficModel::clock_set() {
+    int ms = 0;
+    if (time_buf_.size() == 9) {
+        for (size_t i = 6; i < 9; ++i) {
+            if (!std::isdigit((unsigned char)time_buf_[i])) { bad_time_++; return; }
+            ms = ms * 10 + (time_buf_[i] - '0');
+        }
+        time_buf_.resize(6);
+    }
+    int secs = time_buf_.size() == 6 ? time_parse(time_buf_.data()) : -1;
+    if (secs < 0) { bad_time_++; return; }
+    vk::Time target = vk::s(secs) + vk::ms(ms);
+    bool first = clock_off_ < 0;
+    vk::Time err = first ? 0 : wrap_diff(target, wall());
+    clock_off_ = ((target - k_.now()) % DAY + DAY) % DAY;
+    if (first || err > vk::ms(2000) || err < -vk::ms(2000)) cursor_ = target;   // WC_STEP_MS
+    timer_sem_.give();
+}
+
+// uart_handle_ascii:n komentojoukko
+void TrafficModel::handle_ascii(uint8_t b) {
+    if (time_mode_ == 'C') {
+        if (b == '\r' || b == '\n') { clock_set(); time_mode_ = 0; return; }
+        time_buf_.push_back((char)b);
+        if (time_buf_.size() == 9) { clock_set(); time_mode_ = 0; }
+        return;
+    }
+    if (time_mode_) {
+        if (b == '\r' || b == '\n') { time_mode_ = 0; return; }
+        if (time_buf_.empty() && b == '.') { triggers_.clear(); time_mode_ = 0; return; }
+        time_buf_.push_back((char)b);
+        if (time_buf_.size() == 6) {
+            int secs = time_parse(time_buf_.data());
+            if (secs >= 0) timer_set(secs);
+            else bad_time_++;
+            time_mode_ = 0;
+        }
+        return;
+    }
+    char c = (char)std::toupper(b);
+    if (c == 'A' || c == 'C') { time_mode_ = c; time_buf_.clear(); return; }
+    if (c == '!') { prio_next_ = true; return; }
+    if (c == 'X') { prio_next_ = true; c = 'R'; }
+    if (color_idx(c) >= 0) {
+        if (prio_next_) {
+            prio_next_ = false;
+            enqueue(c, true);
+        } else {
+            timer_color_ = c;
+            enqueue(c, false);
+        }
+        return;
+    }
+    prio_next_ = false;
+}
+
+vk::Task TrafficModel::uart_task() {
+    while (true) {
+        auto b = co_await rx_.get();
+        handle_ascii(*b);
+    }
+}
+
+vk::Task TrafficModel::timer_task() {
+    while (true) {
+        fire_due();
+        co_await timer_sem_.take(next_wait());
+    }
+}
+
+vk::Task TrafficModel::plan_task(std::vector<PlanStep> steps, bool loop) {
+    do {
+        for (const PlanStep &st : steps) {
+            co_await k_.sleep(vk::s(st.delay_s));
+            enqueue(st.color, false);
+        }
+    } while (loop);
+}
+
+vk::Task TrafficModel::dispatcher_task() {
+    while (true) {
+        auto it = prio_fifo_.try_get();
+        if (!it) {
+            prog_sem_.reset();
+            // ohjelman askeleen jälkeen odottava seq-komento ensin
+            Item st;
+            if (!(prog_last_ && !seq_fifo_.empty()) && prog_next(st)) {
+                it = st;
+                prog_last_ = true;
+            } else if ((it = seq_fifo_.try_get())) {
+                prog_last_ = false;
+            }
+        }
+        if (!it) {
+            co_await vk::poll(k_, &prio_fifo_, &seq_fifo_, &prog_sem_);
+            continue;
+        }
+        int idx = color_idx(it->color);
+        if (idx < 0) continue;
+
+        Phase ph;
+        ph.color  = it->color;
+        ph.prio   = it->prio;
+        ph.program = it->program;
+        ph.len    = it->program ? it->len : cfg_.light;
+        ph.t_in   = it->t_in;
+        ph.t_disp = k_.now();
+        phases_.push_back(ph);
+        trig_[idx].give();
+
+        // dispatcher_wait_release
+        if (!it->prio) {
+            int r = co_await vk::poll(k_, &release_sem_, &prio_fifo_);
+            if (r != 0) abort_sem_.give();
+        }
+        co_await release_sem_.take();
+        abort_sem_.reset();
+    }
+}
+
+vk::Task TrafficModel::led_task(int idx) {
+    while (true) {
+        co_await trig_[idx].take();
+        // dispatcher ei lisää vaihetta ennen release_semiä: back() pysyy
+        Phase &ph = phases_.back();
+        ph.t_on = k_.now();
+        ph.aborted = co_await abort_sem_.take(ph.len);
+        ph.t_off   = k_.now();
+        release_sem_.give();
+    }
+}
+
+std::vector<std::string> TrafficModel::check() const {
+    std::vector<std::string> err;
+    auto fail = [&](size_t i, const char *what) {
+        char buf[160];
+        std::snprintf(buf, sizeof buf, "phase %zu %c%s t_in=%lld t_on=%lld t_off=%lld: %s",
+                      i, phases_[i].color, phases_[i].prio ? "!" : "",
+                      (long long)phases_[i].t_in, (long long)phases_[i].t_on,
+                      (long long)phases_[i].t_off, what);
+        err.emplace_back(buf);
+    };
+
+    std::vector<char> seq_order;
+    const Phase *prev_norm = nullptr;   // edellinen tavallinen vaihe
+    for (size_t i = 0; i < phases_.size(); ++i) {
+        const Phase &p = phases_[i];
+        if (p.t_on < 0 || p.t_off < 0) {
+            if (i + 1 < phases_.size()) fail(i, "phase never finished");   // viimeinen voi olla kesken
+            continue;
+        }
+        if (p.t_disp < p.t_in || p.t_on < p.t_disp) fail(i, "time went backwards");
+        if (i > 0 && p.t_on < phases_[i - 1].t_off) fail(i, "overlaps previous phase");
+        vk::Time len = p.t_off - p.t_on;
+        if (!p.aborted && len != p.len) fail(i, "phase length != LIGHT_MS / step");
+        if (p.aborted && (p.prio || len >= p.len)) fail(i, "invalid abort");
+        // työtä säästävä: jonossa odottanut lähtee heti edellisen vapautuessa
+        if (p.t_disp > p.t_in && (i == 0 || phases_[i - 1].t_off != p.t_disp))
+            fail(i, "dispatcher idle while command queued");
+        // prioriteetti ei odota tavallisen vaiheen loppuun
+        if (p.prio && i > 0 && !phases_[i - 1].prio && phases_[i - 1].t_off > p.t_in && !phases_[i - 1].aborted)
+            fail(i, "priority command waited behind a normal phase");
+        // vuorottelu: kaksi askelta peräkkäin vain, jos seq_fifo oli tyhjä
+        if (p.program && prev_norm && prev_norm->program &&
+            std::any_of(phases_.begin() + i, phases_.end(), [&](const Phase &q) {
+                return !q.prio && !q.program && q.t_in < p.t_disp;
+            }))
+            fail(i, "program step while seq_fifo waiting");
+        if (!p.prio) prev_norm = &p;
+        if (!p.prio && !p.program) seq_order.push_back(p.color);
+    }
+    size_t prog_phases = std::count_if(phases_.begin(), phases_.end(),
+                                       [](const Phase &p) { return p.program; });
+    if (phases_.size() - prog_phases + queued() != accepted_) err.emplace_back("accepted commands lost");
+    if (seq_order.size() <= seq_log_.size() &&
+        !std::equal(seq_order.begin(), seq_order.end(), seq_log_.begin()))
+        err.emplace_back("seq_fifo order not preserved");
+    return err;
+}
+
+bool parse_plan(std::string_view text, std::vector<PlanStep> &steps, bool &loop) {
+    steps.clear();
+    loop = false;
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = (char)std::toupper((unsigned char)text[i]);
+        if (c == ' ' || c == ',') { ++i; continue; }
+        if (c == '*') { loop = true; ++i; continue; }
+        if (color_idx(c) < 0 || loop) return false;
+        uint32_t d = 0;
+        size_t j = i + 1;
+        for (; j < text.size() && std::isdigit((unsigned char)text[j]); ++j) {
+            d = d * 10 + (uint32_t)(text[j] - '0');
+            if (d > 86399) return false;            // SCHED_MAX_DELAY
+        }
+        if (j == i + 1) return false;
+        steps.push_back({d, c});
+        i = j;
+    }
+    return !steps.empty();
+}
+
+Scenario random_scenario(std::mt19937_64 &rng, int ncmd, vk::Time span) {
+    static const char cols[] = "RYG";
+    std::uniform_int_distribution<vk::Time> at(0, span);
+    std::uniform_int_distribution<int> kind(0, 99), col(0, 2), secs(0, 20);
+    Scenario sc;
+    sc.inputs.push_back({0, false, "C000000\n"});
+    for (int i = 0; i < ncmd; ++i) {
+        Scenario::Input in{at(rng), false, {}};
+        int k = kind(rng);
+        if (k < 50)      in.bytes = std::string(1, cols[col(rng)]);
+        else if (k < 65) in.bytes = std::string("!") + cols[col(rng)];
+        else if (k < 70) in.bytes = "X";
+        else if (k < 85) { in.button = true; in.bytes = std::string(1, cols[col(rng)]); }
+        else if (k < 95) { char b[8]; std::snprintf(b, sizeof b, "A0000%02d", secs(rng)); in.bytes = b; }   // kello 00:00:00 alussa
+        else             in.bytes = "A996000";                  // virheellinen aika
+        sc.inputs.push_back(std::move(in));
+    }
+    return sc;
+}
+
+RunSummary run_scenarios(uint64_t seed, uint64_t count, int ncmd, vk::Time span, ModelConfig cfg) {
+    RunSummary sum;
+    for (uint64_t n = 0; n < count; ++n) {
+        std::mt19937_64 rng(seed + n);
+        Scenario sc = random_scenario(rng, ncmd, span);
+        TrafficModel m(cfg);
+        for (const auto &in : sc.inputs) {
+            if (in.button) m.button(in.at, in.bytes[0]);
+            else           m.uart(in.at, in.bytes);
+        }
+        // kaikki syötteet jonon läpi; A-laukaisut 0..20 s, seuraava kierros vasta huomenna
+        m.run_until(span + vk::s(30) + cfg.light * (ncmd + 2));
+        sum.scenarios++;
+        sum.phases += m.phases().size();
+        sum.events += m.kernel().events();
+        sum.virt   += m.now();
+        for (const auto &e : m.check()) {
+            if (sum.failures.size() < 10) sum.failures.push_back("seed " + std::to_string(seed + n) + ": " + e);
+        }
+    }
+    return sum;
+}
+
+} // namespace sim
@@ -0,0 +1,164 @@
+#ifndef TRAFFICMODEL_H
+#define TRAFFICMODEL_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "VirtualKernel.h"
+
+// LIIKENNEVALOT-firmwaren säikeet virtuaaliajassa (VirtualKernel.h):
+//   uart_task       ASCII R/Y/G, !väri, X, A+HHMMSS, C+HHMMSS[mmm]
+//   dispatcher_task prio_fifo ensin, sitten ohjelma ja seq_fifo vuorotellen
+//                   (program.h); prioriteetti katkaisee tavallisen vaiheen
+//   LED-taskit      vaihe LIGHT_MS (ohjelmassa askeleen pituus) tai abort_sem
+//   ohjelma         program.c: väri ja kesto, kierrokset (0 = ikuisesti)
+//   seinäkello      C asettaa, A lisää päivittäin toistuvan laukaisun
+//                   kellonaikaan (wallclock.c); kello ei ryömi virtuaaliajassa
+//   suunnitelma     schedule.c: viive, väri, (silmukka)
+// Sama ohjausvuo kuin main.c:ssä; ei mallinna kehyksiä eikä sisääntulon
+// rajoitinta.
+
+namespace sim {
+
+struct ModelConfig {
+    vk::Time light = vk::ms(1000);      // LIGHT_MS
+};
+
+struct Phase {
+    char     color   = 0;
+    bool     prio    = false;
+    bool     aborted = false;
+    bool     program = false;           // ohjelman askel, ei seq_fifosta
+    vk::Time len     = -1;              // odotettu kesto
+    vk::Time t_in    = -1;              // syöte jonoon
+    vk::Time t_disp  = -1;              // dispatcher otti
+    vk::Time t_on    = -1;
+    vk::Time t_off   = -1;
+};
+
+struct PlanStep {
+    uint32_t delay_s;
+    char     color;
+};
+
+struct ProgStep {
+    char     color;
+    vk::Time len;
+};
+
+class TrafficModel {
+public:
+    explicit TrafficModel(ModelConfig cfg = {});
+
+    vk::Kernel &kernel() { return k_; }
+    vk::Time now() const { return k_.now(); }
+
+    // Syötteet ajanhetkellä at (tavut peräkkäin samalla hetkellä)
+    void uart(vk::Time at, std::string_view bytes);
+    void button(vk::Time at, char color);
+    void plan(std::vector<PlanStep> steps, bool loop);
+    // prog_run ajanhetkellä at: korvaa ajossa olevan, loops 0 = ikuisesti
+    void program(vk::Time at, std::vector<ProgStep> steps, uint32_t loops);
+
+    void run_until(vk::Time t) { k_.run(t); }
+    void run_idle()            { k_.run(); }
+
+    const std::vector<Phase> &phases() const { return phases_; }
+    uint64_t accepted() const  { return accepted_; }
+    uint64_t bad_time() const  { return bad_time_; }
+    uint64_t timer_fired() const { return timer_fired_; }
+    size_t queued() const      { return seq_fifo_.size() + prio_fifo_.size(); }
+
+    // Ajon invariantit; tyhjä = kaikki kunnossa. Viimeinen vaihe saa olla kesken.
+    std::vector<std::string> check() const;
+
+private:
+    struct Item {
+        char     color;
+        bool     prio;
+        vk::Time t_in;
+        bool     program = false;
+        vk::Time len     = -1;
+    };
+
+    void enqueue(char color, bool prio);
+    bool prog_next(Item &it);
+    void handle_ascii(uint8_t b);
+    void timer_set(int secs);
+    void clock_set();
+    vk::Time wall() const;              // kellonaika µs vuorokauden alusta
+    void fire_due();
+    vk::Time next_wait() const;
+
+    vk::Task uart_task();
+    vk::Task dispatcher_task();
+    vk::Task led_task(int idx);
+    vk::Task timer_task();
+    vk::Task plan_task(std::vector<PlanStep> steps, bool loop);
+
+    ModelConfig cfg_;
+    vk::Kernel  k_;
+    vk::Fifo<uint8_t> rx_;
+    vk::Fifo<Item>    seq_fifo_, prio_fifo_;
+    vk::Sem trig_[3];
+    vk::Sem abort_sem_, release_sem_, timer_sem_, prog_sem_;
+
+    // program.c ja dispatcherin vuorottelu
+    std::vector<ProgStep> prog_;
+    uint32_t prog_loops_ = 0, prog_done_ = 0;
+    size_t   prog_pos_ = 0;
+    bool     prog_last_ = false;        // edellinen tavallinen vaihe oli ohjelman askel
+
+    // uart_task
+    bool  prio_next_ = false;
+    char  time_mode_ = 0;               // 'A' / 'C'
+    std::string time_buf_;
+    char  timer_color_ = 'R';
+
+    // seinäkello: kellonaika = clock_off_ + now (mod vrk), -1 = ei asetettu
+    struct Trigger {
+        int  tod_s;
+        char color;
+    };
+    vk::Time clock_off_ = -1;
+    vk::Time cursor_ = 0;               // tähän kellonaikaan asti laukaistu
+    std::vector<Trigger> triggers_;     // tod_s-järjestyksessä
+
+    std::vector<Phase> phases_;
+    std::vector<char>  seq_log_;        // hyväksytyt seq-komennot järjestyksessä
+    uint64_t accepted_ = 0, bad_time_ = 0, timer_fired_ = 0;
+};
+
+// Suunnitelma samassa muodossa kuin L-komento (schedule.h): "R10 G30 Y3 *"
+bool parse_plan(std::string_view text, std::vector<PlanStep> &steps, bool &loop);
+
+// Satunnainen komentoskenaario: UART-komennot, napit ja ajastimet
+struct Scenario {
+    struct Input {
+        vk::Time    at;
+        bool        button;
+        std::string bytes;      // button: yksi väri
+    };
+    std::vector<Input> inputs;
+};
+
+Scenario random_scenario(std::mt19937_64 &rng, int ncmd, vk::Time span);
+
+struct RunSummary {
+    uint64_t scenarios = 0;
+    uint64_t phases    = 0;
+    uint64_t events    = 0;
+    vk::Time virt      = 0;             // simuloitu aika yhteensä
+    std::vector<std::string> failures;  // "seed N: viesti", enintään 10
+};
+
+// Ajaa count skenaariota siemenestä seed alkaen, jokaisen tyhjiin jonoihin asti
+// (A-laukaisut toistuvat päivittäin, joten ajo rajataan alle vuorokauteen)
+RunSummary run_scenarios(uint64_t seed, uint64_t count, int ncmd, vk::Time span,
+                         ModelConfig cfg = {});
+
+} // namespace sim
+
+#endif
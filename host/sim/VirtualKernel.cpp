@@ -0,0 +1,89 @@
+#include "VirtualKernel.h"
+
+namespace vk {
+
+void WaitQueue::remove(Waiter *w) {
+    for (auto it = q_.begin(); it != q_.end(); ++it) {
+        if (it->first == w) { q_.erase(it); return; }
+    }
+}
+
+Kernel::~Kernel() {
+    for (auto h : tasks_) h.destroy();
+}
+
+void Kernel::push(Ev e) {
+    e.seq = seq_++;
+    evq_.push(std::move(e));
+}
+
+void Kernel::spawn(Task t) {
+    auto h = std::exchange(t.h_, {});
+    tasks_.push_back(h);
+    resume_at(now_, h);
+}
+
+void Kernel::call_at(Time at, std::function<void()> fn) {
+    push(Ev{at < now_ ? now_ : at, 0, {}, 0, std::move(fn)});
+}
+
+void Kernel::resume_at(Time at, std::coroutine_handle<> h) {
+    push(Ev{at, 0, h, 0, {}});
+}
+
+void Kernel::block(Waiter &w, Time timeout) {
+    w.pending = true;
+    w.result  = -1;
+    w.gen     = 0;
+    if (timeout != FOREVER) {
+        w.gen = ++gen_;
+        armed_.emplace(w.gen, &w);
+        push(Ev{now_ + timeout, 0, {}, w.gen, {}});
+    }
+}
+
+void Kernel::wake(Waiter *w, int result) {
+    if (!w->pending) return;
+    w->pending = false;
+    w->result  = result;
+    for (WaitQueue *q : w->queues) q->remove(w);
+    if (w->gen) armed_.erase(w->gen);
+    resume_at(now_, w->h);
+}
+
+uint64_t Kernel::run(Time until) {
+    uint64_t n = 0;
+    while (!evq_.empty() && evq_.top().at <= until) {
+        Ev e = std::move(const_cast<Ev &>(evq_.top()));   // pop heti perään
+        evq_.pop();
+        now_ = e.at;
+        ++n;
+        ++nevents_;
+        if (e.gen) {
+            auto it = armed_.find(e.gen);
+            if (it != armed_.end()) wake(it->second, -1);
+        } else if (e.fn) {
+            e.fn();
+        } else {
+            e.h.resume();
+        }
+    }
+    if (until != INT64_MAX && now_ < until) now_ = until;
+    return n;
+}
+
+void Pollable::notify_pollers(Kernel &k) {
+    for (auto [w, idx] : pollers_.take_all()) k.wake(w, idx);
+}
+
+void Sem::give() {
+    auto [w, idx] = takers_.front();
+    if (w) {                                    // odottaja saa suoraan
+        k_.wake(w, idx);
+        return;
+    }
+    if (count_ < limit_) count_++;
+    notify_pollers(k_);
+}
+
+} // namespace vk
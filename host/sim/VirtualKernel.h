@@ -0,0 +1,267 @@
+#ifndef VIRTUALKERNEL_H
+#define VIRTUALKERNEL_H
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Yksisäikeinen diskreettien tapahtumien ajuri virtuaaliajassa. Zephyrin
+// säikeet mallinnetaan C++20-korutiineina: k_msleep, k_sem_take, k_fifo_get
+// ja k_poll ovat co_await-kohtia, ja aika hyppää suoraan seuraavaan
+// tapahtumaan. LIGHT_MS tai vuorokauden aikataulu kuluu mikrosekunneissa.
+//
+// Saman ajanhetken tapahtumat ajetaan lisäysjärjestyksessä (deterministinen).
+
+namespace vk {
+
+using Time = int64_t;                       // mikrosekunteja
+constexpr Time FOREVER = -1;
+constexpr Time ms(int64_t v) { return v * 1000; }
+constexpr Time s(int64_t v)  { return v * 1000000; }
+
+class Kernel;
+
+// Säie: käynnistyy vasta Kernel::spawn:ssa, kehyksen omistaa Kernel
+class Task {
+public:
+    struct promise_type {
+        Task get_return_object() { return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { throw; }   // Kernel::run:n kutsujalle
+    };
+
+    Task(Task &&o) noexcept : h_(std::exchange(o.h_, {})) {}
+    Task(const Task &) = delete;
+    ~Task() { if (h_) h_.destroy(); }
+
+private:
+    friend class Kernel;
+    explicit Task(std::coroutine_handle<promise_type> h) : h_(h) {}
+    std::coroutine_handle<promise_type> h_;
+};
+
+// Odottava säie, voi olla usean jonon odottajana (k_poll)
+struct Waiter {
+    std::coroutine_handle<> h;
+    int   result  = -1;         // herättäneen kohteen indeksi, -1 = aikakatkaisu
+    bool  pending = false;
+    uint64_t gen  = 0;          // aikakatkaisun tunniste
+    void *slot    = nullptr;    // Fifo: std::optional<T>, johon put kirjoittaa
+    std::vector<class WaitQueue *> queues;
+};
+
+class WaitQueue {
+public:
+    void add(Waiter *w, int idx) { q_.push_back({w, idx}); }
+    void remove(Waiter *w);
+    bool empty() const { return q_.empty(); }
+    // Ensimmäinen odottaja; nullptr jos ei ketään
+    std::pair<Waiter *, int> front() const { return q_.empty() ? std::pair<Waiter *, int>{nullptr, -1} : q_.front(); }
+    std::deque<std::pair<Waiter *, int>> take_all() { return std::exchange(q_, {}); }
+
+private:
+    std::deque<std::pair<Waiter *, int>> q_;
+};
+
+class Kernel {
+public:
+    Kernel() = default;
+    Kernel(const Kernel &) = delete;
+    ~Kernel();
+
+    Time now() const { return now_; }
+    void spawn(Task t);
+    void call_at(Time at, std::function<void()> fn);
+    void call_after(Time dt, std::function<void()> fn) { call_at(now_ + dt, std::move(fn)); }
+
+    // Ajaa kunnes jono tyhjä tai seuraava tapahtuma on myöhemmin kuin until.
+    // Palauttaa ajettujen tapahtumien määrän.
+    uint64_t run(Time until = INT64_MAX);
+    bool idle() const { return evq_.empty(); }
+    uint64_t events() const { return nevents_; }
+
+    // k_msleep / k_usleep
+    auto sleep(Time dt) {
+        struct Aw {
+            Kernel *k; Time dt;
+            bool await_ready() const noexcept { return dt <= 0; }
+            void await_suspend(std::coroutine_handle<> h) { k->resume_at(k->now_ + dt, h); }
+            void await_resume() const noexcept {}
+        };
+        return Aw{this, dt};
+    }
+
+    // Sisäiset (synkronointiprimitiivit)
+    void resume_at(Time at, std::coroutine_handle<> h);
+    void block(Waiter &w, Time timeout);
+    void wake(Waiter *w, int result);
+
+private:
+    struct Ev {
+        Time at;
+        uint64_t seq;
+        std::coroutine_handle<> h;
+        uint64_t gen;                   // != 0: aikakatkaisu (armed_)
+        std::function<void()> fn;
+        bool operator>(const Ev &o) const { return at != o.at ? at > o.at : seq > o.seq; }
+    };
+    void push(Ev e);
+
+    Time now_ = 0;
+    uint64_t seq_ = 0, gen_ = 0, nevents_ = 0;
+    std::priority_queue<Ev, std::vector<Ev>, std::greater<Ev>> evq_;
+    std::unordered_map<uint64_t, Waiter *> armed_;   // viritetyt aikakatkaisut
+    std::vector<std::coroutine_handle<Task::promise_type>> tasks_;
+};
+
+// k_poll-kohde (NOTIFY_ONLY): valmius tarkistetaan, herätys ei kuluta
+class Pollable {
+public:
+    virtual ~Pollable() = default;
+    virtual bool ready() const = 0;
+    WaitQueue &pollers() { return pollers_; }
+
+protected:
+    void notify_pollers(Kernel &k);
+
+private:
+    WaitQueue pollers_;
+};
+
+class Sem : public Pollable {
+public:
+    Sem(Kernel &k, unsigned count, unsigned limit) : k_(k), count_(count), limit_(limit) {}
+
+    bool ready() const override { return count_ > 0; }
+    unsigned count() const { return count_; }
+    void reset() { count_ = 0; }
+    void give();
+
+    // co_await sem.take(timeout) -> true jos saatiin
+    auto take(Time timeout = FOREVER) {
+        struct Aw {
+            Sem *s; Time to; Waiter w;
+            bool await_ready() {
+                if (s->count_ > 0) { s->count_--; w.result = 0; return true; }
+                return to == 0;
+            }
+            void await_suspend(std::coroutine_handle<> h) {
+                w.h = h;
+                s->takers_.add(&w, 0);
+                w.queues = {&s->takers_};
+                s->k_.block(w, to);
+            }
+            bool await_resume() const noexcept { return w.result >= 0; }
+        };
+        return Aw{this, timeout, {}};
+    }
+
+private:
+    Kernel  &k_;
+    unsigned count_, limit_;
+    WaitQueue takers_;
+};
+
+template <typename T>
+class Fifo : public Pollable {
+public:
+    explicit Fifo(Kernel &k) : k_(k) {}
+
+    bool ready() const override { return !items_.empty(); }
+    size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
+
+    void put(T v) {
+        auto [w, idx] = getters_.front();
+        if (w) {                                // suoraan odottajalle
+            getters_.remove(w);
+            *static_cast<std::optional<T> *>(w->slot) = std::move(v);
+            k_.wake(w, idx);
+            return;
+        }
+        items_.push_back(std::move(v));
+        notify_pollers(k_);
+    }
+
+    std::optional<T> try_get() {
+        if (items_.empty()) return std::nullopt;
+        T v = std::move(items_.front());
+        items_.pop_front();
+        return v;
+    }
+
+    // co_await fifo.get(timeout) -> std::optional<T>
+    auto get(Time timeout = FOREVER) {
+        struct Aw {
+            Fifo *f; Time to; Waiter w; std::optional<T> v;
+            bool await_ready() {
+                v = f->try_get();
+                return v.has_value() || to == 0;
+            }
+            void await_suspend(std::coroutine_handle<> h) {
+                w.h = h;
+                w.slot = &v;
+                f->getters_.add(&w, 0);
+                w.queues = {&f->getters_};
+                f->k_.block(w, to);
+            }
+            std::optional<T> await_resume() { return std::move(v); }
+        };
+        return Aw{this, timeout, {}, {}};
+    }
+
+private:
+    Kernel &k_;
+    std::deque<T> items_;
+    WaitQueue getters_;
+};
+
+// k_poll: co_await poll(k, &a, &b) -> valmiin kohteen indeksi, poll_for: -1 = aikakatkaisu
+class Poll {
+public:
+    Poll(Kernel &k, std::vector<Pollable *> objs, Time timeout)
+        : k_(k), objs_(std::move(objs)), to_(timeout) {}
+
+    bool await_ready() {
+        for (size_t i = 0; i < objs_.size(); ++i)
+            if (objs_[i]->ready()) { w_.result = (int)i; return true; }
+        return to_ == 0;
+    }
+    void await_suspend(std::coroutine_handle<> h) {
+        w_.h = h;
+        for (size_t i = 0; i < objs_.size(); ++i) {
+            objs_[i]->pollers().add(&w_, (int)i);
+            w_.queues.push_back(&objs_[i]->pollers());
+        }
+        k_.block(w_, to_);
+    }
+    int await_resume() const noexcept { return w_.result; }
+
+private:
+    Kernel &k_;
+    std::vector<Pollable *> objs_;
+    Time to_;
+    Waiter w_;
+};
+
+// (variadinen: GCC 12 ei salli aaltosulkulistaa co_await-lausekkeessa)
+template <typename... Objs>
+Poll poll_for(Kernel &k, Time timeout, Objs *...objs) {
+    return Poll(k, std::vector<Pollable *>{objs...}, timeout);
+}
+template <typename... Objs>
+Poll poll(Kernel &k, Objs *...objs) {
+    return poll_for(k, FOREVER, objs...);
+}
+
+} // namespace vk
+
+#endif
@@ -0,0 +1,67 @@
+// simrun: ohjaimen malli virtuaaliajassa (TrafficModel.h).
+//
+//   simrun [--scenarios N] [--cmds K] [--span S] [--seed X]
+//       N satunnaista skenaariota (K komentoa S sekunnin sisään), invariantit
+//   simrun --days D [--plan "R10 G30 Y3 *"]
+//       suunnitelma silmukassa D vuorokautta
+//
+// Paluuarvo 1 jos jokin invariantti rikkoutui (CI).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "TrafficModel.h"
+
+static void usage(const char *prog) {
+    std::fprintf(stderr, "usage: %s [--scenarios N] [--cmds K] [--span S] [--seed X] "
+                         "[--days D] [--plan SPEC] [--light MS]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    uint64_t scenarios = 10000, seed = 1;
+    int cmds = 20;
+    long span_s = 60, days = 0;
+    std::string plan = "R30 Y3 G30 Y3 *";
+    sim::ModelConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        bool more = i + 1 < argc;
+        if      (!std::strcmp(a, "--scenarios") && more) scenarios = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(a, "--cmds") && more)      cmds = std::atoi(argv[++i]);
+        else if (!std::strcmp(a, "--span") && more)      span_s = std::atol(argv[++i]);
+        else if (!std::strcmp(a, "--seed") && more)      seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(a, "--days") && more)      days = std::atol(argv[++i]);
+        else if (!std::strcmp(a, "--plan") && more)      plan = argv[++i];
+        else if (!std::strcmp(a, "--light") && more)     cfg.light = vk::ms(std::atol(argv[++i]));
+        else { usage(argv[0]); return 2; }
+    }
+
+    auto w0 = std::chrono::steady_clock::now();
+    auto wall_ms = [&] {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - w0).count();
+    };
+
+    if (days > 0) {
+        std::vector<sim::PlanStep> steps;
+        bool loop;
+        if (!sim::parse_plan(plan, steps, loop)) { std::fprintf(stderr, "bad plan '%s'\n", plan.c_str()); return 2; }
+        sim::TrafficModel m(cfg);
+        m.plan(std::move(steps), loop);
+        m.run_until(vk::s(86400) * days);
+        auto err = m.check();
+        std::printf("%ld days: %zu phases, %llu events, %.1f ms wall\n", days, m.phases().size(),
+                    (unsigned long long)m.kernel().events(), wall_ms());
+        for (const auto &e : err) std::printf("FAIL %s\n", e.c_str());
+        return err.empty() ? 0 : 1;
+    }
+
+    sim::RunSummary s = sim::run_scenarios(seed, scenarios, cmds, vk::s(span_s), cfg);
+    double ms = wall_ms();
+    std::printf("%llu scenarios, %llu phases, %llu events, %.1f h virtual, %.1f ms wall (%.0f scenarios/s)\n",
+                (unsigned long long)s.scenarios, (unsigned long long)s.phases,
+                (unsigned long long)s.events, (double)s.virt / 3.6e9, ms,
+                ms > 0 ? (double)s.scenarios * 1000.0 / ms : 0.0);
+    for (const auto &f : s.failures) std::printf("FAIL %s\n", f.c_str());
+    return s.failures.empty() ? 0 : 1;
+}
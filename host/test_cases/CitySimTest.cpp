@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "CitySim.h"
+#include "ShardedCity.h"
+
+using city::CitySim;
+using city::KernelKind;
+
+TEST(CitySimTest, QueuedCommandsRunLightMsEach) {
+    CitySim c(3, 1000, KernelKind::Scalar);
+    EXPECT_EQ(c.state().padded, 8u);
+    ASSERT_TRUE(c.push(1, 'R'));
+    ASSERT_TRUE(c.push(1, 'g'));
+    EXPECT_FALSE(c.push(1, 'Q'));
+
+    c.step(100);                                // R päälle
+    EXPECT_EQ(c.state().phase[1], city::RED);
+    EXPECT_EQ(c.state().phase[0], city::OFF);
+    for (int t = 0; t < 10; ++t) c.step(100);   // 1000 ms -> G
+    EXPECT_EQ(c.state().phase[1], city::GREEN);
+    EXPECT_EQ(c.state().served[1], 1);
+    for (int t = 0; t < 10; ++t) c.step(100);
+    EXPECT_EQ(c.state().phase[1], city::OFF);
+    EXPECT_EQ(c.totals().served, 2u);
+    EXPECT_EQ(c.state().q_hwm[1], 2);
+}
+
+TEST(CitySimTest, PlanEmitsAfterDelayAndStopsWithoutLoop) {
+    CitySim c(1, 1000, KernelKind::Scalar);
+    int p = c.add_plan("R2 G1");
+    ASSERT_GE(p, 0);
+    EXPECT_EQ(c.add_plan("R2 X1"), -1);
+    c.assign(0, p, 500);                        // R 2.5 s kohdalla
+    for (int t = 0; t < 24; ++t) c.step(100);
+    EXPECT_EQ(c.state().phase[0], city::OFF);
+    c.step(100);
+    EXPECT_EQ(c.state().phase[0], city::RED);
+    for (int t = 0; t < 100; ++t) c.step(100);
+    EXPECT_EQ(c.state().served[0], 2);
+    EXPECT_EQ(c.state().plan_len[0], 0);        // ei silmukkaa: päättyi
+}
+
+TEST(CitySimTest, QueueOverflowIsCounted) {
+    CitySim c(1, 1000, KernelKind::Scalar);
+    for (int i = 0; i < city::QCAP; ++i) ASSERT_TRUE(c.push(0, "RYG"[i % 3]));
+    EXPECT_FALSE(c.push(0, 'R'));
+    EXPECT_EQ(c.state().overflow[0], 1);
+    // jono purkautuu järjestyksessä
+    std::string seen;
+    for (int t = 0; t < city::QCAP; ++t) {
+        c.step(1000);
+        seen.push_back(city::color_char(c.state().phase[0]));
+    }
+    EXPECT_EQ(seen, "RYGRYGRYGRYGRYGR");
+}
+
+// Satunnainen kaupunki: AVX2 ja skalaari tuottavat bitilleen saman tilan
+TEST(CitySimTest, Avx2MatchesScalar) {
+    if (!city::avx2_available()) GTEST_SKIP() << "no AVX2";
+    const size_t n = 1003;
+    CitySim a(n, 700, KernelKind::Scalar), b(n, 700, KernelKind::Avx2);
+    const char *plans[] = { "R1 Y1 G2 *", "G3 R1", "R0 G0 *", "Y2 G1 R1 Y1 *" };   // R0 G0: 200 ms, jono täyttyy
+    for (auto *sim : { &a, &b })
+        for (auto *p : plans) ASSERT_GE(sim->add_plan(p, 200), 0);
+
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < n; ++i) {
+        int p = (int)(rng() % 5);
+        int32_t off = (int32_t)(rng() % 3000);
+        if (p < 4) { a.assign(i, p, off); b.assign(i, p, off); }
+    }
+    for (int t = 0; t < 3000; ++t) {
+        if (t % 7 == 0) {
+            size_t i = rng() % n;
+            char col = "RYG"[rng() % 3];
+            a.push(i, col);
+            b.push(i, col);
+        }
+        int32_t dt = 50 + (int32_t)(rng() % 150);
+        a.step(dt);
+        b.step(dt);
+    }
+    const auto &sa = a.state(), &sb = b.state();
+    EXPECT_EQ(sa.phase, sb.phase);
+    EXPECT_EQ(sa.remaining, sb.remaining);
+    EXPECT_EQ(sa.q_bits, sb.q_bits);
+    EXPECT_EQ(sa.q_len, sb.q_len);
+    EXPECT_EQ(sa.q_hwm, sb.q_hwm);
+    EXPECT_EQ(sa.plan_len, sb.plan_len);
+    EXPECT_EQ(sa.plan_step, sb.plan_step);
+    EXPECT_EQ(sa.plan_left, sb.plan_left);
+    EXPECT_EQ(sa.served, sb.served);
+    EXPECT_EQ(sa.overflow, sb.overflow);
+    EXPECT_GT(a.totals().served, 1000u);
+    EXPECT_GT(a.totals().overflow, 0u);
+}
+
+static void random_city(CitySim &c, size_t n, uint32_t seed) {
+    const char *plans[] = { "R1 Y1 G2 *", "G3 R1", "R0 G0 *", "Y2 G1 R1 Y1 *" };
+    for (auto *p : plans) c.add_plan(p, 200);
+    std::mt19937 rng(seed);
+    for (size_t i = 0; i < n; ++i) {
+        int p = (int)(rng() % 5);
+        if (p < 4) c.assign(i, p, (int32_t)(rng() % 3000));
+    }
+}
+
+static void expect_same_state(const CitySim &a, const CitySim &b) {
+    const auto &sa = a.state(), &sb = b.state();
+    EXPECT_EQ(sa.phase, sb.phase);
+    EXPECT_EQ(sa.remaining, sb.remaining);
+    EXPECT_EQ(sa.q_bits, sb.q_bits);
+    EXPECT_EQ(sa.q_len, sb.q_len);
+    EXPECT_EQ(sa.q_hwm, sb.q_hwm);
+    EXPECT_EQ(sa.plan_step, sb.plan_step);
+    EXPECT_EQ(sa.plan_left, sb.plan_left);
+    EXPECT_EQ(sa.served, sb.served);
+    EXPECT_EQ(sa.overflow, sb.overflow);
+}
+
+// Ilman linkkejä sirpalointi ei muuta mitään: sama tila kuin CitySim::step
+TEST(ShardedCityTest, MatchesPlainStepWithoutLinks) {
+    const size_t n = 5000;
+    CitySim ref(n, 700), one(n, 700), four(n, 700);
+    for (auto *c : { &ref, &one, &four }) random_city(*c, n, 3);
+    city::ShardedCity s1(one, 256, 1), s4(four, 256, 4);
+    EXPECT_EQ(s4.shards(), (n + 255) / 256);
+    for (int t = 0; t < 400; ++t) ref.step(100);
+    s1.run(400, 100);
+    s4.run(400, 100);
+    expect_same_state(ref, one);
+    expect_same_state(ref, four);
+    EXPECT_EQ(s4.stats().ticks, 400u);
+    EXPECT_EQ(s4.stats().shards, 400u * s4.shards());
+}
+
+// Sirpaleiden väliset tapahtumat: tulos ei riipu säikeiden määrästä
+TEST(ShardedCityTest, LinkedCityIsDeterministicAcrossThreads) {
+    const size_t n = 4000;
+    CitySim a(n, 500), b(n, 500);
+    random_city(a, n, 11);
+    random_city(b, n, 11);
+    city::ShardedCity s1(a, 64, 1), s4(b, 64, 4);
+    std::mt19937 rng(5);
+    for (int k = 0; k < 600; ++k) {
+        size_t src = rng() % n, dst = rng() % n;
+        int32_t delay = (int32_t)(rng() % 3000);
+        char col = "RYG"[rng() % 3];
+        s1.link(src, dst, delay, col);
+        s4.link(src, dst, delay, col);
+    }
+    for (int chunk = 0; chunk < 5; ++chunk) {   // myös run-kutsujen rajan yli
+        s1.run(100, 100);
+        s4.run(100, 100);
+    }
+    expect_same_state(a, b);
+    EXPECT_GT(s1.stats().events, 0u);
+    EXPECT_EQ(s1.stats().events, s4.stats().events);
+    EXPECT_EQ(s1.stats().steals, 0u);
+}
+
+// Automaattinen koko: vähintään SHARDS_PER_THREAD sirpaletta jokaiselle säikeelle
+TEST(ShardedCityTest, AutoShardSizeFollowsThreads) {
+    CitySim big(200000, 1000), small(100, 1000);
+    for (unsigned t : { 1u, 8u, 64u }) {
+        city::ShardedCity sc(big, 0, t);
+        EXPECT_EQ(sc.threads(), t);
+        EXPECT_GE(sc.shards(), (size_t)t * city::SHARDS_PER_THREAD);
+        EXPECT_LE(sc.shard_lanes(), city::SHARD_MAX_LANES);
+    }
+    // ylimääräiset säikeet karsitaan: 100 risteystä = 13 kahdeksan kaistan sirpaletta
+    city::ShardedCity sc(small, 0, 64);
+    EXPECT_EQ(sc.shard_lanes(), 8u);
+    EXPECT_EQ(sc.threads(), sc.shards());
+    sc.run(10, 100);
+    EXPECT_EQ(sc.stats().shards, 10u * sc.shards());
+}
+
+// Vihreä aalto: dst saa komennon täsmälleen viiveen jälkeen, toisessa sirpaleessa
+TEST(ShardedCityTest, GreenWaveArrivesAfterDelay) {
+    CitySim c(100, 1000);
+    city::ShardedCity sc(c, 8, 2);
+    sc.link(1, 90, 1500);
+    ASSERT_TRUE(c.push(1, 'G'));
+    sc.run(1, 100);                             // tikki 0: 1 vihreäksi
+    EXPECT_EQ(c.state().phase[1], city::GREEN);
+    sc.run(14, 100);                            // tikit 1..14: 1500 ms = 15 tikkiä
+    EXPECT_EQ(c.state().phase[90], city::OFF);
+    sc.run(1, 100);                             // tikki 15: erääntyy ja käynnistyy
+    EXPECT_EQ(c.state().phase[90], city::GREEN);
+    EXPECT_EQ(sc.stats().events, 1u);
+}
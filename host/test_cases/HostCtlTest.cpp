@@ -0,0 +1,280 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <thread>
+#include "HostCtl.h"
+#include "TraceScan.h"
+
+using namespace std::chrono_literals;
+
+TEST(HostCtlTest, ParseDispatchAndTask) {
+    TraceEvent d = parse_trace("Dispatch -> YELLOW");
+    EXPECT_EQ(d.kind, TraceKind::Dispatch);
+    EXPECT_EQ(d.color, 'Y');
+
+    TraceEvent t = parse_trace("TASK G time: 1000123 us");
+    EXPECT_EQ(t.kind, TraceKind::Task);
+    EXPECT_EQ(t.color, 'G');
+    EXPECT_EQ(t.value, 1000123);
+
+    EXPECT_EQ(parse_trace("TASK G time: x us").kind, TraceKind::Other);
+    EXPECT_EQ(parse_trace("Total (3 tasks): 3000 us").kind, TraceKind::Other);
+}
+
+TEST(HostCtlTest, ParseAckNak) {
+    TraceEvent a = parse_trace("ACK 17 3");
+    EXPECT_EQ(a.kind, TraceKind::Ack);
+    EXPECT_EQ(a.seq, 17);
+    EXPECT_EQ(a.value, 3);
+    EXPECT_FALSE(a.dup);
+    EXPECT_EQ(a.prio, -1);
+    EXPECT_TRUE(parse_trace("ACK 17 3 dup").dup);
+    EXPECT_EQ(parse_trace("ACK 17 3 dup").prio, -1);
+    EXPECT_EQ(parse_trace("ACK 17 3 1").prio, 1);
+
+    TraceEvent n = parse_trace("NAK 4 4");
+    EXPECT_EQ(n.kind, TraceKind::Nak);
+    EXPECT_EQ(n.seq, 4);
+    EXPECT_EQ(parse_trace("NAK timeout").seq, -1);
+}
+
+TEST(HostCtlTest, LineScannerSplitsChunks) {
+    LineScanner sc;
+    std::vector<std::string> lines;
+    auto cb = [&](std::string_view l) { lines.emplace_back(l); };
+    sc.feed("RED O", 5, cb);
+    sc.feed("N\r\nGR", 5, cb);
+    sc.feed("EEN ON\n", 7, cb);
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0], "RED ON");
+    EXPECT_EQ(lines[1], "GREEN ON");
+}
+
+TEST(HostCtlTest, Crc16KnownValue) {
+    const uint8_t s[] = { '1','2','3','4','5','6','7','8','9' };
+    EXPECT_EQ(crc16_ccitt_false(s, sizeof(s)), 0x29B1);
+}
+
+TEST(HostCtlTest, EncodeFrame) {
+    const uint8_t p[] = { 'R', '!', 'G' };
+    std::vector<uint8_t> f;
+    ASSERT_TRUE(encode_frame(9, p, sizeof(p), f));
+    ASSERT_EQ(f.size(), 8u);
+    EXPECT_EQ(f[0], FRAME_SYNC);
+    EXPECT_EQ(f[1], 3);
+    EXPECT_EQ(f[2], 9);
+    uint16_t crc = crc16_ccitt_false(f.data() + 1, 5);
+    EXPECT_EQ(f[6], crc >> 8);
+    EXPECT_EQ(f[7], crc & 0xFF);
+    EXPECT_FALSE(encode_frame(0, p, 0, f));
+}
+
+// Socketparin toinen pää esittää firmwarea
+class HostCtlLinkTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        int sv[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+        fw_ = sv[1];
+        ASSERT_TRUE(ctl_.attach(sv[0]));
+        ASSERT_EQ(fw_read(2), "\nN");    // new_session
+    }
+    void TearDown() override {
+        ctl_.close();
+        ::close(fw_);
+    }
+    std::string fw_read(size_t n) {
+        std::string s(n, '\0');
+        size_t got = 0;
+        while (got < n) {
+            ssize_t r = ::read(fw_, &s[got], n - got);
+            if (r <= 0) break;
+            got += (size_t)r;
+        }
+        s.resize(got);
+        return s;
+    }
+    void fw_write(const std::string &s) {
+        ASSERT_EQ(::write(fw_, s.data(), s.size()), (ssize_t)s.size());
+    }
+    LightController ctl_;
+    int fw_ = -1;
+};
+
+TEST_F(HostCtlLinkTest, PipelinedColors) {
+    auto r = ctl_.send_color('R');
+    auto g = ctl_.send_color('G');
+    auto x = ctl_.send_color('R', true);
+    EXPECT_EQ(fw_read(4), "RG!R");      // kaikki kirjoitettu ilman odotusta
+
+    fw_write("Dispatch -> RED\r\nTASK R time: 900 us\r\n");   // prio ensin
+    fw_write("Dispatch -> RED\r\nTASK R time: 1000 us\r\n");
+    fw_write("TASK G time: 1001 us\r\n");
+
+    ASSERT_EQ(x.wait_for(2s), std::future_status::ready);
+    PhaseResult px = x.get();
+    EXPECT_TRUE(px.prio);
+    EXPECT_EQ(px.phase_us, 900u);
+    EXPECT_GE(px.dispatch_us, 0);
+
+    ASSERT_EQ(r.wait_for(2s), std::future_status::ready);
+    EXPECT_EQ(r.get().phase_us, 1000u);
+    ASSERT_EQ(g.wait_for(2s), std::future_status::ready);
+    PhaseResult pg = g.get();
+    EXPECT_EQ(pg.phase_us, 1001u);
+    EXPECT_EQ(pg.dispatch_us, -1);
+}
+
+TEST_F(HostCtlLinkTest, ClockAndTimerCommands) {
+    EXPECT_TRUE(ctl_.sync_clock(7 * 3600000 + 15 * 60000 + 3 * 1000 + 42));
+    EXPECT_TRUE(ctl_.send_timer(7 * 3600 + 30 * 60));
+    EXPECT_EQ(fw_read(11 + 7), "C071503042\nA073000");
+    EXPECT_FALSE(ctl_.sync_clock(24 * 3600000));
+    EXPECT_FALSE(ctl_.send_timer(-1));
+}
+
+TEST_F(HostCtlLinkTest, SkippedColorIsDropped) {
+    auto r = ctl_.send_color('R');
+    auto y = ctl_.send_color('Y');
+    fw_read(2);
+    fw_write("TASK Y time: 5 us\n");
+    ASSERT_EQ(y.wait_for(2s), std::future_status::ready);
+    EXPECT_EQ(y.get().phase_us, 5u);
+    EXPECT_THROW(r.get(), std::runtime_error);
+}
+
+TEST_F(HostCtlLinkTest, BatchAckTruncates) {
+    BatchHandle h = ctl_.send_batch({ { 'Y' }, { 'A', false, 65 }, { 'G' } });
+    std::string f = fw_read(3 + 6 + 2);
+    ASSERT_EQ((uint8_t)f[0], FRAME_SYNC);
+    EXPECT_EQ(f[3], 'Y');
+    EXPECT_EQ(f[4], 'A');
+    EXPECT_EQ(f[6], 1);                 // 00:01:05
+    ASSERT_EQ(h.phases.size(), 2u);
+
+    fw_write("ACK " + std::to_string((uint8_t)f[2]) + " 1\n");   // G jäi jonosta pois
+    ASSERT_EQ(h.ack.wait_for(2s), std::future_status::ready);
+    EXPECT_EQ(h.ack.get().queued, 1);
+    EXPECT_THROW(h.phases[1].get(), std::runtime_error);
+
+    fw_write("TASK Y time: 7 us\n");
+    ASSERT_EQ(h.phases[0].wait_for(2s), std::future_status::ready);
+    EXPECT_EQ(h.phases[0].get().phase_us, 7u);
+}
+
+TEST_F(HostCtlLinkTest, NakFailsBatch) {
+    BatchHandle h = ctl_.send_batch({ { 'R' } });
+    std::string f = fw_read(6);
+    fw_write("NAK " + std::to_string((uint8_t)f[2]) + " 4\n");
+    EXPECT_THROW(h.ack.get(), std::runtime_error);
+    EXPECT_THROW(h.phases[0].get(), std::runtime_error);
+}
+
+// Rajoitin päästi yhden normaalin: R ja !G jonoon, Y ohitettu. Y ei saa
+// jäädä odottamaan ja napata myöhempää TASK Y -riviä.
+TEST_F(HostCtlLinkTest, RateLimitedMixedBatch) {
+    BatchHandle h = ctl_.send_batch({ { 'R' }, { 'Y' }, { 'G', true } });
+    std::string f = fw_read(3 + 4 + 2);
+    ASSERT_EQ(h.phases.size(), 3u);
+
+    fw_write("ACK " + std::to_string((uint8_t)f[2]) + " 2 1\n");
+    ASSERT_EQ(h.ack.wait_for(2s), std::future_status::ready);
+    FrameAck a = h.ack.get();
+    EXPECT_EQ(a.queued, 2);
+    EXPECT_EQ(a.prio, 1);
+    EXPECT_THROW(h.phases[1].get(), std::runtime_error);
+
+    fw_write("TASK G time: 3 us\nTASK R time: 4 us\n");
+    ASSERT_EQ(h.phases[2].wait_for(2s), std::future_status::ready);
+    EXPECT_EQ(h.phases[2].get().phase_us, 3u);
+    ASSERT_EQ(h.phases[0].wait_for(2s), std::future_status::ready);
+    EXPECT_EQ(h.phases[0].get().phase_us, 4u);
+
+    auto y = ctl_.send_color('Y');
+    fw_read(1);
+    fw_write("TASK Y time: 5 us\n");
+    ASSERT_EQ(y.wait_for(2s), std::future_status::ready);
+    EXPECT_EQ(y.get().phase_us, 5u);
+}
+
+// Firmware oli jo ottanut saman seq:n (edellinen istunto): erästä ei
+// jonoon mitään, eikä sen odottava Y saa napata myöhempää TASK Y -riviä
+TEST_F(HostCtlLinkTest, DupAckFailsBatch) {
+    BatchHandle h = ctl_.send_batch({ { 'Y' } });
+    std::string f = fw_read(6);
+    fw_write("ACK " + std::to_string((uint8_t)f[2]) + " 1 dup\n");
+    ASSERT_EQ(h.ack.wait_for(2s), std::future_status::ready);
+    EXPECT_TRUE(h.ack.get().dup);
+    EXPECT_THROW(h.phases[0].get(), std::runtime_error);
+
+    auto y = ctl_.send_color('Y');
+    fw_read(1);
+    fw_write("TASK Y time: 9 us\n");
+    ASSERT_EQ(y.wait_for(2s), std::future_status::ready);
+    EXPECT_EQ(y.get().phase_us, 9u);
+}
+
+TEST_F(HostCtlLinkTest, NewSessionRestartsSeq) {
+    BatchHandle a = ctl_.send_batch({ { 'R' } });
+    BatchHandle b = ctl_.send_batch({ { 'G' } });
+    std::string f = fw_read(12);
+    EXPECT_EQ(f[2], 0);
+    EXPECT_EQ(f[8], 1);
+
+    // firmware vastaa samaan seq:iin uuden istunnon jälkeen ilman dup:ia
+    ASSERT_TRUE(ctl_.new_session());
+    BatchHandle c = ctl_.send_batch({ { 'Y' } });
+    f = fw_read(2 + 6);
+    EXPECT_EQ(f.substr(0, 2), "\nN");
+    EXPECT_EQ(f[4], 0);
+    fw_write("SESSION\nACK 0 1 0\n");
+    ASSERT_EQ(c.ack.wait_for(2s), std::future_status::ready);
+    EXPECT_FALSE(c.ack.get().dup);
+}
+
+TEST_F(HostCtlLinkTest, BatchWriteFailureFailsBatch) {
+    std::signal(SIGPIPE, SIG_IGN);
+    ASSERT_EQ(::shutdown(fw_, SHUT_RD), 0);     // kirjoitus -> EPIPE
+    BatchHandle h = ctl_.send_batch({ { 'R' }, { 'G', true } });
+    ASSERT_EQ(h.ack.wait_for(2s), std::future_status::ready);
+    EXPECT_THROW(h.ack.get(), std::runtime_error);
+    ASSERT_EQ(h.phases.size(), 2u);
+    EXPECT_THROW(h.phases[0].get(), std::runtime_error);
+    EXPECT_THROW(h.phases[1].get(), std::runtime_error);
+
+    // kaistoille ei jäänyt mitään: myöhempi TASK ei osu erään
+    fw_write("TASK R time: 3 us\n");
+    for (int i = 0; i < 100 && ctl_.unmatched_lines() == 0; ++i)
+        std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(ctl_.unmatched_lines(), 1);
+}
+
+TEST_F(HostCtlLinkTest, SendLineValidatesFirst) {
+    LineHandle bad = ctl_.send_line("R Y A250000");
+    EXPECT_EQ(bad.error, TIME_ERROR);
+    EXPECT_EQ(bad.error_pos, 4);
+    EXPECT_TRUE(bad.phases.empty());
+
+    LineHandle h = ctl_.send_line("r !g A073000 x s");
+    ASSERT_EQ(h.error, COMMAND_OK);
+    ASSERT_EQ(h.phases.size(), 3u);
+    EXPECT_EQ(fw_read(1 + 2 + 7 + 2 + 1), "R!GA073000!RS");   // huono rivi ei lähettänyt mitään
+
+    fw_write("TASK G time: 1 us\nTASK R time: 2 us\nTASK R time: 3 us\n");
+    ASSERT_EQ(h.phases[1].wait_for(2s), std::future_status::ready);
+    EXPECT_TRUE(h.phases[1].get().prio);
+    EXPECT_EQ(h.phases[2].get().phase_us, 2u);
+    EXPECT_EQ(h.phases[0].get().phase_us, 3u);
+}
+
+TEST_F(HostCtlLinkTest, OtherLinesToHandler) {
+    std::promise<std::string> got;
+    ctl_.set_line_handler([&](std::string_view l) { got.set_value(std::string(l)); });
+    fw_write("DEBUG ON\n");
+    auto f = got.get_future();
+    ASSERT_EQ(f.wait_for(2s), std::future_status::ready);
+    EXPECT_EQ(f.get(), "DEBUG ON");
+}
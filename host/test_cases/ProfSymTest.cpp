@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "ProfSym.h"
+
+extern "C" __attribute__((noinline)) int profsym_probe(int x) {
+    return x * 3 + 1;
+}
+
+TEST(ProfSymTest, SymbolizesOwnExecutable) {
+    ElfSymbols syms;
+    ASSERT_TRUE(syms.load("/proc/self/exe")) << syms.error();
+    uint64_t a = syms.address_of("profsym_probe");
+    ASSERT_NE(a, 0u);
+    EXPECT_EQ(syms.lookup(a), "profsym_probe");
+    EXPECT_EQ(syms.lookup(a + 1), "profsym_probe");
+    EXPECT_TRUE(syms.lookup(0).empty());
+}
+
+TEST(ProfSymTest, RejectsNonElf) {
+    ElfSymbols syms;
+    EXPECT_FALSE(syms.load(std::vector<uint8_t>{ 'n', 'o', 'p', 'e' }));
+    EXPECT_FALSE(syms.error().empty());
+}
+
+TEST(ProfSymTest, ParsesLastDumpAmongOtherOutput) {
+    std::istringstream log(
+        "PROF BEGIN 1000 9 0\n"
+        "PROF S 0 00001000 9\n"
+        "PROF END\n"
+        "Dispatch -> RED\n"
+        "PROF BEGIN 1000 6 2\r\n"
+        "PROF T 0 uart_task\n"
+        "PROF T 1 idle\n"
+        "RED ON\n"
+        "PROF S 1 00000000 4\n"
+        "PROF S 0 00000000 2\n"
+        "PROF END\n");
+    ProfCapture c = parse_prof_log(log);
+    EXPECT_TRUE(c.complete);
+    EXPECT_EQ(c.hz, 1000u);
+    EXPECT_EQ(c.samples, 6u);
+    EXPECT_EQ(c.lost, 2u);
+    ASSERT_EQ(c.threads.size(), 2u);
+    EXPECT_EQ(c.threads[1], "idle");
+    ASSERT_EQ(c.runs.size(), 2u);
+    EXPECT_EQ(c.runs[0].count, 4u);
+}
+
+TEST(ProfSymTest, FoldsByThreadAndFunction) {
+    ElfSymbols syms;
+    ASSERT_TRUE(syms.load("/proc/self/exe"));
+    uint32_t a = (uint32_t)syms.address_of("profsym_probe");
+    ASSERT_NE(a, 0u);
+
+    ProfCapture c;
+    c.threads = { "uart_task", "idle" };
+    c.runs = { { 0, a, 3 }, { 1, 0, 5 }, { 0, a + 2, 4 }, { 7, 0, 1 } };
+    auto f = fold_samples(c, syms);
+    ASSERT_EQ(f.size(), 3u);
+    EXPECT_EQ(f[0].first, "uart_task;profsym_probe");
+    EXPECT_EQ(f[0].second, 7u);
+    EXPECT_EQ(f[1].first, "idle;[no-pc]");
+    EXPECT_EQ(f[2].first, "?;[no-pc]");
+}
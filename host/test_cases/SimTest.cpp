@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "TrafficModel.h"
+#include "VirtualKernel.h"
+
+using namespace vk;
+
+static Task sleeper(Kernel &k, std::vector<std::string> &log, const char *name, Time dt) {
+    co_await k.sleep(dt);
+    log.push_back(std::string(name) + "@" + std::to_string(k.now()));
+}
+
+TEST(SimTest, SleepAdvancesVirtualTimeInOrder) {
+    Kernel k;
+    std::vector<std::string> log;
+    k.spawn(sleeper(k, log, "b", ms(20)));
+    k.spawn(sleeper(k, log, "a", ms(10)));
+    k.spawn(sleeper(k, log, "c", ms(20)));
+    k.run();
+    EXPECT_EQ(log, (std::vector<std::string>{"a@10000", "b@20000", "c@20000"}));
+    EXPECT_EQ(k.now(), ms(20));
+}
+
+static Task taker(Kernel &k, Sem &s, Time to, std::vector<Time> &got) {
+    bool ok = co_await s.take(to);
+    got.push_back(ok ? k.now() : -k.now());
+}
+
+TEST(SimTest, SemaphoreTimeoutAndHandOff) {
+    Kernel k;
+    Sem s(k, 0, 1);
+    std::vector<Time> got;
+    k.spawn(taker(k, s, ms(5), got));
+    k.spawn(taker(k, s, FOREVER, got));
+    k.call_at(ms(8), [&] { s.give(); });
+    k.run();
+    // ensimmäinen aikakatkaisu 5 ms, toinen saa semaforin 8 ms
+    EXPECT_EQ(got, (std::vector<Time>{-ms(5), ms(8)}));
+    EXPECT_EQ(s.count(), 0u);
+}
+
+static Task poller(Kernel &k, Sem &a, Fifo<int> &f, std::vector<int> &res) {
+    res.push_back(co_await poll(k, &a, &f));
+    auto v = f.try_get();
+    res.push_back(v ? *v : -1);
+    res.push_back(co_await poll_for(k, ms(1), &a, &f));
+}
+
+TEST(SimTest, PollReportsReadyObjectWithoutConsuming) {
+    Kernel k;
+    Sem a(k, 0, 1);
+    Fifo<int> f(k);
+    std::vector<int> res;
+    k.spawn(poller(k, a, f, res));
+    k.call_at(ms(3), [&] { f.put(42); });
+    k.run();
+    EXPECT_EQ(res, (std::vector<int>{1, 42, -1}));
+}
+
+TEST(SimTest, SinglePhaseLastsLightMs) {
+    sim::TrafficModel m;
+    m.uart(ms(100), "r");
+    m.run_idle();
+    ASSERT_EQ(m.phases().size(), 1u);
+    const auto &p = m.phases()[0];
+    EXPECT_EQ(p.color, 'R');
+    EXPECT_EQ(p.t_on, ms(100));
+    EXPECT_EQ(p.t_off, ms(1100));
+    EXPECT_FALSE(p.aborted);
+    EXPECT_TRUE(m.check().empty());
+}
+
+TEST(SimTest, PriorityAbortsNormalPhaseImmediately) {
+    sim::TrafficModel m;
+    m.uart(0, "RY");
+    m.uart(ms(300), "!G");
+    m.run_idle();
+    ASSERT_EQ(m.phases().size(), 3u);
+    EXPECT_EQ(m.phases()[0].color, 'R');
+    EXPECT_TRUE(m.phases()[0].aborted);
+    EXPECT_EQ(m.phases()[0].t_off, ms(300));
+    EXPECT_EQ(m.phases()[1].color, 'G');
+    EXPECT_EQ(m.phases()[1].t_on, ms(300));
+    EXPECT_EQ(m.phases()[2].color, 'Y');
+    EXPECT_EQ(m.phases()[2].t_on, ms(1300));
+    EXPECT_TRUE(m.check().empty());
+}
+
+TEST(SimTest, TimerFiresLastColour) {
+    sim::TrafficModel m;
+    m.uart(0, "C000000\nGA000005A99");   // jälkimmäinen aika on kesken -> ei laukea
+    m.run_until(s(60));
+    ASSERT_EQ(m.phases().size(), 2u);
+    EXPECT_EQ(m.timer_fired(), 1u);
+    EXPECT_EQ(m.phases()[1].color, 'G');
+    EXPECT_EQ(m.phases()[1].t_in, s(5));
+
+    sim::TrafficModel bad;
+    bad.uart(0, "A996000RA000005");      // virheellinen aika; kelloa ei asetettu
+    bad.run_until(s(60));
+    EXPECT_EQ(bad.bad_time(), 2u);
+    EXPECT_EQ(bad.phases().size(), 1u);
+}
+
+// Kellonaikaan sidotut laukaisut: järjestyksessä, samalla hetkellä, joka päivä
+TEST(SimTest, WallClockTriggersRecurDaily) {
+    sim::TrafficModel m;
+    m.uart(0, "C235958\nRA000001YA000001A000001GA000000");   // Y kahdesti: yksi laukaisu
+    m.uart(s(10), "A235958");            // mennyt jo tänään -> vasta huomenna
+    m.run_until(s(20));
+    EXPECT_EQ(m.timer_fired(), 3u);
+    std::string order;
+    for (const auto &p : m.phases()) order.push_back(p.color);
+    EXPECT_EQ(order, "RYGGRY");          // komennot, sitten G 00:00:00, R+Y 00:00:01
+    EXPECT_EQ(m.phases()[3].t_in, s(2));
+    EXPECT_EQ(m.phases()[4].t_in, s(3));
+    EXPECT_EQ(m.phases()[5].t_in, s(3));
+
+    m.run_until(s(86400) + s(20));
+    EXPECT_EQ(m.timer_fired(), 7u);
+    EXPECT_EQ(m.phases()[6].color, 'G');
+    EXPECT_EQ(m.phases()[6].t_in, s(86400));    // 23:59:58 seuraavana päivänä
+    EXPECT_EQ(m.phases()[7].t_in, s(86402));
+    EXPECT_TRUE(m.check().empty());
+}
+
+TEST(SimTest, DayLongPlanRunsInVirtualTime) {
+    std::vector<sim::PlanStep> steps;
+    bool loop = false;
+    ASSERT_TRUE(sim::parse_plan("R30 Y3 G30 y3 *", steps, loop));
+    EXPECT_TRUE(loop);
+    ASSERT_EQ(steps.size(), 4u);
+    EXPECT_EQ(steps[3].color, 'Y');
+    EXPECT_EQ(steps[3].delay_s, 3u);
+    EXPECT_FALSE(sim::parse_plan("R", steps, loop));
+    EXPECT_FALSE(sim::parse_plan("R10 * G5", steps, loop));
+    EXPECT_FALSE(sim::parse_plan("Q10", steps, loop));
+
+    sim::TrafficModel m;
+    ASSERT_TRUE(sim::parse_plan("R30 Y3 G30 Y3 *", steps, loop));
+    m.plan(steps, loop);
+    m.run_until(s(86400));
+    EXPECT_EQ(m.now(), s(86400));
+    EXPECT_EQ(m.phases().size(), 86400u / 66u * 4u);   // 1309 kierrosta, loput 6 s < R30
+    EXPECT_TRUE(m.check().empty());
+}
+
+TEST(SimTest, ProgramAlternatesWithSeqFifo) {
+    sim::TrafficModel m;
+    m.program(0, {{'G', ms(500)}, {'Y', ms(200)}}, 0);   // x0: ikuisesti
+    m.uart(ms(100), "RRR");
+    m.button(ms(150), 'Y');
+    m.uart(ms(5000), "!R");
+    m.run_until(s(10));
+    const auto &ph = m.phases();
+    ASSERT_GT(ph.size(), 10u);
+    // askel, komento, askel, komento...; ohjelma jatkaa samasta kohdasta
+    std::string got;
+    for (size_t i = 0; i < 8; ++i) got += ph[i].color;
+    EXPECT_EQ(got, "GRYRGRYY");
+    for (size_t i = 0; i < 8; ++i) EXPECT_EQ(ph[i].program, i % 2 == 0) << i;
+    EXPECT_EQ(ph[2].t_on - ph[2].t_off + ph[2].len, 0);
+    EXPECT_EQ(m.queued(), 0u);
+    EXPECT_EQ(m.accepted(), 5u);
+    for (const auto &e : m.check()) ADD_FAILURE() << e;
+
+    sim::TrafficModel once;
+    once.program(0, {{'R', ms(300)}}, 2);
+    once.uart(ms(1000), "G");
+    once.run_idle();
+    ASSERT_EQ(once.phases().size(), 3u);
+    EXPECT_EQ(once.phases()[2].color, 'G');
+    EXPECT_TRUE(once.check().empty());
+}
+
+TEST(SimTest, RandomScenariosKeepInvariants) {
+    sim::RunSummary s = sim::run_scenarios(1, 300, 20, vk::s(30));
+    EXPECT_EQ(s.scenarios, 300u);
+    EXPECT_GT(s.phases, 300u);
+    for (const auto &f : s.failures) ADD_FAILURE() << f;
+}
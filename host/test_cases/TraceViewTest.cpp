@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "TraceView.h"
+
+TEST(TraceViewTest, ParsesBabeltraceLine) {
+    CtfEvent ev;
+    ASSERT_TRUE(parse_babeltrace_line(
+        "[00:00:01.000123400] (+0.000000800) thread_switched_in: { cpu_id = 0 }, "
+        "{ thread_id = 2147492224, name = \"red, thread\" }", ev));
+    EXPECT_EQ(ev.t_ns, 1000123400);
+    EXPECT_EQ(ev.name, "thread_switched_in");
+    ASSERT_NE(ev.field("name"), nullptr);
+    EXPECT_EQ(*ev.field("name"), "red, thread");
+    EXPECT_EQ(ev.num("thread_id"), 2147492224LL);
+    EXPECT_EQ(ev.num("cpu_id", -1), 0);
+
+    ASSERT_TRUE(parse_babeltrace_line("[3723.5] named_event: { name = \"cmd_in\", arg0 = 82, arg1 = 100 }", ev));
+    EXPECT_EQ(ev.t_ns, 3723500000000LL);
+    EXPECT_EQ(*ev.field("name"), "cmd_in");
+    EXPECT_EQ(ev.num("arg0"), 82);
+
+    EXPECT_FALSE(parse_babeltrace_line("Dispatch -> RED", ev));
+}
+
+static void feed_text(TimelineBuilder &tl, const char *text) {
+    std::istringstream in(text);
+    std::string line;
+    CtfEvent ev;
+    while (std::getline(in, line)) {
+        if (parse_babeltrace_line(line, ev)) tl.feed(ev);
+    }
+    tl.finish();
+}
+
+// Dispatcher odottaa edellisen vaiheen release_semiä, komento jonottaa
+static const char *kTrace =
+    "[0.000000000] thread_switched_in: { thread_id = 1, name = \"dispatcher_thread\" }\n"
+    "[0.000010000] semaphore_take_enter: { id = 9, timeout = -1 }\n"
+    "[0.000010000] semaphore_take_blocking: { id = 9, timeout = -1 }\n"
+    "[0.000010000] thread_pending: { thread_id = 1, name = \"dispatcher_thread\" }\n"
+    "[0.000010000] thread_switched_out: { thread_id = 1, name = \"dispatcher_thread\" }\n"
+    "[0.000010000] thread_switched_in: { thread_id = 2, name = \"uart_thread\" }\n"
+    "[0.001000000] named_event: { name = \"cmd_in\", arg0 = 82, arg1 = 100 }\n"
+    "[0.001200000] thread_switched_out: { thread_id = 2, name = \"uart_thread\" }\n"
+    "[0.001200000] thread_switched_in: { thread_id = 5, name = \"idle\" }\n"
+    "[0.002000000] isr_enter: { }\n"
+    "[0.002000000] semaphore_give_enter: { id = 9 }\n"
+    "[0.002000000] thread_ready: { thread_id = 1, name = \"dispatcher_thread\" }\n"
+    "[0.002000000] semaphore_give_exit: { id = 9 }\n"
+    "[0.002000000] isr_exit: { }\n"
+    "[0.002500000] thread_switched_out: { thread_id = 5, name = \"idle\" }\n"
+    "[0.002500000] thread_switched_in: { thread_id = 1, name = \"dispatcher_thread\" }\n"
+    "[0.002500000] semaphore_take_exit: { id = 9, timeout = -1, ret = 0 }\n"
+    "[0.002600000] named_event: { name = \"cmd_disp\", arg0 = 82, arg1 = 100 }\n"
+    "[0.002700000] thread_pending: { thread_id = 1, name = \"dispatcher_thread\" }\n"
+    "[0.002700000] thread_switched_out: { thread_id = 1, name = \"dispatcher_thread\" }\n"
+    "[0.002700000] thread_switched_in: { thread_id = 3, name = \"red_thread\" }\n"
+    "[0.002800000] named_event: { name = \"led_on\", arg0 = 82, arg1 = 100 }\n"
+    "[0.003000000] named_event: { name = \"led_off\", arg0 = 82, arg1 = 100 }\n"
+    "[0.003050000] named_event: { name = \"meas\", arg0 = 82, arg1 = 200 }\n"
+    "[0.003100000] thread_switched_out: { thread_id = 3, name = \"red_thread\" }\n"
+    "[0.003100000] thread_switched_in: { thread_id = 1, name = \"dispatcher_thread\" }\n";
+
+TEST(TraceViewTest, RebuildsCommandPath) {
+    TimelineBuilder tl;
+    feed_text(tl, kTrace);
+    ASSERT_EQ(tl.commands().size(), 1u);
+    const CommandPath &c = tl.commands()[0];
+    EXPECT_EQ(c.color, 'R');
+    EXPECT_FALSE(c.program);
+    EXPECT_FALSE(c.aborted);
+    EXPECT_EQ(c.t_disp - c.t_in, 1600000);
+    EXPECT_EQ(c.t_on - c.t_disp, 200000);
+    EXPECT_EQ(c.t_off - c.t_on, 200000);
+    EXPECT_EQ(c.t_release - c.t_off, 100000);
+    EXPECT_EQ(c.meas_us, 200);
+    EXPECT_EQ(c.led_thread, "red_thread");
+    EXPECT_EQ(tl.switches(c.t_in, c.t_release), 4);
+}
+
+TEST(TraceViewTest, ExplainsQueueWait) {
+    TimelineBuilder tl;
+    feed_text(tl, kTrace);
+    const CommandPath &c = tl.commands()[0];
+
+    auto d = tl.breakdown("dispatcher_thread", c.t_in, c.t_disp);
+    ASSERT_EQ(d.size(), 3u);
+    EXPECT_EQ(d[0].state, ThreadState::Blocked);
+    EXPECT_EQ(d[0].op, "semaphore_take");
+    EXPECT_EQ(d[0].ns, 1000000);
+    EXPECT_EQ(d[1].state, ThreadState::Ready);
+    EXPECT_EQ(d[1].ns, 500000);
+
+    auto r = tl.running(c.t_in, c.t_disp, "dispatcher_thread");
+    ASSERT_EQ(r.size(), 2u);
+    EXPECT_EQ(r[0].thread, "idle");
+    EXPECT_EQ(r[0].ns, 1300000);
+    EXPECT_EQ(r[1].thread, "uart_thread");
+
+    std::string rep = format_command(tl, c, 0);
+    EXPECT_NE(rep.find("blocked semaphore_take 1.000 ms"), std::string::npos) << rep;
+}
+
+TEST(TraceViewTest, BatchCommandsShareIdInOrder) {
+    TimelineBuilder tl;
+    feed_text(tl,
+        "[0.0] thread_switched_in: { name = \"uart_thread\" }\n"
+        "[0.1] named_event: { name = \"cmd_in\", arg0 = 71, arg1 = 7 }\n"
+        "[0.1] named_event: { name = \"cmd_in\", arg0 = 89, arg1 = 7 }\n"
+        "[0.2] named_event: { name = \"cmd_disp\", arg0 = 71, arg1 = 7 }\n"
+        "[0.3] named_event: { name = \"cmd_disp\", arg0 = 89, arg1 = 7 }\n"
+        "[0.4] named_event: { name = \"cmd_disp\", arg0 = 82, arg1 = 9 }\n"
+        "[0.5] named_event: { name = \"fifo_hwm\", arg0 = 0, arg1 = 2 }\n"
+        "[0.6] named_event: { name = \"drop\", arg0 = 1, arg1 = 3 }\n");
+    ASSERT_EQ(tl.commands().size(), 3u);
+    EXPECT_EQ(tl.commands()[0].color, 'G');
+    EXPECT_EQ(tl.commands()[0].t_disp, 200000000);
+    EXPECT_EQ(tl.commands()[1].t_disp, 300000000);
+    EXPECT_TRUE(tl.commands()[2].program);
+    EXPECT_EQ(tl.fifo_hwm().at(0), 2u);
+    EXPECT_EQ(tl.drops().at(1), 3u);
+    EXPECT_STREQ(drop_cause_name(1), "unknown_char");
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "FloodGen.h"
+
+
+TEST(UartFloodTest, GenerateIsDeterministic) {
+    FloodConfig cfg;
+    cfg.count = 50; cfg.error_ratio = 0.2; cfg.timed_ratio = 0.1; cfg.seed = 7;
+    auto a = flood_generate(cfg);
+    auto b = flood_generate(cfg);
+    ASSERT_EQ(a.size(), 50u);
+    for (size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a[i].text, b[i].text);
+        EXPECT_EQ(a[i].t_us, b[i].t_us);
+    }
+}
+
+TEST(UartFloodTest, BurstsShareSendTime) {
+    FloodConfig cfg;
+    cfg.count = 8; cfg.burst = 4; cfg.rate_hz = 4.0;   // 1 purske / s
+    auto c = flood_generate(cfg);
+    EXPECT_EQ(c[0].t_us, 0);
+    EXPECT_EQ(c[3].t_us, 0);
+    EXPECT_EQ(c[4].t_us, 1000000);
+}
+
+TEST(UartFloodTest, TimedCommandsAreValidAtime) {
+    FloodConfig cfg;
+    cfg.count = 20; cfg.timed_ratio = 1.0;
+    for (const auto &c : flood_generate(cfg)) {
+        ASSERT_EQ(c.kind, CmdKind::Timed);
+        ASSERT_EQ(c.text.size(), 7u);
+        EXPECT_EQ(c.text[0], 'A');
+        EXPECT_GE(c.delay_s, 1);
+    }
+}
+
+TEST(UartFloodTest, MatchesDispatchInFifoOrder) {
+    FloodMatcher m;
+    m.on_send({ 0, CmdKind::Color, 'R', 0, "R" }, 0);
+    m.on_send({ 0, CmdKind::Color, 'G', 0, "G" }, 100);
+    m.on_line("Dispatch -> RED\r\n", 1000);
+    m.on_line("Dispatch -> GREEN", 3000);
+    FloodReport r = m.finish(4000);
+    EXPECT_EQ(r.matched, 2);
+    EXPECT_EQ(r.dropped, 0);
+    EXPECT_EQ(r.max_us, 2900);
+}
+
+TEST(UartFloodTest, SkippedCommandsCountAsDropped) {
+    FloodMatcher m;
+    m.on_send({ 0, CmdKind::Color, 'R', 0, "R" }, 0);   // k_malloc epäonnistui
+    m.on_send({ 0, CmdKind::Color, 'Y', 0, "Y" }, 0);
+    m.on_send({ 0, CmdKind::Color, 'G', 0, "G" }, 0);
+    m.on_line("Dispatch -> YELLOW", 10);
+    FloodReport r = m.finish(20);
+    EXPECT_EQ(r.matched, 1);
+    EXPECT_EQ(r.dropped, 2);                            // R ohitettu, G ei tullut
+}
+
+TEST(UartFloodTest, LedOnModeAndTimer) {
+    FloodMatcher m(MatchMode::LedOn);
+    m.on_send({ 0, CmdKind::Color, 'Y', 0, "Y" }, 0);
+    m.on_send({ 0, CmdKind::Timed, 0, 1, "A000001" }, 0);
+    m.on_line("Dispatch -> YELLOW", 5);                 // ei käytetä LedOn-tilassa
+    m.on_line("YELLOW ON", 10);
+    m.on_line("TIMER -> Y (Wait 1 s)", 1000050);
+    m.on_line("YELLOW ON", 1000100);
+    m.on_line("Invalid time '990000' (ERROR=-3)", 1000200);
+    FloodReport r = m.finish(2000000);
+    EXPECT_EQ(r.matched, 2);
+    EXPECT_EQ(r.dropped, 0);
+    EXPECT_EQ(r.rejected, 1);
+    EXPECT_EQ(r.max_us, 50);
+}
+
+// Firmwaren lista täynnä: komentoa ei odoteta eikä se ole pudotettu
+TEST(UartFloodTest, TriggerListFullIsRejected) {
+    FloodMatcher m;
+    m.on_send({ 0, CmdKind::Timed, 0, 1, "A000001" }, 0);
+    m.on_send({ 0, CmdKind::Timed, 0, 2, "A000002" }, 0);
+    m.on_line("WALL 00:00:01 -> R", 10);
+    m.on_line("WALL trigger list full", 20);
+    m.on_line("TIMER -> R", 1000100);
+    FloodReport r = m.finish(3000000);
+    EXPECT_EQ(r.expected, 1);
+    EXPECT_EQ(r.matched, 1);
+    EXPECT_EQ(r.rejected, 1);
+    EXPECT_EQ(r.dropped, 0);
+}
+
+TEST(UartFloodTest, Percentiles) {
+    LatencyStats s;
+    for (int i = 1; i <= 100; ++i) s.add(i);
+    EXPECT_EQ(s.percentile(50.0), 50);
+    EXPECT_EQ(s.percentile(99.0), 99);
+    EXPECT_EQ(s.max(), 100);
+}
@@ -0,0 +1,391 @@
+#include "TraceView.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+const std::string *CtfEvent::field(std::string_view key) const {
+    for (const auto &f : fields) {
+        if (f.first == key) return &f.second;
+    }
+    return nullptr;
+}
+
+int64_t CtfEvent::num(std::string_view key, int64_t def) const {
+    const std::string *v = field(key);
+    if (!v || v->empty()) return def;
+    char *end = nullptr;
+    long long n = std::strtoll(v->c_str(), &end, 0);
+    return end == v->c_str() ? def : (int64_t)n;
+}
+
+static bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+static std::string_view trim(std::string_view s) {
+    while (!s.empty() && is_space(s.front())) s.remove_prefix(1);
+    while (!s.empty() && is_space(s.back()))  s.remove_suffix(1);
+    return s;
+}
+
+static bool ends_with(std::string_view s, std::string_view suf) {
+    return s.size() >= suf.size() && s.substr(s.size() - suf.size()) == suf;
+}
+
+// "01:02:03.000000123", "3723.000000123" tai pelkät syklit (--clock-cycles)
+static bool parse_stamp(std::string_view s, int64_t &ns) {
+    int64_t secs = 0, part = 0, frac = 0;
+    int fdigits = 0;
+    bool in_frac = false, any = false;
+    for (char c : s) {
+        if (c >= '0' && c <= '9') {
+            any = true;
+            if (!in_frac)          part = part * 10 + (c - '0');
+            else if (fdigits < 9) { frac = frac * 10 + (c - '0'); ++fdigits; }
+        } else if (c == ':' && !in_frac) {
+            secs = secs * 60 + part;
+            part = 0;
+        } else if (c == '.' && !in_frac) {
+            in_frac = true;
+        } else {
+            return false;
+        }
+    }
+    if (!any) return false;
+    while (fdigits < 9) { frac *= 10; ++fdigits; }
+    ns = (secs * 60 + part) * 1000000000LL + frac;
+    return true;
+}
+
+// "k = v, k2 = "a, b"" -> kentät
+static void parse_fields(std::string_view s, CtfEvent &ev) {
+    size_t i = 0;
+    while (i < s.size()) {
+        size_t eq = s.find('=', i);
+        if (eq == std::string_view::npos) break;
+        std::string_view key = trim(s.substr(i, eq - i));
+        size_t j = eq + 1;
+        while (j < s.size() && is_space(s[j])) ++j;
+        std::string val;
+        if (j < s.size() && s[j] == '"') {
+            for (++j; j < s.size() && s[j] != '"'; ++j) {
+                if (s[j] == '\\' && j + 1 < s.size()) ++j;
+                val.push_back(s[j]);
+            }
+            j = s.find(',', j);
+        } else {
+            size_t e = s.find(',', j);
+            val = std::string(trim(s.substr(j, e == std::string_view::npos ? std::string_view::npos : e - j)));
+            j = e;
+        }
+        ev.fields.emplace_back(std::string(key), std::move(val));
+        if (j == std::string_view::npos) break;
+        i = j + 1;
+    }
+}
+
+bool parse_babeltrace_line(std::string_view line, CtfEvent &ev) {
+    ev = CtfEvent{};
+    line = trim(line);
+    if (line.empty() || line[0] != '[') return false;
+    size_t rb = line.find(']');
+    if (rb == std::string_view::npos || !parse_stamp(line.substr(1, rb - 1), ev.t_ns)) return false;
+
+    // tapahtuman nimi on ensimmäistä ": {" edeltävä sana
+    size_t name_end = line.find(": {", rb);
+    if (name_end == std::string_view::npos) {
+        if (line.back() != ':') return false;   // kentätön tapahtuma
+        name_end = line.size() - 1;
+    }
+    size_t name_start = line.find_last_of(" )", name_end);
+    if (name_start == std::string_view::npos || name_start < rb) name_start = rb;
+    ev.name = std::string(trim(line.substr(name_start + 1, name_end - name_start - 1)));
+    if (ev.name.empty()) return false;
+
+    // kaikki { ... } -ryhmät (konteksti + payload)
+    size_t p = name_end;
+    while ((p = line.find('{', p)) != std::string_view::npos) {
+        size_t q = line.find('}', p);
+        if (q == std::string_view::npos) q = line.size();
+        parse_fields(line.substr(p + 1, q - p - 1), ev);
+        p = q;
+    }
+    return true;
+}
+
+const char *state_name(ThreadState s) {
+    switch (s) {
+        case ThreadState::Running: return "running";
+        case ThreadState::Blocked: return "blocked";
+        case ThreadState::Ready:   return "ready";
+    }
+    return "?";
+}
+
+const char *drop_cause_name(uint32_t cause) {
+    static const char *const names[] = {
+        "rx_overrun", "unknown_char", "bad_time", "bad_frame", "btn_busy",
+        "nomem_uart", "nomem_btn", "nomem_timer", "rate_limit", "bus_lag",
+    };
+    return cause < sizeof(names) / sizeof(names[0]) ? names[cause] : "?";
+}
+
+const char *fifo_name(uint32_t q) {
+    static const char *const names[] = { "seq_fifo", "prio_fifo" };
+    return q < sizeof(names) / sizeof(names[0]) ? names[q] : "?";
+}
+
+TimelineBuilder::TimelineBuilder(std::string dispatcher)
+    : disp_name_(std::move(dispatcher)) {}
+
+void TimelineBuilder::open_state(const std::string &th, ThreadState st, std::string op, int64_t t) {
+    ThreadTrack &tr = threads_[th];
+    if (tr.open) {
+        Interval &last = tr.iv.back();
+        last.t1 = t;
+        // sama tila jatkuu (esim. toistuva ready): ei uutta väliä
+        if (last.state == st && last.op == op) return;
+    }
+    tr.iv.push_back({ st, std::move(op), t, t });
+    tr.open = true;
+}
+
+static std::string thread_key(const CtfEvent &ev) {
+    const std::string *n = ev.field("name");
+    if (n && !n->empty()) return *n;
+    const std::string *id = ev.field("thread_id");
+    return id ? "thread@" + *id : std::string("?");
+}
+
+// "semaphore_take_blocking" -> "semaphore_take"
+static bool kernel_op(std::string_view name, std::string_view &base, std::string_view &phase) {
+    for (std::string_view suf : { "_enter", "_blocking", "_exit" }) {
+        if (ends_with(name, suf)) {
+            base  = name.substr(0, name.size() - suf.size());
+            phase = suf;
+            return true;
+        }
+    }
+    return false;
+}
+
+void TimelineBuilder::feed(const CtfEvent &ev) {
+    last_t_ = std::max(last_t_, ev.t_ns);
+    const std::string &n = ev.name;
+
+    if (n == "isr_enter") { ++isr_depth_; return; }
+    if (n == "isr_exit")  { if (isr_depth_) --isr_depth_; return; }
+
+    if (n == "thread_switched_out") {
+        std::string th = thread_key(ev);
+        ThreadTrack &tr = threads_[th];
+        bool blocked = tr.pended ||
+                       (!tr.ops.empty() && (tr.ops.back() == "thread_sleep" || tr.ops.back() == "poll"));
+        if (blocked) open_state(th, ThreadState::Blocked, tr.ops.empty() ? "pend" : tr.ops.back(), ev.t_ns);
+        else         open_state(th, ThreadState::Ready, {}, ev.t_ns);
+        if (cur_ == th) cur_.clear();
+        return;
+    }
+    if (n == "thread_switched_in") {
+        std::string th = thread_key(ev);
+        threads_[th].pended = false;
+        open_state(th, ThreadState::Running, {}, ev.t_ns);
+        cur_ = th;
+        switch_t_.push_back(ev.t_ns);
+        // vaiheen päätyttyä dispatcher herää release_semistä
+        if (th == disp_name_ && active_ >= 0) {
+            CommandPath &c = cmds_[(size_t)active_];
+            if (c.t_off >= 0 && c.t_release < 0) c.t_release = ev.t_ns;
+        }
+        return;
+    }
+    if (n == "thread_pending") {
+        threads_[thread_key(ev)].pended = true;
+        return;
+    }
+    if (n == "thread_ready") {
+        std::string th = thread_key(ev);
+        ThreadTrack &tr = threads_[th];
+        tr.pended = false;
+        // herätetty, mutta ei vielä ajossa
+        if (tr.open && tr.iv.back().state == ThreadState::Blocked) open_state(th, ThreadState::Ready, "woken", ev.t_ns);
+        return;
+    }
+    if (n == "named_event") { on_named(ev); return; }
+
+    std::string_view base, phase;
+    if (isr_depth_ == 0 && !cur_.empty() && kernel_op(n, base, phase)) {
+        std::vector<std::string> &ops = threads_[cur_].ops;
+        if (phase == "_exit") {
+            auto it = std::find(ops.rbegin(), ops.rend(), base);
+            if (it != ops.rend()) ops.erase(std::next(it).base(), ops.end());
+        } else if (ops.empty() || ops.back() != base) {
+            ops.emplace_back(base);
+        }
+        if (phase == "_blocking") threads_[cur_].pended = true;
+    }
+}
+
+void TimelineBuilder::on_named(const CtfEvent &ev) {
+    const std::string *nm = ev.field("name");
+    if (!nm) return;
+    uint32_t a0 = (uint32_t)ev.num("arg0");
+    uint32_t id = (uint32_t)ev.num("arg1");
+    char col = (char)(a0 & 0xff);
+
+    if (*nm == "cmd_in") {
+        CommandPath c;
+        c.id = id; c.color = col; c.t_in = ev.t_ns;
+        queued_[id].push_back(cmds_.size());
+        cmds_.push_back(c);
+    } else if (*nm == "cmd_disp") {
+        auto q = queued_.find(id);
+        size_t idx;
+        if (q != queued_.end() && !q->second.empty()) {
+            idx = q->second.front();
+            q->second.erase(q->second.begin());     // saman kehyksen komennot jakavat id:n
+            if (q->second.empty()) queued_.erase(q);
+        } else {
+            CommandPath c;
+            c.id = id; c.color = col; c.program = true; c.t_in = ev.t_ns;
+            idx = cmds_.size();
+            cmds_.push_back(c);
+        }
+        cmds_[idx].t_disp = ev.t_ns;
+        active_ = (long)idx;
+    } else if (active_ >= 0 && cmds_[(size_t)active_].id == id && *nm == "led_on") {
+        cmds_[(size_t)active_].t_on = ev.t_ns;
+        cmds_[(size_t)active_].led_thread = cur_;
+    } else if (active_ >= 0 && cmds_[(size_t)active_].id == id && *nm == "led_off") {
+        cmds_[(size_t)active_].t_off = ev.t_ns;
+        cmds_[(size_t)active_].aborted = (a0 >> 8) & 1;
+    } else if (*nm == "drop") {
+        drops_[a0] = std::max(drops_[a0], id);
+    } else if (*nm == "fifo_hwm") {
+        hwm_[a0] = std::max(hwm_[a0], id);
+    } else if (*nm == "meas") {
+        for (auto it = cmds_.rbegin(); it != cmds_.rend(); ++it) {
+            if (it->t_off >= 0 && it->color == col && it->meas_us < 0) { it->meas_us = id; break; }
+        }
+    }
+}
+
+void TimelineBuilder::finish() {
+    for (auto &kv : threads_) {
+        if (kv.second.open) kv.second.iv.back().t1 = last_t_;
+    }
+}
+
+static void add_share(std::vector<WaitShare> &out, const std::string &th, const Interval &iv, int64_t ns) {
+    for (WaitShare &w : out) {
+        if (w.thread == th && w.state == iv.state && w.op == iv.op) { w.ns += ns; return; }
+    }
+    out.push_back({ th, iv.state, iv.op, ns });
+}
+
+static void sort_shares(std::vector<WaitShare> &v) {
+    std::stable_sort(v.begin(), v.end(), [](const WaitShare &a, const WaitShare &b) { return a.ns > b.ns; });
+}
+
+// Välit ovat säikeittäin aikajärjestyksessä: haetaan ensimmäinen joka päättyy t0:n jälkeen
+template <typename F>
+static void overlap(const std::vector<Interval> &iv, int64_t t0, int64_t t1, F &&f) {
+    auto it = std::lower_bound(iv.begin(), iv.end(), t0,
+                               [](const Interval &a, int64_t t) { return a.t1 <= t; });
+    for (; it != iv.end() && it->t0 < t1; ++it) {
+        int64_t ns = std::min(it->t1, t1) - std::max(it->t0, t0);
+        if (ns > 0) f(*it, ns);
+    }
+}
+
+std::vector<WaitShare> TimelineBuilder::breakdown(const std::string &thread, int64_t t0, int64_t t1) const {
+    std::vector<WaitShare> out;
+    auto tr = threads_.find(thread);
+    if (tr == threads_.end() || t1 <= t0) return out;
+    overlap(tr->second.iv, t0, t1, [&](const Interval &iv, int64_t ns) { add_share(out, thread, iv, ns); });
+    sort_shares(out);
+    return out;
+}
+
+std::vector<WaitShare> TimelineBuilder::running(int64_t t0, int64_t t1, const std::string &except) const {
+    std::vector<WaitShare> out;
+    if (t1 <= t0) return out;
+    for (const auto &kv : threads_) {
+        if (kv.first == except) continue;
+        overlap(kv.second.iv, t0, t1, [&](const Interval &iv, int64_t ns) {
+            if (iv.state == ThreadState::Running) add_share(out, kv.first, iv, ns);
+        });
+    }
+    sort_shares(out);
+    return out;
+}
+
+int TimelineBuilder::switches(int64_t t0, int64_t t1) const {
+    auto a = std::lower_bound(switch_t_.begin(), switch_t_.end(), t0);
+    auto b = std::upper_bound(switch_t_.begin(), switch_t_.end(), t1);
+    return (int)(b - a);
+}
+
+static std::string fmt_shares(const std::vector<WaitShare> &v, size_t max, bool with_thread) {
+    std::string s;
+    char buf[160];
+    for (size_t i = 0; i < v.size() && i < max; ++i) {
+        const WaitShare &w = v[i];
+        std::snprintf(buf, sizeof(buf), "%s%s%s%s%s%s %.3f ms",
+                      i ? ", " : "",
+                      with_thread ? w.thread.c_str() : "", with_thread ? " " : "",
+                      state_name(w.state), w.op.empty() ? "" : " ", w.op.c_str(),
+                      (double)w.ns / 1e6);
+        s += buf;
+    }
+    return s.empty() ? "-" : s;
+}
+
+static void stage(std::string &out, const char *label, int64_t a, int64_t b, const char *what) {
+    char buf[128];
+    if (a < 0 || b < 0) std::snprintf(buf, sizeof(buf), "  %-8s      -      (%s)\n", label, what);
+    else                std::snprintf(buf, sizeof(buf), "  %-8s %10.3f ms (%s)\n", label, (double)(b - a) / 1e6, what);
+    out += buf;
+}
+
+std::string format_command(const TimelineBuilder &tl, const CommandPath &c, size_t index) {
+    std::string out;
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "#%zu %c id %08x%s%s", index, c.color ? c.color : '?', c.id,
+                  c.program ? " [program]" : "", c.aborted ? " [aborted]" : "");
+    out += buf;
+    if (c.meas_us >= 0) {
+        std::snprintf(buf, sizeof(buf), "  meas %lld us", (long long)c.meas_us);
+        out += buf;
+    }
+    out += '\n';
+    if (c.t_disp < 0) {
+        out += "  not dispatched (dropped or still queued)\n";
+        return out;
+    }
+
+    stage(out, "queue",   c.t_in,   c.t_disp,    "input -> dispatch, seq_fifo/prio_fifo");
+    stage(out, "handoff", c.t_disp, c.t_on,      "dispatch -> GPIO on, mutex + condvar");
+    stage(out, "phase",   c.t_on,   c.t_off,     "GPIO on -> off");
+    stage(out, "release", c.t_off,  c.t_release, "GPIO off -> dispatcher runs, release_sem");
+
+    int64_t end = c.t_release >= 0 ? c.t_release : (c.t_off >= 0 ? c.t_off : c.t_disp);
+    std::snprintf(buf, sizeof(buf), "  switches %d\n", tl.switches(c.t_in, end));
+    out += buf;
+
+    // miksi jono odotti: mitä dispatcher teki ja kuka oli ajossa
+    if (c.t_disp > c.t_in) {
+        out += "  queue:   " + tl.dispatcher() + " " +
+               fmt_shares(tl.breakdown(tl.dispatcher(), c.t_in, c.t_disp), 3, false) + "\n";
+        out += "           ran " + fmt_shares(tl.running(c.t_in, c.t_disp, tl.dispatcher()), 3, true) + "\n";
+    }
+    if (c.t_on > c.t_disp && !c.led_thread.empty()) {
+        out += "  handoff: " + c.led_thread + " " +
+               fmt_shares(tl.breakdown(c.led_thread, c.t_disp, c.t_on), 3, false) + "\n";
+    }
+    if (c.t_release > c.t_off) {
+        out += "  release: " + tl.dispatcher() + " " +
+               fmt_shares(tl.breakdown(tl.dispatcher(), c.t_off, c.t_release), 3, false) + "\n";
+    }
+    return out;
+}
@@ -0,0 +1,114 @@
+#ifndef TRACEVIEW_H
+#define TRACEVIEW_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Zephyrin CTF-jäljen (babeltrace2:n tekstituloste) analyysi: kootaan
+// jokaisen komennon polku syöte -> seq_fifo -> dispatcher -> LED-taskin
+// condvar -> vaihe -> release_sem ja selvitetään miksi se odotti.
+// Sovelluksen tapahtumat: LIIKENNEVALOT/src/trace.h.
+
+struct CtfEvent {
+    int64_t     t_ns = 0;
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> fields;   // lainausmerkit poistettu
+
+    const std::string *field(std::string_view key) const;
+    int64_t num(std::string_view key, int64_t def = 0) const;
+};
+
+// "[hh:mm:ss.nnnnnnnnn] (+d) event: { k = v, ... }" (myös --clock-seconds)
+bool parse_babeltrace_line(std::string_view line, CtfEvent &ev);
+
+enum class ThreadState {
+    Running,
+    Blocked,    // odottaa kernel-objektia (op kertoo mitä)
+    Ready,      // ajovalmis, mutta CPU muilla
+};
+
+struct Interval {
+    ThreadState state;
+    std::string op;     // Blocked: esim. "semaphore_take", "condvar_wait"
+    int64_t     t0;
+    int64_t     t1;
+};
+
+struct WaitShare {
+    std::string thread;
+    ThreadState state;
+    std::string op;
+    int64_t     ns;
+};
+
+struct CommandPath {
+    uint32_t    id         = 0;     // syötteen t_in
+    char        color      = 0;
+    bool        program    = false; // ohjelman askel, ei cmd_in-tapahtumaa
+    bool        aborted    = false;
+    int64_t     t_in       = -1;
+    int64_t     t_disp     = -1;
+    int64_t     t_on       = -1;
+    int64_t     t_off      = -1;
+    int64_t     t_release  = -1;    // dispatcher ajossa vaiheen jälkeen
+    int64_t     meas_us    = -1;
+    std::string led_thread;
+};
+
+class TimelineBuilder {
+public:
+    explicit TimelineBuilder(std::string dispatcher = "dispatcher_thread");
+
+    void feed(const CtfEvent &ev);
+    // Sulkee avoimet välit viimeiseen aikaleimaan
+    void finish();
+
+    const std::vector<CommandPath> &commands() const { return cmds_; }
+    const std::string &dispatcher() const { return disp_name_; }
+
+    // Säikeen tilojen osuudet aikavälillä, suurin ensin
+    std::vector<WaitShare> breakdown(const std::string &thread, int64_t t0, int64_t t1) const;
+    // Muiden säikeiden ajoaika aikavälillä, suurin ensin
+    std::vector<WaitShare> running(int64_t t0, int64_t t1, const std::string &except = {}) const;
+    int switches(int64_t t0, int64_t t1) const;
+
+    // Firmwaren drop- ja fifo_hwm-tapahtumat (src/drops.h): syy/jono -> viimeisin arvo
+    const std::map<uint32_t, uint32_t> &drops() const { return drops_; }
+    const std::map<uint32_t, uint32_t> &fifo_hwm() const { return hwm_; }
+
+private:
+    struct ThreadTrack {
+        std::vector<Interval>    iv;
+        std::vector<std::string> ops;       // avoimet kernel-kutsut (enter..exit)
+        bool                     pended = false;
+        bool                     open   = false;
+    };
+    void open_state(const std::string &th, ThreadState st, std::string op, int64_t t);
+    void on_named(const CtfEvent &ev);
+
+    std::string disp_name_;
+    std::map<std::string, ThreadTrack> threads_;
+    std::string cur_;
+    int         isr_depth_ = 0;
+    int64_t     last_t_    = 0;
+    std::vector<int64_t> switch_t_;
+
+    std::vector<CommandPath> cmds_;
+    std::map<uint32_t, std::vector<size_t>> queued_;   // id -> dispatchaamattomat
+    long active_ = -1;                                 // viimeksi dispatchattu
+    std::map<uint32_t, uint32_t> drops_;
+    std::map<uint32_t, uint32_t> hwm_;
+};
+
+const char *state_name(ThreadState s);
+// enum drop_cause / enum fifo_id -nimet (LIIKENNEVALOT/src/drops.h)
+const char *drop_cause_name(uint32_t cause);
+const char *fifo_name(uint32_t q);
+// Komennon raportti (useita rivejä)
+std::string format_command(const TimelineBuilder &tl, const CommandPath &c, size_t index);
+
+#endif
@@ -0,0 +1,70 @@
+// traceview: komentojen aikajana Zephyrin CTF-jäljestä.
+//
+//   babeltrace2 ctf/ | traceview [--dispatcher NAME] [--slowest N]
+//   traceview trace.txt
+//
+// Firmware käännetään overlay-tracing.conf:lla (LIIKENNEVALOT/). Jokaisesta
+// komennosta tulostetaan vaiheet (jono, handoff, vaihe, release),
+// kontekstinvaihdot ja mihin dispatcher / LED-taski odotti.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include "TraceView.h"
+
+static void usage(const char *prog) {
+    std::fprintf(stderr, "usage: %s [trace.txt|-] [--dispatcher NAME] [--slowest N]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    std::string path = "-";
+    std::string disp = "dispatcher_thread";
+    int slowest = 0;
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        if      (!std::strcmp(a, "--dispatcher") && i + 1 < argc) disp = argv[++i];
+        else if (!std::strcmp(a, "--slowest") && i + 1 < argc)    slowest = std::atoi(argv[++i]);
+        else if (a[0] != '-' || !std::strcmp(a, "-"))            path = a;
+        else { usage(argv[0]); return 2; }
+    }
+
+    std::ifstream f;
+    if (path != "-") {
+        f.open(path);
+        if (!f) { std::perror(path.c_str()); return 1; }
+    }
+    std::istream &in = path == "-" ? std::cin : f;
+
+    TimelineBuilder tl(disp);
+    std::string line;
+    CtfEvent ev;
+    long events = 0;
+    while (std::getline(in, line)) {
+        if (!parse_babeltrace_line(line, ev)) continue;
+        tl.feed(ev);
+        ++events;
+    }
+    tl.finish();
+
+    const auto &cmds = tl.commands();
+    std::vector<size_t> order(cmds.size());
+    std::iota(order.begin(), order.end(), 0);
+    // --slowest N: pisimmän input -> GPIO on -viiveen komennot
+    if (slowest > 0) {
+        auto lat = [&](size_t i) { return cmds[i].t_on >= 0 ? cmds[i].t_on - cmds[i].t_in : -1; };
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return lat(a) > lat(b); });
+        if ((size_t)slowest < order.size()) order.resize((size_t)slowest);
+    }
+
+    std::printf("%ld events, %zu commands\n\n", events, cmds.size());
+    for (size_t i : order) std::printf("%s\n", format_command(tl, cmds[i], i).c_str());
+
+    // hukatut tapahtumat ja jonojen huiput: backlog vai hävikki?
+    for (const auto &d : tl.drops())    std::printf("drop %-14s %u\n", drop_cause_name(d.first), d.second);
+    for (const auto &h : tl.fifo_hwm()) std::printf("hwm  %-14s %u\n", fifo_name(h.first), h.second);
+    return cmds.empty() ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include "FloodGen.h"
+
+static const char COLORS[] = { 'R', 'Y', 'G' };
+// Ei 'A' eikä 'D': ne muuttaisivat firmwaren tilaa
+static const char BAD_CHARS[] = { 'Q', 'Z', '#', '?' };
+
+std::vector<FloodCmd> flood_generate(const FloodConfig &cfg) {
+    std::vector<FloodCmd> out;
+    if (cfg.count <= 0 || cfg.rate_hz <= 0.0) return out;
+    out.reserve((size_t)cfg.count);
+
+    std::mt19937 rng(cfg.seed);
+    std::uniform_real_distribution<double> u01(0.0, 1.0);
+    std::uniform_int_distribution<int> col(0, 2);
+
+    const int burst = std::max(1, cfg.burst);
+    // purskeiden väli niin että keskitahti pysyy rate_hz:ssa
+    const double gap_us = 1e6 * (double)burst / cfg.rate_hz;
+
+    for (int i = 0; i < cfg.count; ++i) {
+        FloodCmd c;
+        c.t_us    = (int64_t)std::llround(gap_us * (double)(i / burst));
+        c.color   = 0;
+        c.delay_s = 0;
+
+        double r = u01(rng);
+        if (r < cfg.error_ratio) {
+            if (u01(rng) < 0.5) {
+                c.kind = CmdKind::BadChar;
+                c.text = std::string(1, BAD_CHARS[rng() % sizeof(BAD_CHARS)]);
+            } else {
+                // tunti 24..99 -> TIME_VALUE_ERROR
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "A%02u0000", 24u + (unsigned)(rng() % 76));
+                c.kind = CmdKind::BadTime;
+                c.text = buf;
+            }
+        } else if (r < cfg.error_ratio + cfg.timed_ratio) {
+            int s = 1 + (int)(rng() % (unsigned)std::max(1, cfg.timed_max_s));
+            // kello on 00:00:00 ajon alussa -> kellonaika = lähetyshetki + s
+            int at = (int)((c.t_us / 1000000 + s) % 86400);
+            char buf[16];
+            std::snprintf(buf, sizeof(buf), "A%02d%02d%02d", at / 3600, at / 60 % 60, at % 60);
+            c.kind    = CmdKind::Timed;
+            c.delay_s = s;
+            c.text    = buf;
+        } else {
+            c.kind  = CmdKind::Color;
+            c.color = COLORS[col(rng)];
+            c.text  = std::string(1, c.color);
+        }
+        out.push_back(std::move(c));
+    }
+    return out;
+}
+
+int64_t LatencyStats::percentile(double p) const {
+    if (samples_.empty()) return 0;
+    std::vector<int64_t> s(samples_);
+    size_t rank = (size_t)std::ceil(p / 100.0 * (double)s.size());
+    if (rank > 0) rank--;
+    if (rank >= s.size()) rank = s.size() - 1;
+    std::nth_element(s.begin(), s.begin() + (long)rank, s.end());
+    return s[rank];
+}
+
+int64_t LatencyStats::max() const {
+    if (samples_.empty()) return 0;
+    return *std::max_element(samples_.begin(), samples_.end());
+}
+
+static bool starts_with(std::string_view s, std::string_view p) {
+    return s.size() >= p.size() && s.compare(0, p.size(), p) == 0;
+}
+
+// "RED" / "YELLOW" / "GREEN" -> 'R'/'Y'/'G'
+static char color_word(std::string_view w) {
+    if (starts_with(w, "RED"))    return 'R';
+    if (starts_with(w, "YELLOW")) return 'Y';
+    if (starts_with(w, "GREEN"))  return 'G';
+    return 0;
+}
+
+void FloodMatcher::on_send(const FloodCmd &cmd, int64_t t_us) {
+    rep_.sent++;
+    switch (cmd.kind) {
+    case CmdKind::Color:
+        last_color_ = cmd.color;
+        pending_.push_back({ cmd.color, t_us, true });
+        rep_.expected++;
+        break;
+    case CmdKind::Timed: {
+        // laukaisu kellonaikaan timer_colorilla; sama aika ja väri uudestaan ei lisää toista
+        const char *d = cmd.text.c_str() + 1;
+        int64_t at = ((d[0] - '0') * 10 + (d[1] - '0')) * 3600 + ((d[2] - '0') * 10 + (d[3] - '0')) * 60 +
+                     (d[4] - '0') * 10 + (d[5] - '0');
+        Timer tm{ at * 1000000, last_color_ };
+        auto pos = std::upper_bound(timers_.begin(), timers_.end(), tm.due_us,
+                                    [](int64_t due, const Timer &x) { return due < x.due_us; });
+        bool dup = std::any_of(timers_.begin(), pos, [&tm](const Timer &x) {
+            return x.due_us == tm.due_us && x.color == tm.color;
+        });
+        if (!dup) {
+            timers_.insert(pos, tm);
+            rep_.expected++;
+        }
+        timed_wait_.push_back({ !dup, tm });
+        break;
+    }
+    case CmdKind::BadChar:
+    case CmdKind::BadTime:
+        rep_.errors_sent++;
+        break;
+    }
+}
+
+void FloodMatcher::match_color(char color, int64_t t_us) {
+    auto it = std::find_if(pending_.begin(), pending_.end(),
+                           [color](const Pending &p) { return p.color == color; });
+    if (it == pending_.end()) {
+        rep_.unmatched_lines++;
+        return;
+    }
+    rep_.dropped += (long)std::distance(pending_.begin(), it);
+    if (it->measured) {
+        rep_.matched++;
+        lat_.add(t_us - it->t_us);
+    }
+    pending_.erase(pending_.begin(), it + 1);
+}
+
+// Vanhimman vastaamattoman A-komennon tulos; hylätty ei ole odotettu
+void FloodMatcher::timed_verdict(bool accepted) {
+    if (timed_wait_.empty()) return;
+    TimedSent ts = timed_wait_.front();
+    timed_wait_.pop_front();
+    if (accepted || !ts.added) return;
+    auto it = std::find_if(timers_.begin(), timers_.end(), [&ts](const Timer &x) {
+        return x.due_us == ts.tm.due_us && x.color == ts.tm.color;
+    });
+    if (it != timers_.end()) {
+        timers_.erase(it);
+        rep_.expected--;
+    }
+}
+
+void FloodMatcher::on_line(std::string_view line, int64_t t_us) {
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) line.remove_suffix(1);
+
+    if (starts_with(line, "TIMER -> ") && line.size() > 9) {
+        char c = line[9];
+        auto it = std::find_if(timers_.begin(), timers_.end(), [c](const Timer &x) { return x.color == c; });
+        if (it != timers_.end()) {
+            rep_.matched++;
+            lat_.add(std::max<int64_t>(0, t_us - it->due_us));
+            timers_.erase(it);
+        } else {
+            rep_.unmatched_lines++;
+        }
+        // ajastin laittoi värin seq_fifoon, sen dispatch ei ole oma komento
+        pending_.push_back({ c, t_us, false });
+        return;
+    }
+    if (starts_with(line, "Invalid time")) {
+        rep_.rejected++;
+        return;
+    }
+    // A-komennon vastaus: "WALL HH:MM:SS -> X" (debug) / ei asetettu / lista täynnä
+    if (starts_with(line, "WALL clock not set") || starts_with(line, "WALL trigger list full")) {
+        rep_.rejected++;
+        timed_verdict(false);
+        return;
+    }
+    if (starts_with(line, "WALL ") && line.size() > 5 && line[5] >= '0' && line[5] <= '9') {
+        timed_verdict(true);
+        return;
+    }
+    if (mode_ == MatchMode::Dispatch) {
+        if (starts_with(line, "Dispatch -> ")) {
+            char c = color_word(line.substr(12));
+            if (c) match_color(c, t_us);
+        }
+    } else {
+        size_t sp = line.find(' ');
+        if (sp != std::string_view::npos && line.substr(sp) == " ON") {
+            char c = color_word(line.substr(0, sp));
+            if (c) match_color(c, t_us);
+        }
+    }
+}
+
+FloodReport FloodMatcher::finish(int64_t t_us) {
+    for (const Pending &p : pending_) {
+        if (p.measured) rep_.dropped++;
+    }
+    pending_.clear();
+    rep_.dropped += (long)timers_.size();
+    timers_.clear();
+    timed_wait_.clear();
+    rep_.elapsed_s  = (double)t_us / 1e6;
+    rep_.throughput = rep_.elapsed_s > 0.0 ? (double)rep_.matched / rep_.elapsed_s : 0.0;
+    rep_.p50_us     = lat_.percentile(50.0);
+    rep_.p99_us     = lat_.percentile(99.0);
+    rep_.max_us     = lat_.max();
+    return rep_;
+}
@@ -0,0 +1,113 @@
+#ifndef FLOODGEN_H
+#define FLOODGEN_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Kuormitusgeneraattori uart_task -> seq_fifo -> dispatcher_task -putkelle.
+// Ajat mikrosekunteina ajon alusta.
+
+enum class CmdKind {
+    Color,      // R/Y/G -> odotetaan "Dispatch -> X"
+    Timed,      // A+HHMMSS (kellonaika, kello synkattu C000000:lla ajon alussa)
+                // -> odotetaan "TIMER -> X"
+    BadChar,    // tuntematon merkki, firmware hylkää hiljaa
+    BadTime,    // A+virheellinen aika, firmware: "Invalid time"
+};
+
+struct FloodCmd {
+    int64_t     t_us;       // suunniteltu lähetysaika
+    CmdKind     kind;
+    char        color;      // 'R','Y','G' tai 0
+    int         delay_s;    // Timed: laukaisun etäisyys lähetyksestä
+    std::string text;       // lähetettävät tavut
+};
+
+struct FloodConfig {
+    double   rate_hz     = 2.0;   // keskimääräinen komentotahti
+    int      burst       = 1;     // komentoja per purske (lähetetään peräkkäin)
+    int      count       = 100;
+    double   error_ratio = 0.0;   // osuus virheellisiä komentoja
+    double   timed_ratio = 0.0;   // osuus A+HHMMSS-komentoja
+    int      timed_max_s = 3;     // ajastimen viiveen yläraja
+    uint32_t seed        = 1;
+};
+
+// Deterministinen: sama seed -> sama komentovirta
+std::vector<FloodCmd> flood_generate(const FloodConfig &cfg);
+
+// Mitä firmwaren rivejä käytetään vastineena
+enum class MatchMode {
+    Dispatch,   // "Dispatch -> RED"
+    LedOn,      // "RED ON" (debug_task, GPIO-siirtymä)
+};
+
+struct FloodReport {
+    long     sent        = 0;
+    long     expected    = 0;   // komennot joille odotetaan vastinetta
+    long     matched     = 0;
+    long     dropped     = 0;
+    long     errors_sent = 0;
+    long     rejected    = 0;   // "Invalid time" / "WALL clock not set" / "WALL trigger list full"
+    long     unmatched_lines = 0;
+    double   elapsed_s   = 0.0;
+    double   throughput  = 0.0; // matched / s
+    int64_t  p50_us      = 0;
+    int64_t  p99_us      = 0;
+    int64_t  max_us      = 0;
+};
+
+// Latenssijakauma, persentiilit lähimmän sijan menetelmällä
+class LatencyStats {
+public:
+    void add(int64_t us) { samples_.push_back(us); }
+    size_t size() const { return samples_.size(); }
+    int64_t percentile(double p) const;
+    int64_t max() const;
+private:
+    std::vector<int64_t> samples_;
+};
+
+// Yhdistää firmwaren tulosterivit lähetettyihin komentoihin.
+// seq_fifo on FIFO, joten saman värin ensimmäinen odottava on vastine ja
+// kaikki sitä ennen jonossa olleet on pudotettu.
+class FloodMatcher {
+public:
+    explicit FloodMatcher(MatchMode mode = MatchMode::Dispatch) : mode_(mode) {}
+
+    void on_send(const FloodCmd &cmd, int64_t t_us);
+    void on_line(std::string_view line, int64_t t_us);
+    FloodReport finish(int64_t t_us);
+
+private:
+    struct Pending {
+        char    color;
+        int64_t t_us;
+        bool    measured;   // ajastimen tuottama dispatch ei ole oma komento
+    };
+    struct Timer {
+        int64_t due_us;     // kellonaika ajon alusta
+        char    color;
+    };
+
+    void match_color(char color, int64_t t_us);
+    void timed_verdict(bool accepted);
+
+    MatchMode           mode_;
+    std::deque<Pending> pending_;
+    std::vector<Timer>  timers_;            // laukaisujärjestyksessä
+    // A-komennot lähetysjärjestyksessä, kunnes firmware vastaa "WALL .." -rivillä
+    struct TimedSent {
+        bool  added;        // lisättiin timers_:iin (ei duplikaatti)
+        Timer tm;
+    };
+    std::deque<TimedSent> timed_wait_;
+    char                last_color_ = 'R';  // firmwaren timer_color
+    LatencyStats        lat_;
+    FloodReport         rep_;
+};
+
+#endif
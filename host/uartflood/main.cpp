@@ -0,0 +1,134 @@
+// uartflood: toistettava ylikuormitustesti firmwaren komento-UARTille.
+//
+//   uartflood <tty|pty> [--rate HZ] [--burst N] [--count N] [--errors P]
+//             [--timed P] [--seed S] [--match dispatch|on] [--drain-ms MS]
+//             [--baud B]
+//
+// Firmwaren debug-tulosteiden pitää olla päällä (dbg_on), koska vastineet
+// haetaan "Dispatch -> X" / "X ON" / "TIMER -> X" -riveistä. A-komennot
+// ovat kellonaikoja ja toistuvat päivittäin: laukaisut tyhjennetään (A.)
+// ennen kellon asetusta (C000000) ja ajon lopussa, muuten edellisen ajon
+// laukaisut täyttäisivät firmwaren listan ja laukeaisivat tämän ajon aikana.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "FloodGen.h"
+#include "SerialPort.h"
+
+using Clock = std::chrono::steady_clock;
+
+static void usage(const char *prog) {
+    std::fprintf(stderr,
+        "usage: %s <tty> [--rate HZ] [--burst N] [--count N] [--errors P]\n"
+        "          [--timed P] [--seed S] [--match dispatch|on] [--drain-ms MS] [--baud B]\n",
+        prog);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) { usage(argv[0]); return 2; }
+
+    std::string path = argv[1];
+    FloodConfig cfg;
+    MatchMode mode = MatchMode::Dispatch;
+    int drain_ms = 5000;
+    int baud = 115200;
+
+    for (int i = 2; i < argc; ++i) {
+        const char *a = argv[i];
+        const char *v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!v) { usage(argv[0]); return 2; }
+        if      (!std::strcmp(a, "--rate"))     cfg.rate_hz     = std::atof(v);
+        else if (!std::strcmp(a, "--burst"))    cfg.burst       = std::atoi(v);
+        else if (!std::strcmp(a, "--count"))    cfg.count       = std::atoi(v);
+        else if (!std::strcmp(a, "--errors"))   cfg.error_ratio = std::atof(v);
+        else if (!std::strcmp(a, "--timed"))    cfg.timed_ratio = std::atof(v);
+        else if (!std::strcmp(a, "--seed"))     cfg.seed        = (uint32_t)std::strtoul(v, nullptr, 0);
+        else if (!std::strcmp(a, "--drain-ms")) drain_ms        = std::atoi(v);
+        else if (!std::strcmp(a, "--baud"))     baud            = std::atoi(v);
+        else if (!std::strcmp(a, "--match"))    mode = !std::strcmp(v, "on") ? MatchMode::LedOn
+                                                                            : MatchMode::Dispatch;
+        else { usage(argv[0]); return 2; }
+        ++i;
+    }
+
+    SerialPort port;
+    if (!port.open(path, baud)) {
+        std::perror(path.c_str());
+        return 1;
+    }
+
+    std::vector<FloodCmd> cmds = flood_generate(cfg);
+    FloodMatcher matcher(mode);
+
+    static const char clear[] = "A.\n";
+    static const char sync[] = "C000000\n";
+    if (!port.write_all(clear, sizeof(clear) - 1) ||
+        (cfg.timed_ratio > 0.0 && !port.write_all(sync, sizeof(sync) - 1))) {
+        std::perror("write");
+        return 1;
+    }
+
+    const Clock::time_point t0 = Clock::now();
+    auto now_us = [&t0]() {
+        return (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - t0).count();
+    };
+
+    std::string line;
+    char rx[256];
+    size_t next = 0;
+    int64_t drain_end = -1;
+
+    while (true) {
+        int64_t t = now_us();
+
+        // kaikki erääntyneet komennot kerralla (purske)
+        while (next < cmds.size() && cmds[next].t_us <= t) {
+            const FloodCmd &c = cmds[next++];
+            int64_t ts = now_us();
+            if (!port.write_all(c.text.data(), c.text.size())) {
+                std::perror("write");
+                return 1;
+            }
+            matcher.on_send(c, ts);
+        }
+        if (next == cmds.size() && drain_end < 0) drain_end = now_us() + (int64_t)drain_ms * 1000;
+        if (drain_end >= 0 && now_us() >= drain_end) break;
+
+        int wait_ms = 50;
+        if (next < cmds.size()) {
+            int64_t dt = cmds[next].t_us - now_us();
+            wait_ms = dt <= 0 ? 0 : (int)std::min<int64_t>(50, (dt + 999) / 1000);
+        }
+        long n = port.read_some(rx, sizeof(rx), wait_ms);
+        if (n < 0) {
+            std::fprintf(stderr, "%s: link closed\n", path.c_str());
+            break;
+        }
+        int64_t tr = now_us();
+        for (long k = 0; k < n; ++k) {
+            if (rx[k] == '\n') {
+                matcher.on_line(line, tr);
+                line.clear();
+            } else {
+                line.push_back(rx[k]);
+            }
+        }
+    }
+
+    FloodReport r = matcher.finish(now_us());
+    if (!port.write_all(clear, sizeof(clear) - 1)) std::perror("write");
+    std::printf("sent        %ld (errors %ld, rejected %ld)\n", r.sent, r.errors_sent, r.rejected);
+    std::printf("expected    %ld\n", r.expected);
+    std::printf("matched     %ld\n", r.matched);
+    std::printf("dropped     %ld\n", r.dropped);
+    std::printf("unmatched   %ld lines\n", r.unmatched_lines);
+    std::printf("elapsed     %.3f s\n", r.elapsed_s);
+    std::printf("throughput  %.2f cmd/s\n", r.throughput);
+    std::printf("latency     p50 %lld us  p99 %lld us  max %lld us\n",
+                (long long)r.p50_us, (long long)r.p99_us, (long long)r.max_us);
+    return r.dropped ? 3 : 0;
+}
@@ -0,0 +1,133 @@
+#include "CommandParser.h"
+
+namespace {
+
+// Merkkiluokat, yksi tavu per merkki
+enum : uint8_t {
+    CC_BAD = 0,
+    CC_SEP,
+    CC_EOL,
+    CC_COLOR,
+    CC_DIGIT,
+    CC_TIME,
+    CC_PRIO,
+    CC_EMERG,
+    CC_DEBUG,
+    CC_QUERY,
+};
+
+struct CharTable {
+    uint8_t cls[256];
+    char    up[256];    // kanoninen (iso) kirjain
+};
+
+constexpr CharTable make_table() {
+    CharTable t{};
+    for (int c = 0; c < 256; ++c) {
+        t.cls[c] = CC_BAD;
+        t.up[c]  = (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : (char)c;
+    }
+    t.cls[(uint8_t)' ']  = CC_SEP;
+    t.cls[(uint8_t)'\t'] = CC_SEP;
+    t.cls[(uint8_t)',']  = CC_SEP;
+    t.cls[(uint8_t)';']  = CC_SEP;
+    t.cls[0]             = CC_EOL;
+    t.cls[(uint8_t)'\r'] = CC_EOL;
+    t.cls[(uint8_t)'\n'] = CC_EOL;
+    for (int c = '0'; c <= '9'; ++c) t.cls[c] = CC_DIGIT;
+    for (const char *p = "RYGryg"; *p; ++p) t.cls[(uint8_t)*p] = CC_COLOR;
+    t.cls[(uint8_t)'A'] = t.cls[(uint8_t)'a'] = CC_TIME;
+    t.cls[(uint8_t)'X'] = t.cls[(uint8_t)'x'] = CC_EMERG;
+    t.cls[(uint8_t)'D'] = t.cls[(uint8_t)'d'] = CC_DEBUG;
+    t.cls[(uint8_t)'S'] = t.cls[(uint8_t)'s'] = CC_QUERY;
+    t.cls[(uint8_t)'M'] = t.cls[(uint8_t)'m'] = CC_QUERY;
+    t.cls[(uint8_t)'!'] = CC_PRIO;
+    return t;
+}
+
+constexpr CharTable TABLE = make_table();
+
+inline uint8_t cls_of(char c) { return TABLE.cls[(uint8_t)c]; }
+inline char    up_of(char c)  { return TABLE.up[(uint8_t)c]; }
+
+inline int two_digits(const char *p) {
+    return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+} // namespace
+
+extern "C" int cmd_parse(const char *line, size_t len, struct cmd_list *out) {
+    out->count = 0;
+    out->error_pos = -1;
+    if (line == nullptr) {
+        out->error_pos = 0;
+        return COMMAND_ERROR;
+    }
+
+    size_t i = 0;
+    int err = COMMAND_OK;
+
+    while (i < len) {
+        const char c = line[i];
+        const uint8_t cls = cls_of(c);
+
+        if (cls == CC_SEP) { ++i; continue; }
+        if (cls == CC_EOL) break;
+
+        if (out->count == CMD_MAX_PER_LINE) { err = COMMAND_ERROR; break; }
+        struct cmd_record *r = &out->cmd[out->count];
+        r->pos = (uint16_t)i;
+        r->seconds = 0;
+
+        switch (cls) {
+        case CC_COLOR:
+            r->type  = CMD_COLOR;
+            r->color = up_of(c);
+            i += 1;
+            break;
+        case CC_EMERG:
+            r->type  = CMD_PRIO;
+            r->color = 'R';
+            i += 1;
+            break;
+        case CC_PRIO:
+            if (i + 1 >= len || cls_of(line[i + 1]) != CC_COLOR) { err = COLOR_ERROR; break; }
+            r->type  = CMD_PRIO;
+            r->color = up_of(line[i + 1]);
+            i += 2;
+            break;
+        case CC_DEBUG:
+            r->type  = CMD_DEBUG;
+            r->color = 'D';
+            i += 1;
+            break;
+        case CC_QUERY:
+            r->type  = CMD_QUERY;
+            r->color = up_of(c);
+            i += 1;
+            break;
+        case CC_TIME: {
+            // tasan 6 numeroa, seitsemäs ei saa olla numero
+            const char *d = line + i + 1;
+            size_t n = 0;
+            while (n < 7 && i + 1 + n < len && cls_of(d[n]) == CC_DIGIT) ++n;
+            if (n != 6) { err = TIME_ERROR; break; }
+            int hh = two_digits(d), mm = two_digits(d + 2), ss = two_digits(d + 4);
+            if (hh > 23 || mm > 59 || ss > 59) { err = TIME_ERROR; break; }
+            r->type    = CMD_TIMED;
+            r->color   = 'A';
+            r->seconds = hh * 3600 + mm * 60 + ss;
+            i += 7;
+            break;
+        }
+        default:
+            err = COMMAND_ERROR;
+            break;
+        }
+        if (err != COMMAND_OK) break;
+        out->count++;
+    }
+
+    if (err != COMMAND_OK) out->error_pos = (int)i;
+    return err;
+}
@@ -0,0 +1,60 @@
+#ifndef COMMANDPARSER_H
+#define COMMANDPARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Rivikomentojen parseri: host-työkalut (hostctl LightController::send_line)
+// ja RTOS_main_example. LIIKENNEVALOT jäsentää UARTin tavu kerrallaan
+// omalla tilakoneellaan (uart_handle_ascii), samoilla komentomerkeillä.
+// Rivi: komentoja peräkkäin, erottimena välilyönti / ',' / ';' (tai ei mitään)
+//   R Y G      väri seq-jonoon
+//   !R !Y !G   väri prioriteettikaistaan, X = hätä-punainen
+//   AHHMMSS    ajastin, sekunnit time_parse-säännöin
+//   D          debug toggle
+//   S M        tilastot / deadline-raportti
+// Isot ja pienet kirjaimet käyvät. Parsitaan paikallaan, ei kopiointia.
+
+// Error codes (sama numerointi kuin RTOS_main_example)
+#define COMMAND_OK      0
+#define COLOR_ERROR     1
+#define TIME_ERROR      2
+#define COMMAND_ERROR   3
+
+#define CMD_MAX_PER_LINE 16
+
+enum cmd_type {
+    CMD_COLOR = 1,
+    CMD_PRIO,       // prioriteettikaistan väri
+    CMD_TIMED,
+    CMD_DEBUG,
+    CMD_QUERY,      // color = 'S' tai 'M'
+};
+
+struct cmd_record {
+    uint8_t  type;      // enum cmd_type
+    char     color;     // 'R','Y','G' (CMD_QUERY: 'S','M')
+    uint16_t pos;       // komennon alku rivillä
+    int32_t  seconds;   // CMD_TIMED
+};
+
+struct cmd_list {
+    struct cmd_record cmd[CMD_MAX_PER_LINE];
+    int count;
+    int error_pos;      // ensimmäisen virheen kohta, -1 jos ok
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Parsii len merkkiä (rivi voi päättyä myös '\0', '\r' tai '\n' -merkkiin).
+// Palauttaa COMMAND_OK tai ensimmäisen virheen koodin; virhettä edeltävät
+// komennot jäävät out:iin.
+int cmd_parse(const char *line, size_t len, struct cmd_list *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
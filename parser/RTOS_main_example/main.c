@@ -2,19 +2,18 @@
 #include <zephyr/sys/printk.h>
 #include <zephyr/device.h>
 #include <zephyr/drivers/uart.h>
+#include "../CommandParser.h"   // build CommandParser.cpp into the app (CONFIG_CPP=y)
 
 // UART initialization
 #define UART_DEVICE_NODE DT_CHOSEN(zephyr_shell_uart)
 static const struct device *const uart_dev = DEVICE_DT_GET(UART_DEVICE_NODE);
 
-// error codes
-#define COLOR_ERROR		1
-#define TIME_ERROR		2
-#define COMMAND_ERROR	3
-#define COMMAND_OK		0
+// error codes: COMMAND_OK, COLOR_ERROR, TIME_ERROR, COMMAND_ERROR (CommandParser.h)
+
+#define CMD_LINE_MAX 64
 
 // Parser
-int parser(char *command);
+int parser(const char *command, int len, struct cmd_list *out);
 
 int main(void)
 {
@@ -32,38 +31,40 @@ int main(void)
 	// UART helpers
 	char c=0;
 	int cnt = 0;
-	char buffer[16];
+	bool overflow = false;
+	char buffer[CMD_LINE_MAX];
+	struct cmd_list cmds;
 
 	// superloop
 	while (true) {
 
 		if (uart_poll_in(uart_dev,&c) == 0) {
 			if (c == '\n' || c == '\r') {
-				// printk(buffer);
-				// here you call parser
-				int ret = parser(buffer);
+				// here you call parser (parses buffer in place, no copy)
+				int ret = overflow ? COMMAND_ERROR : parser(buffer, cnt, &cmds);
 				// check parser return value
 				if (ret == COMMAND_OK) {
-					// send signal / message to mailbox
-				} 
-				// clear buffer and counter
+					// send signal / message to mailbox, one per cmds.cmd[i]
+				} else {
+					printk("Command error %d at %d\r\n", ret, overflow ? cnt : cmds.error_pos);
+				}
+				// only the counter is reset, parser never reads past cnt
 				cnt = 0;
-				memset(buffer,0,16);
-			} else {
+				overflow = false;
+			} else if (cnt < CMD_LINE_MAX) {
 				// add received character to buffer
 				buffer[cnt] = c;
 				cnt++;
+			} else {
+				// too long line is rejected as a whole
+				overflow = true;
 			}
 		}
 	}
 	return 0;
 }
 
-int parser(char *command) {
-	int ret = COMMAND_OK;
-
-	// add your own code from googletest here!!
-	// to check the buffer for correct sequence
-	
-	return ret;
+int parser(const char *command, int len, struct cmd_list *out) {
+	// same table-driven parser as googletest cases (parser/test_cases)
+	return cmd_parse(command, (size_t)len, out);
 }
@@ -0,0 +1,52 @@
+// Parserin läpäisymittaus: CommandParserBench [rivit] [kierrokset]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "CommandParser.h"
+
+static const char *const TOKENS[] = {
+    "R", "Y", "G", "r", "g", "!R", "X", "D", "A000010", "A123059", "S",
+};
+
+int main(int argc, char **argv) {
+    const int lines  = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    // valmiit rivit yhteen puskuriin, kuten UART-vastaanotossa
+    std::mt19937 rng(1);
+    std::string buf;
+    std::vector<std::pair<size_t, size_t>> spans;
+    for (int i = 0; i < lines; ++i) {
+        size_t start = buf.size();
+        int n = 1 + (int)(rng() % 8);
+        for (int k = 0; k < n; ++k) {
+            if (k) buf.push_back(rng() % 2 ? ' ' : ',');
+            buf += TOKENS[rng() % (sizeof(TOKENS) / sizeof(TOKENS[0]))];
+        }
+        spans.push_back({ start, buf.size() - start });
+        buf += "\r\n";
+    }
+
+    cmd_list out;
+    long cmds = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto &s : spans) {
+            cmd_parse(buf.data() + s.first, s.second, &out);
+            cmds += out.count;
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    double sec   = std::chrono::duration<double>(t1 - t0).count();
+    double bytes = (double)buf.size() * rounds;
+    std::printf("lines     %d x %d\n", lines, rounds);
+    std::printf("commands  %ld\n", cmds);
+    std::printf("time      %.3f s\n", sec);
+    std::printf("rate      %.1f Mlines/s  %.1f Mcmd/s  %.1f MB/s\n",
+                (double)lines * rounds / sec / 1e6, (double)cmds / sec / 1e6, bytes / sec / 1e6);
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <string.h>
+#include "../CommandParser.h"
+
+static int parse(const char *s, cmd_list *out) {
+    return cmd_parse(s, strlen(s), out);
+}
+
+TEST(CommandParserTest, TestNullPointer) {
+    cmd_list l;
+    EXPECT_EQ(cmd_parse(nullptr, 5, &l), COMMAND_ERROR);
+    EXPECT_EQ(l.count, 0);
+}
+
+TEST(CommandParserTest, TestEmptyLine) {
+    cmd_list l;
+    EXPECT_EQ(parse("", &l), COMMAND_OK);
+    EXPECT_EQ(parse("\r\n", &l), COMMAND_OK);
+    EXPECT_EQ(l.count, 0);
+}
+
+TEST(CommandParserTest, TestColors) {
+    cmd_list l;
+    ASSERT_EQ(parse("R,y G", &l), COMMAND_OK);
+    ASSERT_EQ(l.count, 3);
+    EXPECT_EQ(l.cmd[0].type, CMD_COLOR); EXPECT_EQ(l.cmd[0].color, 'R');
+    EXPECT_EQ(l.cmd[1].color, 'Y');      EXPECT_EQ(l.cmd[1].pos, 2);
+    EXPECT_EQ(l.cmd[2].color, 'G');
+}
+
+TEST(CommandParserTest, TestManyWithoutSeparators) {    // kuten firmwaren merkkivirta
+    cmd_list l;
+    ASSERT_EQ(parse("RYGA000010D", &l), COMMAND_OK);
+    ASSERT_EQ(l.count, 5);
+    EXPECT_EQ(l.cmd[3].type, CMD_TIMED);
+    EXPECT_EQ(l.cmd[3].seconds, 10);
+    EXPECT_EQ(l.cmd[4].type, CMD_DEBUG);
+}
+
+TEST(CommandParserTest, TestTimedUpperBoundary) {
+    cmd_list l;
+    ASSERT_EQ(parse("a235959", &l), COMMAND_OK);
+    EXPECT_EQ(l.cmd[0].seconds, 23*3600 + 59*60 + 59);
+}
+
+TEST(CommandParserTest, TestTimedValueErrors) {
+    cmd_list l;
+    EXPECT_EQ(parse("A240000", &l), TIME_ERROR);
+    EXPECT_EQ(parse("A126000", &l), TIME_ERROR);
+    EXPECT_EQ(parse("A120060", &l), TIME_ERROR);
+}
+
+TEST(CommandParserTest, TestTimedLength) {
+    cmd_list l;
+    EXPECT_EQ(parse("A12345", &l), TIME_ERROR);         // lyhyt
+    EXPECT_EQ(parse("A1234567", &l), TIME_ERROR);       // pitkä
+    EXPECT_EQ(parse("A12a045", &l), TIME_ERROR);
+    EXPECT_EQ(parse("A-10010", &l), TIME_ERROR);
+}
+
+TEST(CommandParserTest, TestLenIsRespected) {            // ei lueta puskurin yli
+    const char buf[] = "A000010";
+    cmd_list l;
+    EXPECT_EQ(cmd_parse(buf, 5, &l), TIME_ERROR);
+    EXPECT_EQ(cmd_parse(buf, 7, &l), COMMAND_OK);
+}
+
+TEST(CommandParserTest, TestPriority) {
+    cmd_list l;
+    ASSERT_EQ(parse("!g X", &l), COMMAND_OK);
+    ASSERT_EQ(l.count, 2);
+    EXPECT_EQ(l.cmd[0].type, CMD_PRIO); EXPECT_EQ(l.cmd[0].color, 'G');
+    EXPECT_EQ(l.cmd[1].type, CMD_PRIO); EXPECT_EQ(l.cmd[1].color, 'R');
+    EXPECT_EQ(parse("!Q", &l), COLOR_ERROR);
+    EXPECT_EQ(parse("R!", &l), COLOR_ERROR);
+}
+
+TEST(CommandParserTest, TestQueries) {
+    cmd_list l;
+    ASSERT_EQ(parse("s m", &l), COMMAND_OK);
+    EXPECT_EQ(l.cmd[0].type, CMD_QUERY); EXPECT_EQ(l.cmd[0].color, 'S');
+    EXPECT_EQ(l.cmd[1].color, 'M');
+}
+
+TEST(CommandParserTest, TestUnknownKeepsPrefix) {
+    cmd_list l;
+    EXPECT_EQ(parse("R Y Q G", &l), COMMAND_ERROR);
+    EXPECT_EQ(l.count, 2);
+    EXPECT_EQ(l.error_pos, 4);
+}
+
+TEST(CommandParserTest, TestStopsAtLineEnd) {
+    cmd_list l;
+    ASSERT_EQ(parse("R\nQQQ", &l), COMMAND_OK);
+    EXPECT_EQ(l.count, 1);
+}
+
+TEST(CommandParserTest, TestTooManyCommands) {
+    cmd_list l;
+    EXPECT_EQ(parse("RRRRRRRRRRRRRRRR", &l), COMMAND_OK);
+    EXPECT_EQ(l.count, CMD_MAX_PER_LINE);
+    EXPECT_EQ(parse("RRRRRRRRRRRRRRRRR", &l), COMMAND_ERROR);
+}
+
+TEST(CommandParserTest, TestHighBitChars) {
+    const char buf[] = { 'R', (char)0xE4, 'G' };
+    cmd_list l;
+    EXPECT_EQ(cmd_parse(buf, sizeof(buf), &l), COMMAND_ERROR);
+    EXPECT_EQ(l.count, 1);
+}